@@ -1,6 +1,20 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgLoudness.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
+
+// output limiter ceilings, off and then 0, -1 and -3 dB of 10 V
+const int LIMITER_SETTINGS = 4;
+const float LIMITER_CEILINGS[LIMITER_SETTINGS] = {10.f, 10.f, 8.9125f, 7.0795f};
+
+// scene morph times in seconds
+const int SCENE_MORPHS = 7;
+const float SCENE_MORPH_SECONDS[SCENE_MORPHS] = {0.f, 1.f, 2.f, 4.f, 8.f, 16.f, 32.f};
 
 struct BusDepot : Module {
 	enum ParamIds {
@@ -18,6 +32,7 @@ struct BusDepot : Module {
 		R_INPUT,
 		BUS_INPUT,
 		FADE_CV_INPUT,
+		SCENE_CV_INPUT,
 		NUM_INPUTS
 	};
 	enum OutputIds {
@@ -34,26 +49,33 @@ struct BusDepot : Module {
 	};
 
 	LongPressButton on_button;
-	dsp::VuMeter2 vu_meters[2];
-	dsp::ClockDivider housekeeping_divider;
-	dsp::ClockDivider vu_divider;
-	dsp::ClockDivider light_divider;
+	gtgMeter meter;
+	LoudnessMeter loudness;   // EBU R128 loudness of the stereo outputs
 	dsp::ClockDivider audition_divider;
 	dsp::SchmittTrigger on_cv_trigger;
 	AutoFader depot_fader;
 	SimpleSlewer level_smoother;
+	LookAheadLimiter limiter;
 
 	const int bypass_speed = 26;
 	const int level_speed = 26;   // for level cv filter
-	float peak_left = 0.f;
-	float peak_right = 0.f;
 	bool level_cv_filter = true;
 	int fade_cv_mode = 0;
 	bool auto_override = false;
 	bool auditioned = false;
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
 	int audition_mode = 0;
+	int fade_curve = FADE_CURVE_EXP;
+	int output_limiter = 0;   // 0 is off, or one of LIMITER_CEILINGS
+	bool limiter_running = false;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	int scene_morph = 0;   // one of SCENE_MORPH_SECONDS
+	int cv_scene = -1;   // scene picked by the scene cv, -1 until the first reading
+	BusLink bus_link;
 
 	BusDepot() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -68,28 +90,25 @@ struct BusDepot : Module {
 		configInput(R_INPUT, "Right");
 		configInput(BUS_INPUT, "Bus chain");
 		configInput(FADE_CV_INPUT, "Fade automation CV");
+		configInput(SCENE_CV_INPUT, "Scene recall CV, 1 V per scene");
 		configOutput(LEFT_OUTPUT, "Mixed left");
 		configOutput(RIGHT_OUTPUT, "Mixed right");
 		configOutput(BUS_OUTPUT, "Bus chain");
-		vu_meters[0].lambda = 25.f;
-		vu_meters[1].lambda = 25.f;
-		housekeeping_divider.setDivision(100000);
-		vu_divider.setDivision(32);
-		light_divider.setDivision(240);
 		audition_divider.setDivision(512);
 		depot_fader.setSpeed(26);
 		level_smoother.setSlewSpeed(level_speed);   // for level cv filter
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, AUX_PARAM, 2);   // aux and master levels, not the fade speeds
+		scene_memory.addFader(&depot_fader, [this](bool on) {setOnState(on);});
+		automation.addParams(this, LEVEL_PARAM, 1);   // master level
+		automation.addFader(&depot_fader, [this](bool on) {setOnState(on);});
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
-
-		// check default theme and reset vu meters
-		if (housekeeping_divider.process()) {
-			vu_meters[0].v = 0.f;
-			vu_meters[1].v = 0.f;
-		}
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
 
 		// on off button
 		switch (on_button.step(params[ON_PARAM])) {
@@ -97,8 +116,8 @@ struct BusDepot : Module {
 		case LongPressButton::NO_PRESS:
 			break;
 		case LongPressButton::SHORT_PRESS:
-			if (audition_depot) {
-				audition_depot = false;   // single click turns off auditions
+			if (auditions.isActive(AUDITION_DEPOT, audition_group)) {
+				auditions.stop(AUDITION_DEPOT, audition_group);   // single click turns off auditions
 			} else {
 				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
 					auto_override = true;
@@ -124,7 +143,7 @@ struct BusDepot : Module {
 			break;
 		case LongPressButton::LONG_PRESS:   // long press to audition
 
-			audition_depot = true;   // all depots to audition mode
+			auditions.start(AUDITION_DEPOT, audition_group);   // all depots in the group to audition mode
 
 			if (auditioned) {
 				auditioned = false;
@@ -142,95 +161,95 @@ struct BusDepot : Module {
 			break;
 		}
 
+		// scene cv recalls a scene in every module when it moves to another scene, the first reading only sets where it is
+		if (inputs[SCENE_CV_INPUT].isConnected()) {
+			int scene = clamp((int)std::round(inputs[SCENE_CV_INPUT].getVoltage()), 0, SCENES - 1);
+			if (scene != cv_scene) {
+				if (cv_scene >= 0) scenes.recall(scene, SCENE_MORPH_SECONDS[scene_morph]);
+				cv_scene = scene;
+			}
+		} else {
+			cv_scene = -1;
+		}
+
 		// process cv trigger
 		if (on_cv_trigger.process(inputs[ON_CV_INPUT].getVoltage())) {
-			if (!audition_depot) {
+			if (!auditions.isActive(AUDITION_DEPOT, audition_group)) {
 				auto_override = false;   // do not override automation
 				depot_fader.on = !depot_fader.on;
 			}
 		}
 
+		// fade speed cv every sample, so sequenced fades land on time
+		if (!auto_override && inputs[FADE_CV_INPUT].isConnected()) {
+			if (depot_fader.on ? (fade_cv_mode == 0 || fade_cv_mode == 1) : (fade_cv_mode == 0 || fade_cv_mode == 2)) {
+				depot_fader.modulateSpeed((clamp(inputs[FADE_CV_INPUT].getVoltage() * 0.1f, 0.0f, 1.0f) * 33974.f) + 26.f);   // 26 to 34000 milliseconds
+			}
+		}
+
 		depot_fader.process();
 
 		// process fade states and on light
 		if (audition_divider.process()) {
 
-			if (audition_depot) {   // all depots are in audition state
+			if (auditions.hasChanged(AUDITION_DEPOT, audition_group, audition_epoch)) {   // only when the group changes
+				if (auditions.isActive(AUDITION_DEPOT, audition_group)) {   // all depots are in audition state
 
-				// bypass all fade automation
-				auto_override = true;
-				depot_fader.setSpeed(bypass_speed);
+					// bypass all fade automation
+					auto_override = true;
+					depot_fader.setSpeed(bypass_speed);
 
-				// set to auditioned if audition mode = 1
-				if (audition_mode == 1) {
-					if (!depot_fader.on) {
-						depot_fader.temped = !depot_fader.temped;
+					// set to auditioned if audition mode = 1
+					if (audition_mode == 1) {
+						if (!depot_fader.on) {
+							depot_fader.temped = !depot_fader.temped;
+						}
+						auditioned = true;
 					}
-					auditioned = true;
-				}
 
-			if (auditioned) {   // this depot is being auditioned
-					depot_fader.on =  true;
-				} else {   // mute the depot
-					if (depot_fader.on) {
-						depot_fader.temped = true;   // remember this depot was on
-					}
-					depot_fader.on = false;
-				}
-			} else {   // stop auditions
-
-				// return to states before auditions
-				if (depot_fader.temped) {
-					depot_fader.temped = false;
-					auto_override = true;
-					depot_fader.setSpeed(bypass_speed);
-					if (auditioned) {
+				if (auditioned) {   // this depot is being auditioned
+						depot_fader.on =  true;
+					} else {   // mute the depot
+						if (depot_fader.on) {
+							depot_fader.temped = true;   // remember this depot was on
+						}
 						depot_fader.on = false;
-					} else {
-						depot_fader.on = true;
 					}
-				}
+				} else {   // stop auditions
+
+					// return to states before auditions
+					if (depot_fader.temped) {
+						depot_fader.temped = false;
+						auto_override = true;
+						depot_fader.setSpeed(bypass_speed);
+						if (auditioned) {
+							depot_fader.on = false;
+						} else {
+							depot_fader.on = true;
+						}
+					}
 
-				// turn off auditions
-				auditioned = false;
+					// turn off auditions
+					auditioned = false;
+				}
 			}
 
-			// process fade speed changes if turning knobs
+			// process fade speed changes if turning knobs, fade speed cv is followed every sample above
 			if (!auto_override) {
 				if (inputs[FADE_CV_INPUT].isConnected()) {
-					if (depot_fader.on) {   // fade in with CV
-						if (fade_cv_mode == 0 || fade_cv_mode == 1) {
-							depot_fader.setSpeed(std::round((clamp(inputs[FADE_CV_INPUT].getNormalVoltage(0.0f) * 0.1f, 0.0f, 1.0f) * 33974.f) + 26.f));   // 26 to 34000 milliseconds
-						} else {
-							if (params[FADE_IN_PARAM].getValue() != depot_fader.last_speed) {
-								depot_fader.setSpeed(params[FADE_IN_PARAM].getValue());
-							}
-						}
-					} else {   // fade out with CV
-						if (fade_cv_mode == 0 || fade_cv_mode == 2) {
-							depot_fader.setSpeed(std::round((clamp(inputs[FADE_CV_INPUT].getNormalVoltage(0.0f) * 0.1f, 0.0f, 1.0f) * 33974.f) + 26.f));   // 26 to 34000 milliseconds
-						} else {
-							if (params[FADE_PARAM].getValue() != depot_fader.last_speed) {
-								depot_fader.setSpeed(params[FADE_PARAM].getValue());
-							}
-						}
+					if (depot_fader.on) {   // fade in from the knob when cv only sets fade outs
+						if (fade_cv_mode == 2) followFadeKnob(FADE_IN_PARAM);
+					} else {   // fade out from the knob when cv only sets fade ins
+						if (fade_cv_mode == 1) followFadeKnob(FADE_PARAM);
 					}
 				} else {
-					if (depot_fader.on) {
-						if (params[FADE_IN_PARAM].getValue() != depot_fader.getFade()) {
-							depot_fader.setSpeed(params[FADE_IN_PARAM].getValue());
-						}
-					} else {
-						if (params[FADE_PARAM].getValue() != depot_fader.getFade()) {
-							depot_fader.setSpeed(params[FADE_PARAM].getValue());
-						}
-					}
+					followFadeKnob(depot_fader.on ? FADE_IN_PARAM : FADE_PARAM);
 				}
 			}
 
 			// set lights
 			if (depot_fader.getFade() == depot_fader.getGain()) {
-				if (audition_depot) {
+				if (auditions.isActive(AUDITION_DEPOT, audition_group)) {
 					lights[ON_LIGHT + 0].value = 1.f;   // yellow when auditioned
 					lights[ON_LIGHT + 1].value = 1.f;
 				} else {
@@ -248,6 +267,11 @@ struct BusDepot : Module {
 			}
 		}
 
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float bus_out[WIDE_BUS_CHANNELS] = {};
+
 		// process sound
 		float summed_out[2] = {0.f, 0.f};
 		if (depot_fader.getFade() > 0.f) {   // don't need to process sound when silent
@@ -258,7 +282,7 @@ struct BusDepot : Module {
 			if (level_cv_filter) master_level = level_smoother.slew(master_level);
 			float exp_fade = 0.f;
 			if (depot_fader.fading) {
-				exp_fade = depot_fader.getExpFade(2.5);   // exponential fade for fade automation
+				exp_fade = depot_fader.getCurveFade();   // curved fade for fade automation
 			} else {
 				exp_fade = depot_fader.getFade();
 			}
@@ -275,27 +299,18 @@ struct BusDepot : Module {
 				}
 			}
 
-			// bus inputs with levels
-			float bus_in[6] = {};
-
-			// get blue and orange buses with levels
-			for (int c = 0; c < 4; c++) {
-				bus_in[c] = inputs[BUS_INPUT].getPolyVoltage(c) * master_level * exp_fade;
-			}
+			// add aux inputs to red, or the last of this module's buses on the wide bus
+			int red_channel = bus_link.bankChannel() + 4;
+			bus_chain[red_channel] += stereo_in[0];
+			bus_chain[red_channel + 1] += stereo_in[1];
 
-			// get red levels and add aux inputs
-			for (int c = 4; c < 6; c++) {
-				bus_in[c] = (stereo_in[c - 4] + inputs[BUS_INPUT].getPolyVoltage(c)) * master_level * exp_fade;
-			}
-
-			// set bus outputs
-			for (int c = 0; c < 6; c++) {
-				outputs[BUS_OUTPUT].setVoltage(bus_in[c], c);
-			}
-
-			// sum stereo mix for stereo outputs and light levels
-			for (int c = 0; c < 2; c++) {
-				summed_out[c] = bus_in[c] + bus_in[c + 2] + bus_in[c + 4];
+			// buses with levels, and the stereo mix for stereo outputs and light levels
+			if (bus_link.wide_bus > 0) {
+				BusCable<WIDE_BUSES>::mix(bus_out, bus_chain, master_level * exp_fade);
+				BusCable<WIDE_BUSES>::mixStereo(bus_out, summed_out);
+			} else {
+				BusCable<3>::mix(bus_out, bus_chain, master_level * exp_fade);
+				BusCable<3>::mixStereo(bus_out, summed_out);
 			}
 
 			// set stereo mix out
@@ -303,48 +318,34 @@ struct BusDepot : Module {
 			outputs[RIGHT_OUTPUT].setVoltage(summed_out[1]);
 		}
 
-		// set three stereo bus outputs on bus out
-		outputs[BUS_OUTPUT].setChannels(6);
-
-		// hit peak lights accurately by polling every sample
-		if (summed_out[0] > 10.f) peak_left = 1.f;
-		if (summed_out[1] > 10.f) peak_right = 1.f;
-
-		// get levels for lights
-		if (vu_divider.process()) {   // check levels infrequently
-			for (int i = 0; i < 2; i++) {
-				vu_meters[i].process(args.sampleTime * vu_divider.getDivision(), summed_out[i] / 10.f);
+		// look-ahead limiter on the stereo mix, the buses are delayed and limited with it so they stay in step
+		int limiter_latency = 0;
+		if (output_limiter > 0) {
+			if (!limiter_running) {
+				limiter.restart();   // no old sound from before it was turned on, and no buffers cleared here
+				limiter_running = true;
+			}
+			limiter.setCeiling(LIMITER_CEILINGS[output_limiter]);
+			if (bus_link.wide_bus > 0) {
+				limiter.process(bus_out, WIDE_BUS_CHANNELS, std::max(std::fabs(summed_out[0]), std::fabs(summed_out[1])));
+				BusCable<WIDE_BUSES>::mixStereo(bus_out, summed_out);
+			} else {
+				limiter.process(bus_out, BusCable<3>::CHANNELS, std::max(std::fabs(summed_out[0]), std::fabs(summed_out[1])));
+				BusCable<3>::mixStereo(bus_out, summed_out);
 			}
+			outputs[LEFT_OUTPUT].setVoltage(summed_out[0]);
+			outputs[RIGHT_OUTPUT].setVoltage(summed_out[1]);
+			limiter_latency = limiter.getLatency();
+		} else {
+			limiter_running = false;
 		}
 
-		if (light_divider.process()) {   // set lights and fade speed infrequently
-
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
-			// make peak lights stay on when hit
-			if (peak_left > 0) peak_left -= 120.f / args.sampleRate; else peak_left = 0.f;
-			if (peak_right > 0) peak_right -= 120.f / args.sampleRate; else peak_right = 0.f;
-			lights[LEFT_LIGHTS + 0].setBrightness(peak_left);
-			lights[RIGHT_LIGHTS + 0].setBrightness(peak_right);
-
-			// green and yellow lights
-			for (int i = 1; i < 6; i++) {
-				lights[LEFT_LIGHTS + i].setBrightness(vu_meters[0].getBrightness((-3 * i), -3 * (i - 1)));
-				lights[RIGHT_LIGHTS + i].setBrightness(vu_meters[1].getBrightness((-3 * i), -3 * (i - 1)));
-			}
-			lights[LEFT_LIGHTS + 6].setBrightness(vu_meters[0].getBrightness(-19, -15));
-			lights[RIGHT_LIGHTS + 6].setBrightness(vu_meters[1].getBrightness(-19, -15));
-			lights[LEFT_LIGHTS + 7].setBrightness(vu_meters[0].getBrightness(-24, -19));
-			lights[RIGHT_LIGHTS + 7].setBrightness(vu_meters[1].getBrightness(-24, -19));
-			lights[LEFT_LIGHTS + 8].setBrightness(vu_meters[0].getBrightness(-30, -24));
-			lights[RIGHT_LIGHTS + 8].setBrightness(vu_meters[1].getBrightness(-30, -24));
-			lights[LEFT_LIGHTS + 9].setBrightness(vu_meters[0].getBrightness(-36, -28));
-			lights[RIGHT_LIGHTS + 9].setBrightness(vu_meters[1].getBrightness(-36, -28));
-			lights[LEFT_LIGHTS + 10].setBrightness(vu_meters[0].getBrightness(-48, -36));
-			lights[RIGHT_LIGHTS + 10].setBrightness(vu_meters[1].getBrightness(-48, -36));
-		}
+		// bus out with one more sample of latency on the chain and any limiter look-ahead, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_out, chain_latency + 1 + limiter_latency);
+
+		// mix levels for the vu lights and loudness
+		meter.processStereo(summed_out[0], summed_out[1]);
+		loudness.process(summed_out[0], summed_out[1]);
 	}
 
 	// save on button state
@@ -354,15 +355,29 @@ struct BusDepot : Module {
 		json_object_set_new(rootJ, "level_cv_filter", json_integer(level_cv_filter));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "fade_cv_mode", json_integer(fade_cv_mode));
-		json_object_set_new(rootJ, "audition_depot", json_integer(audition_depot));
+		json_object_set_new(rootJ, "audition_depot", json_integer(auditions.isActive(AUDITION_DEPOT, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
 		json_object_set_new(rootJ, "auditioned", json_integer(auditioned));
 		json_object_set_new(rootJ, "temped", json_integer(depot_fader.temped));
 		json_object_set_new(rootJ, "audition_mode", json_integer(audition_mode));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "output_limiter", json_integer(output_limiter));
+		json_object_set_new(rootJ, "scene_morph", json_integer(scene_morph));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
 		return rootJ;
 	}
 
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
 		json_t *input_onJ = json_object_get(rootJ, "input_on");
 		if (input_onJ) depot_fader.on = json_integer_value(input_onJ);
 		json_t *level_cv_filterJ = json_object_get(rootJ, "level_cv_filter");
@@ -389,9 +404,9 @@ struct BusDepot : Module {
 		}
 		json_t *audition_depotJ = json_object_get(rootJ, "audition_depot");
 		if (audition_depotJ) {
-			audition_depot = json_integer_value(audition_depotJ);
+			auditions.setActive(AUDITION_DEPOT, audition_group, json_integer_value(audition_depotJ));
 		} else {
-			audition_depot = false;   // off because patch saved before audition
+			auditions.stop(AUDITION_DEPOT, audition_group);   // off because patch saved before audition
 		}
 		json_t *auditionedJ = json_object_get(rootJ, "auditioned");
 		if (auditionedJ) auditioned = json_integer_value(auditionedJ);
@@ -399,30 +414,87 @@ struct BusDepot : Module {
 		if (tempedJ) depot_fader.temped = json_integer_value(tempedJ);
 		json_t *audition_modeJ = json_object_get(rootJ, "audition_mode");
 		if (audition_modeJ) audition_mode = json_integer_value(audition_modeJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
+		json_t *scene_morphJ = json_object_get(rootJ, "scene_morph");
+		if (scene_morphJ) scene_morph = clamp((int)json_integer_value(scene_morphJ), 0, SCENE_MORPHS - 1);
+		json_t *output_limiterJ = json_object_get(rootJ, "output_limiter");
+		if (output_limiterJ) output_limiter = clamp((int)json_integer_value(output_limiterJ), 0, LIMITER_SETTINGS - 1);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		on_button.setSampleRate(sample_rate);
+		depot_fader.setSampleRate(sample_rate);
 		if (depot_fader.on) {
 			depot_fader.setSpeed(params[FADE_IN_PARAM].getValue());
 		} else {
 			depot_fader.setSpeed(params[FADE_PARAM].getValue());
 		}
-		level_smoother.setSlewSpeed(level_speed);
+		level_smoother.setSampleRate(sample_rate);
+		meter.setSampleRate(sample_rate);
+		loudness.setSampleRate(sample_rate);
+		limiter.setSampleRate(sample_rate);
+	}
+
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
 	}
 
 	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
 		depot_fader.on = true;
 		depot_fader.setGain(1.f);
 		level_cv_filter = true;
 		fade_cv_mode = 0;
 		audition_mode = 0;
-		audition_depot = false;
+		auditions.stop(AUDITION_DEPOT, audition_group);
+		setAuditionGroup(0);
+		setFadeCurve(FADE_CURVE_EXP);
+		output_limiter = 0;
+		scene_morph = 0;
+		loudness.requestReset();
+	}
+
+	// fader speed from a fade knob, only set when the knob reaches another whole millisecond
+	void followFadeKnob(int param_id) {
+		int speed = (int)std::round(params[param_id].getValue());
+		if (speed != depot_fader.last_speed) {
+			depot_fader.setSpeed(speed);
+		}
+	}
+
+	// on state from a scene or automation, turned like a single click of the on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(bool on) {
+		if (auditions.isActive(AUDITION_DEPOT, audition_group) || on == depot_fader.on) return;
+		auto_override = false;   // do not override automation
+		depot_fader.on = on;
+		if (on) {
+			depot_fader.setSpeed(int(params[FADE_IN_PARAM].getValue()));
+		} else {
+			depot_fader.setSpeed(int(params[FADE_PARAM].getValue()));
+		}
+	}
+
+	// set fade automation curve on fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		depot_fader.setCurve(curve);
 	}
 };
 
 
 struct BusDepotWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	BusDepotWidget(BusDepot *module) {
 		setModule(module);
@@ -457,6 +529,7 @@ struct BusDepotWidget : ModuleWidget {
 		addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(6.95, 31.2)), true, module, BusDepot::R_INPUT, module ? &module->color_theme : NULL));
 		addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.45, 114.1)), true, module, BusDepot::BUS_INPUT, module ? &module->color_theme : NULL));
 		addInput(createThemedPortCentered<gtgKeyPort>(mm2px(Vec(23.6, 31.2)), true, module, BusDepot::FADE_CV_INPUT, module ? &module->color_theme : NULL));
+		addInput(createThemedPortCentered<gtgKeyPort>(mm2px(Vec(15.24, 97.8)), true, module, BusDepot::SCENE_CV_INPUT, module ? &module->color_theme : NULL));
 
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(23.1, 103.85)), false, module, BusDepot::LEFT_OUTPUT, module ? &module->color_theme : NULL));
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(23.1, 114.1)), false, module, BusDepot::RIGHT_OUTPUT, module ? &module->color_theme : NULL));
@@ -563,6 +636,104 @@ struct BusDepotWidget : ModuleWidget {
 			}
 		};
 
+		struct LimiterItem : MenuItem {
+			BusDepot *module;
+			int limiter_setting;
+			void onAction(const event::Action &e) override {
+				module->output_limiter = limiter_setting;
+			}
+		};
+
+		struct LimitersItem : MenuItem {
+			BusDepot *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string limiter_titles[LIMITER_SETTINGS] = {"Off (default)", "Limit at 0 dB, 10 V", "Limit at -1 dB", "Limit at -3 dB"};
+				for (int i = 0; i < LIMITER_SETTINGS; i++) {
+					LimiterItem *limiter_item = new LimiterItem;
+					limiter_item->text = limiter_titles[i];
+					limiter_item->rightText = CHECKMARK(module->output_limiter == i);
+					limiter_item->module = module;
+					limiter_item->limiter_setting = i;
+					menu->addChild(limiter_item);
+				}
+				menu->addChild(new MenuEntry);
+				menu->addChild(createMenuLabel(string::f("Adds %d samples to the bus chain", module->limiter.getLatency())));
+				return menu;
+			}
+		};
+
+		struct SceneItem : MenuItem {
+			BusDepot *module;
+			int scene;
+			bool capture;
+			void onAction(const event::Action &e) override {
+				if (capture) {
+					scenes.capture(scene);
+				} else {
+					scenes.recall(scene, SCENE_MORPH_SECONDS[module->scene_morph]);
+				}
+			}
+		};
+
+		struct SceneListItem : MenuItem {
+			BusDepot *module;
+			bool capture;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				for (int i = 0; i < SCENES; i++) {
+					SceneItem *scene_item = new SceneItem;
+					scene_item->text = string::f("Scene %d", i + 1);
+					scene_item->rightText = CHECKMARK(module->scene_memory.captured[i]);
+					scene_item->disabled = !capture && !module->scene_memory.captured[i];
+					scene_item->module = module;
+					scene_item->scene = i;
+					scene_item->capture = capture;
+					menu->addChild(scene_item);
+				}
+				return menu;
+			}
+		};
+
+		struct SceneMorphItem : MenuItem {
+			BusDepot *module;
+			int morph;
+			void onAction(const event::Action &e) override {
+				module->scene_morph = morph;
+			}
+		};
+
+		struct ScenesItem : MenuItem {
+			BusDepot *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				menu->addChild(createMenuLabel("Levels, pans and on states of every module"));
+
+				SceneListItem *capture_item = createMenuItem<SceneListItem>("Capture", RIGHT_ARROW);
+				capture_item->module = module;
+				capture_item->capture = true;
+				menu->addChild(capture_item);
+
+				SceneListItem *recall_item = createMenuItem<SceneListItem>("Recall", RIGHT_ARROW);
+				recall_item->module = module;
+				recall_item->capture = false;
+				menu->addChild(recall_item);
+
+				menu->addChild(new MenuEntry);
+				menu->addChild(createMenuLabel("Morph Time"));
+				std::string morph_titles[SCENE_MORPHS] = {"Instant (default)", "1 second", "2 seconds", "4 seconds", "8 seconds", "16 seconds", "32 seconds"};
+				for (int i = 0; i < SCENE_MORPHS; i++) {
+					SceneMorphItem *scene_morph_item = new SceneMorphItem;
+					scene_morph_item->text = morph_titles[i];
+					scene_morph_item->rightText = CHECKMARK(module->scene_morph == i);
+					scene_morph_item->module = module;
+					scene_morph_item->morph = i;
+					menu->addChild(scene_morph_item);
+				}
+				return menu;
+			}
+		};
+
 		struct ThemeItem : MenuItem {
 			BusDepot* module;
 			int theme;
@@ -620,6 +791,25 @@ struct BusDepotWidget : ModuleWidget {
 			}
 		};
 
+		// loudness readout, updated live while the menu is open
+		struct LoudnessLabel : MenuLabel {
+			std::atomic<float> *value;
+			std::string name;
+			std::string unit;
+			void step() override {
+				float v = value->load();
+				text = name + (std::isfinite(v) ? string::f("%.1f ", v) : "-inf ") + unit;
+				MenuLabel::step();
+			}
+		};
+
+		struct LoudnessResetItem : MenuItem {
+			BusDepot *module;
+			void onAction(const event::Action &e) override {
+				module->loudness.requestReset();
+			}
+		};
+
 		menu->addChild(new MenuEntry);
 		menu->addChild(createMenuLabel("Mixer Settings"));
 
@@ -633,11 +823,61 @@ struct BusDepotWidget : ModuleWidget {
 		fadeCvModesItem->module = module;
 		menu->addChild(fadeCvModesItem);
 
+		FadeCurvesItem<BusDepot> *fadeCurvesItem = createMenuItem<FadeCurvesItem<BusDepot>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<BusDepot> *automationItem = createMenuItem<AutomationItem<BusDepot>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
 		AuditionModesItem *auditionModesItem = createMenuItem<AuditionModesItem>("Audition Modes");
 		auditionModesItem->rightText = RIGHT_ARROW;
 		auditionModesItem->module = module;
 		menu->addChild(auditionModesItem);
 
+		LimitersItem *limitersItem = createMenuItem<LimitersItem>("Output Limiter");
+		limitersItem->rightText = RIGHT_ARROW;
+		limitersItem->module = module;
+		menu->addChild(limitersItem);
+
+		ScenesItem *scenesItem = createMenuItem<ScenesItem>("Scenes");
+		scenesItem->rightText = RIGHT_ARROW;
+		scenesItem->module = module;
+		menu->addChild(scenesItem);
+
+		BusLinkItem<BusDepot> *busLinkItem = createMenuItem<BusLinkItem<BusDepot>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<BusDepot> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<BusDepot>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
+		menu->addChild(new MenuEntry);
+		menu->addChild(createMenuLabel("Loudness of Stereo Outputs"));
+		std::string loudness_names[4] = {"Momentary ", "Short term ", "Integrated ", "True peak "};
+		std::atomic<float> *loudness_values[4] = {&module->loudness.momentary, &module->loudness.short_term, &module->loudness.integrated, &module->loudness.true_peak};
+		for (int i = 0; i < 4; i++) {
+			LoudnessLabel *loudness_label = new LoudnessLabel;
+			loudness_label->name = loudness_names[i];
+			loudness_label->unit = (i < 3) ? "LUFS" : "dBTP";
+			loudness_label->value = loudness_values[i];
+			menu->addChild(loudness_label);
+		}
+
+		LoudnessResetItem *loudnessResetItem = createMenuItem<LoudnessResetItem>("Reset Loudness");
+		loudnessResetItem->module = module;
+		menu->addChild(loudnessResetItem);
+
 #ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
@@ -648,18 +888,32 @@ struct BusDepotWidget : ModuleWidget {
 #endif
 	}
 
-	// display the panel based on the theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			BusDepot *bus_depot = (BusDepot*)module;
+			if (bus_depot->use_default_theme) {
+				bus_depot->color_theme = gtg_default_theme;
+			}
+
+			// vu lights from the levels the audio thread handed over
+			bus_depot->meter.update();
+			bus_depot->meter.setLadderLights(0, &bus_depot->lights[BusDepot::LEFT_LIGHTS]);
+			bus_depot->meter.setLadderLights(1, &bus_depot->lights[BusDepot::RIGHT_LIGHTS]);
+
+			if (bus_depot->color_theme != applied_theme) {
+				applied_theme = bus_depot->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((BusDepot*)module)->color_theme) == 0);
-			night_panel->visible = ((((BusDepot*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
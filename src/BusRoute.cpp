@@ -1,6 +1,8 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgScenes.hpp"
 
 
 struct BusRoute : Module {
@@ -31,19 +33,45 @@ struct BusRoute : Module {
 	AutoFader route_fader[3];
 
 	const int fade_speed = 26;
-	float delay_buf[1000][6] = {};
-	int delay_i = 0;
+	StereoDelayLine delay_lines[3];
+	float max_delay_ms = 100.f;   // longest delay, chosen in the menu, delay lines are sized for it
+	int delay_units = 0;   // 0 is samples, 1 is tenths of a millisecond
+	float samples_per_unit = 1.f;
+	int max_delay_knob = 4410;   // knob value at the longest delay, in delay units
+	float sample_rate = DSP_DEFAULT_SAMPLE_RATE;
 	int delay_knobs[3] = {0, 0, 0};
+	int auto_delays[3] = {0, 0, 0};   // latency compensation for buses that are not sent
+	const int send_return_latency = 2;   // one sample each for the send and return cables
+	bool latency_compensation = true;
+	LatencyProbe latency_probe;
+	std::atomic<int> measure_bus {-1};   // bus to measure, set from the menu
+	int probe_bus = -1;   // bus being measured
+	int measured_latencies[3] = {-1, -1, -1};   // send to return of each bus, -1 until measured
+	bool measure_failed[3] = {false, false, false};
+	bool measure_out_of_range[3] = {false, false, false};   // measured, but further behind than a delay knob reaches
 	bool bus_audition[3] = {false, false, false};
 	bool auditioning = false;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	BusLink bus_link;
+
+	// a delay setting from the menu, sized on the ui thread and swapped in by process()
+	struct DelaySetting {
+		int units = 0;
+		float max_delay_ms = 100.f;
+		StereoDelayLine delay_lines[3];
+		LatencyProbe latency_probe;
+		std::atomic<bool> applied {false};
+	};
+	std::atomic<DelaySetting*> new_setting {NULL};
+	std::vector<DelaySetting*> handed_settings;   // ui thread only, freed once process() is done with them
 
 	BusRoute() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
-		configParam(DELAY_PARAMS + 0, 0, 999, 0, "Sample delay on blue bus");
-		configParam(DELAY_PARAMS + 1, 0, 999, 0, "Sample delay on orange bus");
-		configParam(DELAY_PARAMS + 2, 0, 999, 0, "Sample delay on red bus");
+		configParam(DELAY_PARAMS + 0, 0, 999, 0, "Delay on blue bus", " samples");
+		configParam(DELAY_PARAMS + 1, 0, 999, 0, "Delay on orange bus", " samples");
+		configParam(DELAY_PARAMS + 2, 0, 999, 0, "Delay on red bus", " samples");
 		configParam(ONAU_PARAMS + 0, 0.f, 1.f, 0.f, "Blue bus on (hold to audition)");
 		configParam(ONAU_PARAMS + 1, 0.f, 1.f, 0.f, "Orange bus on (hold to audition)");
 		configParam(ONAU_PARAMS + 2, 0.f, 1.f, 0.f, "Red bus on (hold to audition)");
@@ -67,11 +95,31 @@ struct BusRoute : Module {
 		for (int i = 0; i < 3; i++) {
 			route_fader[i].setSpeed(fade_speed);
 		}
+		setDelays(delay_units, max_delay_ms, DSP_DEFAULT_SAMPLE_RATE, false);
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, DELAY_PARAMS, 3);
+		for (int i = 0; i < 3; i++) {
+			scene_memory.addFader(&route_fader[i], [this, i](bool on) {setOnState(i, on);});
+		}
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
+	}
+
+	~BusRoute() {
+		new_setting.store(NULL);   // also in handed_settings
+		for (DelaySetting *setting : handed_settings) {
+			delete setting;
+		}
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+
+		// delay units or longest delay changed in the menu
+		if (new_setting.load(std::memory_order_relaxed)) {
+			DelaySetting *setting = new_setting.exchange(NULL);
+			if (setting) applyDelaySetting(setting);
+		}
 
 		// get button presses
 		for (int i = 0; i < 3; i++) {
@@ -112,10 +160,6 @@ struct BusRoute : Module {
 		// set send or audtion button lights
 		if (light_divider.process()) {
 
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
 			if (auditioning) {
 				for (int i = 0; i < 3; i++) {
 					if (bus_audition[i]) {
@@ -165,9 +209,42 @@ struct BusRoute : Module {
 
 		}
 
-		// record bus inputs into delay buffer
-		for (int c = 0; c < 6; c++) {
-			delay_buf[delay_i][c] = inputs[BUS_INPUT].getPolyVoltage(c);
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // the 3 stereo buses routed here, other wide buses pass through
+
+		// buses through sends come back after the send and return cables
+		// with latency compensation the buses that stay on the chain wait for them
+		bool sent[3] = {false, false, false};
+		bool any_sent = false;
+		for (int sb = 0; sb < 3; sb++) {
+			sent[sb] = outputs[SEND_OUTPUTS + (sb * 2)].isConnected() || outputs[SEND_OUTPUTS + (sb * 2) + 1].isConnected();
+			if (sent[sb]) any_sent = true;
+		}
+
+		// latency measurement asked for in the menu, only on a bus with a send
+		if (measure_bus.load(std::memory_order_relaxed) >= 0 && !latency_probe.isRunning()) {
+			int bus = measure_bus.exchange(-1);
+			if (bus >= 0 && sent[bus]) {
+				probe_bus = bus;
+				latency_probe.start();
+			}
+		}
+		float probe_send = 0.f;
+		if (probe_bus >= 0) {
+			probe_send = latency_probe.process(inputs[RETURN_INPUTS + (probe_bus * 2)].getVoltage(), inputs[RETURN_INPUTS + (probe_bus * 2) + 1].getVoltage());
+		}
+		int route_latency = 0;   // longest delay added to a bus here, to the nearest sample
+		float delays[3] = {0.f, 0.f, 0.f};
+		for (int sb = 0; sb < 3; sb++) {
+
+			// get delay knob settings, used here and in display values
+			delay_knobs[sb] = params[DELAY_PARAMS + sb].getValue();
+
+			auto_delays[sb] = (latency_compensation && any_sent && !sent[sb]) ? send_return_latency : 0;
+			delays[sb] = (delay_knobs[sb] * samples_per_unit) + auto_delays[sb];
+			route_latency = std::max(route_latency, (int)std::round(delays[sb]) + (sent[sb] ? send_return_latency : 0));
 		}
 
 		// get outputs and sends
@@ -176,24 +253,23 @@ struct BusRoute : Module {
 
 		for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
 
-			// get delay knob settings, used here and in display values
-			delay_knobs[sb] = params[DELAY_PARAMS + sb].getValue();
-
-			// set channel's delay
-			int delay = delay_i - delay_knobs[sb];
-			if (delay < 0) delay = 1000 + delay;   // adjust delay when buffer rolls
-
-			// set send outputs from delay buffer
+			// delay the bus
 			int chan = sb * 2;
+			float delayed[2];
+			delay_lines[sb].process(&bus[chan], delayed, delays[sb]);
 
 			// buses to send outputs or directly to bus out if sends are not connected
-			if (outputs[SEND_OUTPUTS + chan].isConnected() || outputs[SEND_OUTPUTS + chan + 1].isConnected()) {
-				outputs[SEND_OUTPUTS + chan].setVoltage(delay_buf[delay][chan] * route_fader[sb].getFade());   // left
-				outputs[SEND_OUTPUTS + chan + 1].setVoltage(delay_buf[delay][chan + 1] * route_fader[sb].getFade());   // right
+			if (sb == probe_bus) {   // test signal out, and the return held back until the measurement is done
+				outputs[SEND_OUTPUTS + chan].setVoltage(probe_send);
+				outputs[SEND_OUTPUTS + chan + 1].setVoltage(probe_send);
+				continue;
+			} else if (sent[sb]) {
+				outputs[SEND_OUTPUTS + chan].setVoltage(delayed[0] * route_fader[sb].getFade());   // left
+				outputs[SEND_OUTPUTS + chan + 1].setVoltage(delayed[1] * route_fader[sb].getFade());   // right
 			} else {
 
-				bus_out[chan] = delay_buf[delay][chan] * route_fader[sb].getFade();
-				bus_out[chan + 1] = delay_buf[delay][chan + 1] * route_fader[sb].getFade();
+				bus_out[chan] = delayed[0] * route_fader[sb].getFade();
+				bus_out[chan + 1] = delayed[1] * route_fader[sb].getFade();
 			}
 
 			// get all returns, even if sends are not connected or off, allows hearing the tail of a return
@@ -205,21 +281,128 @@ struct BusRoute : Module {
 			mix_out[1] += bus_out[chan + 1];
 		}
 
-		// final bus out
+		// final bus out, with the latency of this hop and its delays on the chain, and on to a linked module on the right
 		for (int c = 0; c < 6; c++) {
-			outputs[BUS_OUTPUT].setVoltage(bus_out[c], c);
+			bus[c] = bus_out[c];
 		}
-
-		// set output to 3 stereo buses
-		outputs[BUS_OUTPUT].setChannels(6);
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1 + route_latency);
 
 		// final mix out
 		outputs[MIX_L_OUTPUT].setVoltage(mix_out[0]);
 		outputs[MIX_R_OUTPUT].setVoltage(mix_out[1]);
 
-		// roll buffer index
-		delay_i++;
-		if (delay_i >= 1000) delay_i = 0;
+		// finished measurement sets the delays
+		if (probe_bus >= 0 && !latency_probe.isRunning()) {
+			if (latency_probe.takeResult() == LatencyProbe::PROBE_FOUND) {
+				measured_latencies[probe_bus] = latency_probe.getLatency();
+				measure_failed[probe_bus] = false;
+				setMeasuredDelays();
+			} else {
+				measure_failed[probe_bus] = true;
+			}
+			probe_bus = -1;
+		}
+	}
+
+	// delay every bus to line up with the slowest measured return
+	// buses not measured count as the send and return cables when sent, and as nothing when not
+	void setMeasuredDelays() {
+		int path_latencies[3] = {0, 0, 0};
+		int slowest = 0;
+		for (int sb = 0; sb < 3; sb++) {
+			bool sent = outputs[SEND_OUTPUTS + (sb * 2)].isConnected() || outputs[SEND_OUTPUTS + (sb * 2) + 1].isConnected();
+			if (measured_latencies[sb] >= 0) {
+				path_latencies[sb] = measured_latencies[sb];
+			} else if (sent) {
+				path_latencies[sb] = send_return_latency;
+			}
+			if (latency_compensation && (sent || measured_latencies[sb] >= 0)) {
+				path_latencies[sb] -= send_return_latency;   // already covered by the automatic delays
+			}
+			slowest = std::max(slowest, path_latencies[sb]);
+		}
+		for (int sb = 0; sb < 3; sb++) {
+			int delay = (int)std::round((slowest - path_latencies[sb]) / samples_per_unit);
+			measure_out_of_range[sb] = (delay > max_delay_knob);
+			params[DELAY_PARAMS + sb].setValue(clamp(delay, 0, max_delay_knob));
+		}
+	}
+
+	// on state of a bus from a scene, turned like a single click of its button, left alone while auditioning
+	void setOnState(int i, bool on) {
+		if (auditioning) return;
+		route_fader[i].on = on;
+	}
+
+	int getMaxDelaySamples(float max_ms, float rate) {
+		return (int)std::ceil(rate * max_ms * 0.001f) + send_return_latency;
+	}
+
+	// delay lines and probe for the longest delay at this sample rate, sized outside of process()
+	void setDelays(int units, float max_ms, float rate, bool convert) {
+		sample_rate = rate;
+		int max_delay = getMaxDelaySamples(max_ms, sample_rate);
+		for (int sb = 0; sb < 3; sb++) {
+			delay_lines[sb].setMaxDelay(max_delay);
+		}
+		latency_probe.setMaxLatency(max_delay);   // any return a delay knob can line up
+		probe_bus = -1;
+		setDelayUnits(units, max_ms, convert);
+	}
+
+	// delay knobs in samples, or in tenths of a millisecond with fractional sample delays
+	// when converting, knob values and scenes keep the same delays in the new units
+	void setDelayUnits(int units, float max_ms, bool convert) {
+		float old_samples_per_unit = samples_per_unit;
+		delay_units = units;
+		max_delay_ms = max_ms;
+		samples_per_unit = (delay_units == 1) ? sample_rate * 0.0001f : 1.f;
+		max_delay_knob = (delay_units == 1) ? (int)std::round(max_delay_ms * 10.f) : (int)std::ceil(sample_rate * max_delay_ms * 0.001f);
+		float factor = old_samples_per_unit / samples_per_unit;
+		for (int sb = 0; sb < 3; sb++) {
+			paramQuantities[DELAY_PARAMS + sb]->maxValue = max_delay_knob;
+			paramQuantities[DELAY_PARAMS + sb]->unit = (delay_units == 1) ? " ms" : " samples";
+			paramQuantities[DELAY_PARAMS + sb]->displayMultiplier = (delay_units == 1) ? 0.1f : 1.f;
+			float value = params[DELAY_PARAMS + sb].getValue();
+			if (convert) value = std::round(value * factor);
+			params[DELAY_PARAMS + sb].setValue(clamp(value, 0.f, (float)max_delay_knob));
+		}
+		if (convert && factor != 1.f) scene_memory.scaleParams(DELAY_PARAMS, 3, factor);
+	}
+
+	// from the menu, delay lines are allocated here and handed to process()
+	void requestDelaySetting(int units, float max_ms) {
+		DelaySetting *setting = new DelaySetting;
+		setting->units = units;
+		setting->max_delay_ms = max_ms;
+		int max_delay = getMaxDelaySamples(max_ms, APP->engine->getSampleRate());
+		for (int sb = 0; sb < 3; sb++) {
+			setting->delay_lines[sb].setMaxDelay(max_delay);
+		}
+		setting->latency_probe.setMaxLatency(max_delay);
+		DelaySetting *unclaimed = new_setting.exchange(setting);
+
+		// free a setting process() never took, and those it has swapped out
+		for (size_t i = 0; i < handed_settings.size();) {
+			if (handed_settings[i] == unclaimed || handed_settings[i]->applied.load()) {
+				delete handed_settings[i];
+				handed_settings.erase(handed_settings.begin() + i);
+			} else {
+				i++;
+			}
+		}
+		handed_settings.push_back(setting);
+	}
+
+	// on the audio thread, the old delay lines go back in the setting to be freed on the ui thread
+	void applyDelaySetting(DelaySetting *setting) {
+		for (int sb = 0; sb < 3; sb++) {
+			std::swap(delay_lines[sb], setting->delay_lines[sb]);
+		}
+		std::swap(latency_probe, setting->latency_probe);
+		probe_bus = -1;
+		setDelayUnits(setting->units, setting->max_delay_ms, true);
+		setting->applied.store(true);
 	}
 
 	// save on color theme
@@ -237,11 +420,22 @@ struct BusRoute : Module {
 		json_object_set_new(rootJ, "temped3", json_integer(route_fader[2].temped));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "latency_compensation", json_integer(latency_compensation));
+		json_object_set_new(rootJ, "delay_units", json_integer(delay_units));
+		json_object_set_new(rootJ, "max_delay_ms", json_real(max_delay_ms));
+		json_object_set_new(rootJ, "measured_latency1", json_integer(measured_latencies[0]));
+		json_object_set_new(rootJ, "measured_latency2", json_integer(measured_latencies[1]));
+		json_object_set_new(rootJ, "measured_latency3", json_integer(measured_latencies[2]));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
 		return rootJ;
 	}
 
 	// load on color theme
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
 		json_t *onau_1J = json_object_get(rootJ, "onau_1");
 		if (onau_1J) route_fader[0].on = json_integer_value(onau_1J);
 		json_t *onau_2J = json_object_get(rootJ, "onau_2");
@@ -274,22 +468,53 @@ struct BusRoute : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *latency_compensationJ = json_object_get(rootJ, "latency_compensation");
+		if (latency_compensationJ) {
+			latency_compensation = json_integer_value(latency_compensationJ);
+		} else {
+			if (onau_1J) latency_compensation = false;   // do not change existing patches
+		}
+		json_t *delay_unitsJ = json_object_get(rootJ, "delay_units");
+		json_t *max_delay_msJ = json_object_get(rootJ, "max_delay_ms");
+		int units = delay_unitsJ ? json_integer_value(delay_unitsJ) : delay_units;
+		float max_ms = max_delay_msJ ? json_number_value(max_delay_msJ) : max_delay_ms;
+		setDelays(units, max_ms, APP->engine->getSampleRate(), false);   // knob values are already in the saved units
+		json_t *measured_latency1J = json_object_get(rootJ, "measured_latency1");
+		if (measured_latency1J) measured_latencies[0] = json_integer_value(measured_latency1J);
+		json_t *measured_latency2J = json_object_get(rootJ, "measured_latency2");
+		if (measured_latency2J) measured_latencies[1] = json_integer_value(measured_latency2J);
+		json_t *measured_latency3J = json_object_get(rootJ, "measured_latency3");
+		if (measured_latency3J) measured_latencies[2] = json_integer_value(measured_latency3J);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// reset fader speed
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
 		for (int i = 0; i < 3; i++) {
+			onauButtons[i].setSampleRate(sample_rate);
+			route_fader[i].setSampleRate(sample_rate);
 			route_fader[i].setSpeed(fade_speed);
 		}
+		setDelays(delay_units, max_delay_ms, sample_rate, false);
 	}
 
 	// reset on audition states when initialized
 	void onReset() override {
+		scene_memory.clear();
 		auditioning = false;
 		for (int i = 0; i < 3; i++) {
 			route_fader[i].on = true;
 			bus_audition[i] = false;
+			measured_latencies[i] = -1;
+			measure_failed[i] = false;
+			measure_out_of_range[i] = false;
 		}
+		latency_compensation = true;
+		setDelays(0, 100.f, APP->engine->getSampleRate(), false);
 	}
 };
 
@@ -307,7 +532,7 @@ struct DelayDisplayWidget : TransparentWidget {
 	void draw(const DrawArgs &args) override {
 		int value = module ? module->delay_knobs[delay_knob] : 0;
 		std::shared_ptr<Font> font = APP->window->loadFont(asset::plugin(pluginInstance, fontPath));
-		std::string text = string::f("%03d", value);
+		std::string text = (module && module->delay_units == 1) ? string::f("%04.1f", value * 0.1f) : string::f("%03d", value);
 
 		// background
 		NVGcolor backgroundColor = nvgRGB(26, 26, 26);
@@ -318,7 +543,8 @@ struct DelayDisplayWidget : TransparentWidget {
 
 		// display text text
 		if (font) {
-			nvgFontSize(args.vg, 6);
+			int digits = text.size() - std::count(text.begin(), text.end(), '.');
+			nvgFontSize(args.vg, (digits > 3) ? 4.5 : 6);   // long delays take four digits
 			nvgFontFaceId(args.vg, font->handle);
 			nvgTextLetterSpacing(args.vg, 0.5);
 			nvgTextAlign(args.vg, NVG_ALIGN_RIGHT);
@@ -333,6 +559,7 @@ struct DelayDisplayWidget : TransparentWidget {
 
 struct BusRouteWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	BusRouteWidget(BusRoute *module) {
 		setModule(module);
@@ -398,11 +625,103 @@ struct BusRouteWidget : ModuleWidget {
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(23.49, 114.107)), false, module, BusRoute::MIX_R_OUTPUT, module ? &module->color_theme : NULL));
 	}
 
-#ifndef USING_CARDINAL_NOT_RACK
 	// build the menu
 	void appendContextMenu(Menu* menu) override {
 		BusRoute* module = dynamic_cast<BusRoute*>(this->module);
 
+		struct LatencyCompensationItem : MenuItem {
+			BusRoute *module;
+			void onAction(const event::Action &e) override {
+				module->latency_compensation = !module->latency_compensation;
+			}
+		};
+
+		struct DelayUnitItem : MenuItem {
+			BusRoute *module;
+			int units;
+			void onAction(const event::Action &e) override {
+				module->requestDelaySetting(units, module->max_delay_ms);
+			}
+		};
+
+		struct DelayUnitsItem : MenuItem {
+			BusRoute *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string unit_titles[2] = {"Samples (default)", "Milliseconds"};
+				for (int i = 0; i < 2; i++) {
+					DelayUnitItem *delay_unit_item = new DelayUnitItem;
+					delay_unit_item->text = unit_titles[i];
+					delay_unit_item->rightText = CHECKMARK(module->delay_units == i);
+					delay_unit_item->module = module;
+					delay_unit_item->units = i;
+					menu->addChild(delay_unit_item);
+				}
+				return menu;
+			}
+		};
+
+		struct MaxDelayItem : MenuItem {
+			BusRoute *module;
+			float max_delay_ms;
+			void onAction(const event::Action &e) override {
+				module->requestDelaySetting(module->delay_units, max_delay_ms);
+			}
+		};
+
+		struct MaxDelaysItem : MenuItem {
+			BusRoute *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				float max_delays[5] = {10.f, 20.f, 50.f, 100.f, 200.f};
+				std::string max_delay_titles[5] = {"10 ms", "20 ms", "50 ms", "100 ms (default)", "200 ms"};
+				for (int i = 0; i < 5; i++) {
+					MaxDelayItem *max_delay_item = new MaxDelayItem;
+					max_delay_item->text = max_delay_titles[i];
+					max_delay_item->rightText = CHECKMARK(module->max_delay_ms == max_delays[i]);
+					max_delay_item->module = module;
+					max_delay_item->max_delay_ms = max_delays[i];
+					menu->addChild(max_delay_item);
+				}
+				return menu;
+			}
+		};
+
+		struct MeasureItem : MenuItem {
+			BusRoute *module;
+			int bus;
+			void onAction(const event::Action &e) override {
+				module->measure_bus.store(bus);
+			}
+		};
+
+		struct MeasureLatenciesItem : MenuItem {
+			BusRoute *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				menu->addChild(createMenuLabel("Plays a short noise burst on the send"));
+				std::string bus_titles[3] = {"Measure blue return", "Measure orange return", "Measure red return"};
+				for (int i = 0; i < 3; i++) {
+					MeasureItem *measure_item = new MeasureItem;
+					measure_item->text = bus_titles[i];
+					if (module->probe_bus == i || module->measure_bus.load() == i) {
+						measure_item->rightText = "measuring";
+					} else if (module->measure_failed[i]) {
+						measure_item->rightText = string::f("nothing within %d samples", module->latency_probe.getMaxLatency());
+					} else if (module->measure_out_of_range[i]) {   // another bus came back too late for this delay knob
+						measure_item->rightText = (module->measured_latencies[i] >= 0) ? string::f("%d samples, delay out of range", module->measured_latencies[i]) : "delay out of range";
+					} else if (module->measured_latencies[i] >= 0) {
+						measure_item->rightText = string::f("%d samples", module->measured_latencies[i]);
+					}
+					measure_item->disabled = !(module->outputs[BusRoute::SEND_OUTPUTS + (i * 2)].isConnected() || module->outputs[BusRoute::SEND_OUTPUTS + (i * 2) + 1].isConnected());
+					measure_item->module = module;
+					measure_item->bus = i;
+					menu->addChild(measure_item);
+				}
+				return menu;
+			}
+		};
+
 		struct ThemeItem : MenuItem {
 			BusRoute* module;
 			int theme;
@@ -462,25 +781,64 @@ struct BusRouteWidget : ModuleWidget {
 
 		menu->addChild(new MenuEntry);
 
+		BusLinkItem<BusRoute> *busLinkItem = createMenuItem<BusLinkItem<BusRoute>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		LatencyCompensationItem *latencyCompensationItem = createMenuItem<LatencyCompensationItem>("Delay Unsent Buses to Match Returns", CHECKMARK(module->latency_compensation));
+		latencyCompensationItem->module = module;
+		menu->addChild(latencyCompensationItem);
+
+		DelayUnitsItem *delayUnitsItem = createMenuItem<DelayUnitsItem>("Delay Knob Units");
+		delayUnitsItem->rightText = RIGHT_ARROW;
+		delayUnitsItem->module = module;
+		menu->addChild(delayUnitsItem);
+
+		MaxDelaysItem *maxDelaysItem = createMenuItem<MaxDelaysItem>("Longest Delay");
+		maxDelaysItem->rightText = RIGHT_ARROW;
+		maxDelaysItem->module = module;
+		menu->addChild(maxDelaysItem);
+
+		MeasureLatenciesItem *measureLatenciesItem = createMenuItem<MeasureLatenciesItem>("Measure Return Latency");
+		measureLatenciesItem->rightText = RIGHT_ARROW;
+		measureLatenciesItem->module = module;
+		menu->addChild(measureLatenciesItem);
+
+#ifndef USING_CARDINAL_NOT_RACK
+		menu->addChild(new MenuEntry);
+
 		ThemesItem *themesItem = createMenuItem<ThemesItem>("Panel Themes");
 		themesItem->rightText = RIGHT_ARROW;
 		themesItem->module = module;
 		menu->addChild(themesItem);
-	}
 #endif
+	}
 
-	// display the panel based on the theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			BusRoute *bus_route = (BusRoute*)module;
+			if (bus_route->use_default_theme) {
+				bus_route->color_theme = gtg_default_theme;
+			}
+			if (bus_route->color_theme != applied_theme) {
+				applied_theme = bus_route->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((BusRoute*)module)->color_theme) == 0);
-			night_panel->visible = ((((BusRoute*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
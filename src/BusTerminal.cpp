@@ -0,0 +1,762 @@
+#include "plugin.hpp"
+#include "gtgComponents.hpp"
+#include "gtgDSP.hpp"
+#include "gtgSIMD.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
+
+
+// eight Gig Bus strips in one module
+// each strip is a lane of float_4 blocks, so one process() mixes every strip to the 3 stereo buses
+const int TERMINAL_STRIPS = 8;
+const int TERMINAL_BLOCKS = TERMINAL_STRIPS / 4;
+
+struct BusTerminal : Module {
+	enum ParamIds {
+		ENUMS(ON_PARAMS, TERMINAL_STRIPS),
+		ENUMS(PAN_PARAMS, TERMINAL_STRIPS),
+		ENUMS(LEVEL_PARAMS, TERMINAL_STRIPS * 3),   // blue, orange, then red for every strip
+		NUM_PARAMS
+	};
+	enum InputIds {
+		ENUMS(ON_CV_INPUTS, TERMINAL_STRIPS),
+		ENUMS(LMP_INPUTS, TERMINAL_STRIPS),
+		ENUMS(R_INPUTS, TERMINAL_STRIPS),
+		BUS_INPUT,
+		NUM_INPUTS
+	};
+	enum OutputIds {
+		BUS_OUTPUT,
+		NUM_OUTPUTS
+	};
+	enum LightIds {
+		ENUMS(ON_LIGHTS, TERMINAL_STRIPS * 2),
+		ENUMS(VU_LIGHTS, TERMINAL_STRIPS * 2),
+		NUM_LIGHTS
+	};
+
+	gtgMeter meters[TERMINAL_BLOCKS];   // a strip in each lane
+	dsp::ClockDivider light_divider;
+	dsp::ClockDivider audition_divider;
+	LongPressButton on_buttons[TERMINAL_STRIPS];
+	dsp::SchmittTrigger on_cv_triggers[TERMINAL_STRIPS];
+	AutoFader terminal_faders[TERMINAL_STRIPS];
+	SimpleSlewer post_fade_filters[TERMINAL_STRIPS];
+
+	// strip gains in float_4 lanes, set once per block and ramped across it
+	BlockRamps<TERMINAL_BLOCKS> fade_ramps;
+	BlockRamps<TERMINAL_BLOCKS> pan_ramps[2];
+	BlockRamps<TERMINAL_BLOCKS> level_ramps[3];
+
+	const int bypass_speed = 26;
+	const int smooth_speed = 26;
+	float fade_in = 26.f;
+	float fade_out = 26.f;
+	int fade_curve = FADE_CURVE_EXP;
+	bool auto_override[TERMINAL_STRIPS] = {};
+	bool post_fades = true;
+	bool auditioned[TERMINAL_STRIPS] = {};
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
+	int pan_law = PAN_LAW_3DB;
+	int color_theme = 0;
+	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	BusLink bus_link;
+	int block_i = 0;   // sample position in block ramps
+
+	BusTerminal() {
+		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			std::string strip = std::to_string(s + 1);
+			configParam(ON_PARAMS + s, 0.f, 1.f, 0.f, "Strip " + strip + " on");
+			configParam(PAN_PARAMS + s, -1.f, 1.f, 0.f, "Strip " + strip + " pan");
+			configParam(LEVEL_PARAMS + s, 0.f, 1.f, 0.f, "Strip " + strip + " post red level send to blue stereo bus");
+			configParam(LEVEL_PARAMS + TERMINAL_STRIPS + s, 0.f, 1.f, 0.f, "Strip " + strip + " post red level send to orange stereo bus");
+			configParam(LEVEL_PARAMS + (TERMINAL_STRIPS * 2) + s, 0.f, 1.f, 1.f, "Strip " + strip + " master level to red stereo bus");
+			configInput(ON_CV_INPUTS + s, "Strip " + strip + " on CV");
+			configInput(LMP_INPUTS + s, "Strip " + strip + " left, mono, or poly");
+			configInput(R_INPUTS + s, "Strip " + strip + " right");
+			terminal_faders[s].setSpeed(fade_in);
+			post_fade_filters[s].setSlewSpeed(smooth_speed);
+			post_fade_filters[s].value = 1.f;
+		}
+		configInput(BUS_INPUT, "Bus chain");
+		configOutput(BUS_OUTPUT, "Bus chain");
+		light_divider.setDivision(240);
+		audition_divider.setDivision(512);
+		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
+		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, PAN_PARAMS, TERMINAL_STRIPS * 4);   // pans and levels
+		for (int i = 0; i < TERMINAL_STRIPS; i++) {
+			scene_memory.addFader(&terminal_faders[i], [this, i](bool on) {setOnState(i, on);});
+		}
+		automation.addParams(this, PAN_PARAMS, TERMINAL_STRIPS * 4);   // pans and levels
+		for (int i = 0; i < TERMINAL_STRIPS; i++) {
+			automation.addFader(&terminal_faders[i], [this, i](bool on) {setOnState(i, on);});
+		}
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
+	}
+
+	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
+
+		// process cv triggers
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			if (on_cv_triggers[s].process(inputs[ON_CV_INPUTS + s].getVoltage())) {
+				if (!auditions.isActive(AUDITION_MIXER, audition_group)) {
+					auto_override[s] = false;   // do not override automation
+					terminal_faders[s].on = !terminal_faders[s].on;
+				}
+			}
+		}
+
+		if (audition_divider.process()) {
+			bool group_changed = auditions.hasChanged(AUDITION_MIXER, audition_group, audition_epoch);
+			for (int s = 0; s < TERMINAL_STRIPS; s++) {
+				processAudition(s, group_changed);
+			}
+		}
+
+		// buttons, fades, post faders, pans, and levels once per block
+		if (block_i == 0) {
+			for (int s = 0; s < TERMINAL_STRIPS; s++) {
+				processButton(s);
+			}
+			setBlockTargets();
+		}
+		fade_ramps.process();
+		for (int side = 0; side < 2; side++) {
+			pan_ramps[side].process();
+		}
+		for (int sb = 0; sb < 3; sb++) {
+			level_ramps[sb].process();
+		}
+
+		// roll block position
+		block_i++;
+		if (block_i >= DSP_BLOCK_SIZE) block_i = 0;
+
+		// mix 4 strips at a time, silent blocks of strips are skipped
+		float_4 sums[6] = {};
+		for (int b = 0; b < TERMINAL_BLOCKS; b++) {
+			if (fade_ramps.isSilent(b)) {
+				meters[b].process(0.f);   // let the lights fall on skipped strips
+				continue;
+			}
+
+			float_4 stereo_in[2] = {};
+			for (int i = 0; i < 4; i++) {
+				int s = (b * 4) + i;
+				if (inputs[R_INPUTS + s].isConnected()) {   // get a channel from each cable input
+					stereo_in[0].s[i] = inputs[LMP_INPUTS + s].getVoltage();
+					stereo_in[1].s[i] = inputs[R_INPUTS + s].getVoltage();
+				} else {   // split mono or sum of polyphonic cable on LMP
+					stereo_in[0].s[i] = inputs[LMP_INPUTS + s].getVoltageSum();
+					stereo_in[1].s[i] = stereo_in[0].s[i];
+				}
+			}
+			stereo_in[0] *= pan_ramps[0].values[b] * fade_ramps.values[b];
+			stereo_in[1] *= pan_ramps[1].values[b] * fade_ramps.values[b];
+
+			for (int sb = 0; sb < 3; sb++) {
+				sums[sb * 2] += stereo_in[0] * level_ramps[sb].values[b];
+				sums[(sb * 2) + 1] += stereo_in[1] * level_ramps[sb].values[b];
+			}
+
+			// the louder side of red for the vu lights
+			float_4 red_left = simd::fabs(stereo_in[0] * level_ramps[2].values[b]);
+			float_4 red_right = simd::fabs(stereo_in[1] * level_ramps[2].values[b]);
+			meters[b].process(simd::fmax(red_left, red_right));
+		}
+
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
+
+		for (int c = 0; c < 6; c++) {
+			bus[c] += sums[c].s[0] + sums[c].s[1] + sums[c].s[2] + sums[c].s[3];
+		}
+
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
+
+		// set lights infrequently
+		if (light_divider.process()) {
+			for (int s = 0; s < TERMINAL_STRIPS; s++) {
+
+				// set on light
+				AutoFader &fader = terminal_faders[s];
+				if (fader.getFade() == fader.getGain()) {
+					if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+						lights[ON_LIGHTS + (s * 2)].value = 1.f;   // yellow when auditioned
+						lights[ON_LIGHTS + (s * 2) + 1].value = 1.f;
+					} else {
+						lights[ON_LIGHTS + (s * 2)].value = 1.f;   // green when on
+						lights[ON_LIGHTS + (s * 2) + 1].value = 0.f;
+					}
+				} else {
+					if (fader.temped) {
+						lights[ON_LIGHTS + (s * 2)].value = 0.f;   // red when muted by audition
+						lights[ON_LIGHTS + (s * 2) + 1].value = 1.f;
+					} else {
+						lights[ON_LIGHTS + (s * 2)].value = fader.getFade();   // yellow dimmer when fading
+						lights[ON_LIGHTS + (s * 2) + 1].value = fader.getFade() * 0.5f;
+					}
+				}
+			}
+		}
+	}
+
+	// on off button of a strip, stepped once per block
+	void processButton(int s) {
+		AutoFader &fader = terminal_faders[s];
+		switch (on_buttons[s].step(params[ON_PARAMS + s])) {
+		default:
+		case LongPressButton::NO_PRESS:
+			break;
+		case LongPressButton::SHORT_PRESS:
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+				auditions.stop(AUDITION_MIXER, audition_group);   // single click turns off auditions
+			} else {
+				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
+					auto_override[s] = true;
+					fader.setSpeed(bypass_speed);
+
+					// bypass the fade even if the fade is already underway
+					if (fader.on) {
+						fader.on = (fader.getFade() != fader.getGain());
+					} else {
+						fader.on = (fader.getFade() == 0.f);
+					}
+
+				} else {   // normal single click
+					auto_override[s] = false;   // do not override automation
+					fader.on = !fader.on;
+					if (fader.on) {
+						fader.setSpeed(int(fade_in));
+					} else {
+						fader.setSpeed(int(fade_out));
+					}
+				}
+			}
+			break;
+		case LongPressButton::LONG_PRESS:   // long press to audition
+
+			auditions.start(AUDITION_MIXER, audition_group);   // all mixers in the group to audition mode
+
+			if (auditioned[s]) {
+				auditioned[s] = false;
+				if (fader.temped) {
+					fader.on = false;
+					fader.temped = false;
+				}
+			} else {
+				auditioned[s] = true;
+				if (!fader.on) {
+					fader.temped = !fader.temped;   // remember if auditioned strip is off
+				}
+			}
+			break;
+		}
+	}
+
+	// audition state and fade speeds of a strip, same as a Gig Bus
+	void processAudition(int s, bool group_changed) {
+		AutoFader &fader = terminal_faders[s];
+		if (group_changed) {   // only when the group changes
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {   // all mixers are in audition state
+
+				// bypass all fade automation
+				auto_override[s] = true;
+				fader.setSpeed(bypass_speed);
+
+				if (auditioned[s]) {   // this strip is being auditioned
+					fader.on = true;
+				} else {   // mute the strips
+					if (fader.on) {
+						fader.temped = true;   // remember this strip was on
+					}
+					fader.on = false;
+				}
+			} else {   // stop auditions
+
+				// return to states before auditions
+				if (fader.temped) {
+					fader.temped = false;
+					auto_override[s] = true;
+					fader.setSpeed(bypass_speed);
+					if (auditioned[s]) {
+						fader.on = false;
+					} else {
+						fader.on = true;
+					}
+				}
+
+				// turn off auditions
+				auditioned[s] = false;
+			}
+		}
+
+		// process fade speed changes if dragging slider
+		if (!auto_override[s]) {
+			if (fader.on) {
+				if (int(fade_in) != fader.getFade()) {
+					fader.setSpeed(int(fade_in));
+				}
+			} else {
+				if (int(fade_out) != fader.getFade()) {
+					fader.setSpeed(int(fade_out));
+				}
+			}
+		}
+	}
+
+	// moves every strip's fade, post fader, pan, and levels to where they are at the end of the next block
+	void setBlockTargets() {
+		float gains[DSP_BLOCK_SIZE];
+		float fades[TERMINAL_STRIPS];
+		float pans[TERMINAL_STRIPS];
+		float levels[3][TERMINAL_STRIPS];
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			bool constant = terminal_faders[s].processBlock(gains, DSP_BLOCK_SIZE);
+			fades[s] = gains[constant ? 0 : DSP_BLOCK_SIZE - 1];
+
+			float red_level = params[LEVEL_PARAMS + (TERMINAL_STRIPS * 2) + s].getValue();
+			constant = post_fade_filters[s].slewBlock(post_fades ? red_level : 1.f, gains, DSP_BLOCK_SIZE);
+			float post_amount = gains[constant ? 0 : DSP_BLOCK_SIZE - 1];
+
+			// multiply blue and orange by the red master for post sends
+			for (int sb = 0; sb < 2; sb++) {
+				levels[sb][s] = params[LEVEL_PARAMS + (TERMINAL_STRIPS * sb) + s].getValue() * post_amount;
+			}
+			levels[2][s] = red_level;
+			pans[s] = params[PAN_PARAMS + s].getValue();
+		}
+
+		fade_ramps.setTargets(fades);
+		for (int sb = 0; sb < 3; sb++) {
+			level_ramps[sb].setTargets(levels[sb]);
+		}
+
+		float pan_levels[2][TERMINAL_STRIPS];
+		for (int b = 0; b < TERMINAL_BLOCKS; b++) {
+			float_4 left, right;
+			panLevels(pan_law, float_4::load(&pans[b * 4]), left, right);
+			left.store(&pan_levels[0][b * 4]);
+			right.store(&pan_levels[1][b * 4]);
+		}
+		for (int side = 0; side < 2; side++) {
+			pan_ramps[side].setTargets(pan_levels[side]);
+		}
+	}
+
+	// save on buttons and gain states
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			std::string strip = std::to_string(s + 1);
+			json_object_set_new(rootJ, ("input_on" + strip).c_str(), json_integer(terminal_faders[s].on));
+			json_object_set_new(rootJ, ("auditioned" + strip).c_str(), json_integer(auditioned[s]));
+			json_object_set_new(rootJ, ("temped" + strip).c_str(), json_integer(terminal_faders[s].temped));
+		}
+		json_object_set_new(rootJ, "post_fades", json_integer(post_fades));
+		json_object_set_new(rootJ, "gain", json_real(terminal_faders[0].getGain()));
+		json_object_set_new(rootJ, "pan_law", json_integer(pan_law));
+		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
+		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "fade_in", json_real(fade_in));
+		json_object_set_new(rootJ, "fade_out", json_real(fade_out));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "audition_mixer", json_integer(auditions.isActive(AUDITION_MIXER, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
+		return rootJ;
+	}
+
+	// load on buttons and gain states
+	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			std::string strip = std::to_string(s + 1);
+			json_t *input_onJ = json_object_get(rootJ, ("input_on" + strip).c_str());
+			if (input_onJ) terminal_faders[s].on = json_integer_value(input_onJ);
+			json_t *auditionedJ = json_object_get(rootJ, ("auditioned" + strip).c_str());
+			if (auditionedJ) auditioned[s] = json_integer_value(auditionedJ);
+			json_t *tempedJ = json_object_get(rootJ, ("temped" + strip).c_str());
+			if (tempedJ) terminal_faders[s].temped = json_integer_value(tempedJ);
+		}
+		json_t *post_fadesJ = json_object_get(rootJ, "post_fades");
+		if (post_fadesJ) post_fades = json_integer_value(post_fadesJ);
+		json_t *gainJ = json_object_get(rootJ, "gain");
+		if (gainJ) setGain((float)json_real_value(gainJ));
+		json_t *pan_lawJ = json_object_get(rootJ, "pan_law");
+		if (pan_lawJ) setPanLaw(json_integer_value(pan_lawJ));
+		json_t *fade_inJ = json_object_get(rootJ, "fade_in");
+		if (fade_inJ) fade_in = json_real_value(fade_inJ);
+		json_t *fade_outJ = json_object_get(rootJ, "fade_out");
+		if (fade_outJ) fade_out = json_real_value(fade_outJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
+		json_t *audition_mixerJ = json_object_get(rootJ, "audition_mixer");
+		if (audition_mixerJ) auditions.setActive(AUDITION_MIXER, audition_group, json_integer_value(audition_mixerJ));
+		json_t *use_default_themeJ = json_object_get(rootJ, "use_default_theme");
+		if (use_default_themeJ) use_default_theme = json_integer_value(use_default_themeJ);
+		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
+		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
+	}
+
+	// reset fader speeds with new sample rate, buttons are stepped once per block
+	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			on_buttons[s].setSampleRate(sample_rate / DSP_BLOCK_SIZE);
+			terminal_faders[s].setSampleRate(sample_rate);
+			post_fade_filters[s].setSampleRate(sample_rate);
+			if (terminal_faders[s].on) {
+				terminal_faders[s].setSpeed(fade_in);
+			} else {
+				terminal_faders[s].setSpeed(fade_out);
+			}
+		}
+		for (int b = 0; b < TERMINAL_BLOCKS; b++) {
+			meters[b].setSampleRate(sample_rate);
+		}
+	}
+
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
+	}
+
+	// reset on states on initialize
+	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			terminal_faders[s].on = true;
+			auditioned[s] = false;
+		}
+		setGain(1.f);
+		fade_in = 26.f;
+		fade_out = 26.f;
+		setFadeCurve(FADE_CURVE_EXP);
+		post_fades = true;
+		auditions.stop(AUDITION_MIXER, audition_group);
+		setAuditionGroup(0);
+		setPanLaw(PAN_LAW_3DB);
+	}
+
+	// on state of a strip from a scene or automation, turned like a single click of its on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(int s, bool on) {
+		AutoFader &fader = terminal_faders[s];
+		if (auditions.isActive(AUDITION_MIXER, audition_group) || on == fader.on) return;
+		auto_override[s] = false;   // do not override automation
+		fader.on = on;
+		if (on) {
+			fader.setSpeed(int(fade_in));
+		} else {
+			fader.setSpeed(int(fade_out));
+		}
+	}
+
+	// preamp gain on every strip
+	void setGain(float gain) {
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			terminal_faders[s].setGain(gain);
+		}
+	}
+
+	// pan law is read by the pan block in process()
+	void setPanLaw(int law) {
+		pan_law = law;
+	}
+
+	// set fade automation curve on every fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			terminal_faders[s].setCurve(curve);
+		}
+	}
+};
+
+
+struct BusTerminalWidget : ModuleWidget {
+	SvgPanel *night_panel;
+	int applied_theme = -1;
+
+	BusTerminalWidget(BusTerminal *module) {
+		setModule(module);
+		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/BusTerminal.svg")));
+
+		// load night panel if not preview
+#ifndef USING_CARDINAL_NOT_RACK
+		if (module)
+#endif
+		{
+			night_panel = new SvgPanel();
+			night_panel->setBackground(APP->window->loadSvg(asset::plugin(pluginInstance, "res/BusTerminal_Night.svg")));
+			night_panel->visible = false;
+			addChild(night_panel);
+		}
+
+		addChild(createThemedWidget<gtgScrewUp>(Vec(RACK_GRID_WIDTH, 0), module ? &module->color_theme : NULL));
+		addChild(createThemedWidget<gtgScrewUp>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0), module ? &module->color_theme : NULL));
+		addChild(createThemedWidget<gtgScrewUp>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH), module ? &module->color_theme : NULL));
+		addChild(createThemedWidget<gtgScrewUp>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH), module ? &module->color_theme : NULL));
+
+		// strips are 3 HP wide
+		for (int s = 0; s < TERMINAL_STRIPS; s++) {
+			float x = 7.62f + (s * 15.24f);
+			addParam(createThemedParamCentered<gtgBlackButton>(mm2px(Vec(x, 15.20)), module, BusTerminal::ON_PARAMS + s, module ? &module->color_theme : NULL));
+			addChild(createLightCentered<MediumLight<GreenRedLight>>(mm2px(Vec(x, 15.20)), module, BusTerminal::ON_LIGHTS + (s * 2)));
+			addInput(createThemedPortCentered<gtgKeyPort>(mm2px(Vec(x, 23.233)), true, module, BusTerminal::ON_CV_INPUTS + s, module ? &module->color_theme : NULL));
+			addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(x, 35.583)), true, module, BusTerminal::LMP_INPUTS + s, module ? &module->color_theme : NULL));
+			addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(x, 45.746)), true, module, BusTerminal::R_INPUTS + s, module ? &module->color_theme : NULL));
+			addParam(createThemedParamCentered<gtgGrayKnob>(mm2px(Vec(x, 58.5)), module, BusTerminal::PAN_PARAMS + s, module ? &module->color_theme : NULL));
+			addParam(createThemedParamCentered<gtgBlueTinyKnob>(mm2px(Vec(x - 3.6f, 69.7)), module, BusTerminal::LEVEL_PARAMS + s, module ? &module->color_theme : NULL));
+			addParam(createThemedParamCentered<gtgOrangeTinyKnob>(mm2px(Vec(x + 3.6f, 69.7)), module, BusTerminal::LEVEL_PARAMS + TERMINAL_STRIPS + s, module ? &module->color_theme : NULL));
+			addParam(createThemedParamCentered<gtgRedKnob>(mm2px(Vec(x, 81.5)), module, BusTerminal::LEVEL_PARAMS + (TERMINAL_STRIPS * 2) + s, module ? &module->color_theme : NULL));
+			addChild(createLightCentered<SmallLight<GreenRedLight>>(mm2px(Vec(x, 91.0)), module, BusTerminal::VU_LIGHTS + (s * 2)));
+		}
+
+		addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(114.3, 103.863)), true, module, BusTerminal::BUS_INPUT, module ? &module->color_theme : NULL));
+		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(114.3, 114.108)), false, module, BusTerminal::BUS_OUTPUT, module ? &module->color_theme : NULL));
+	}
+
+	// build the context menu
+	void appendContextMenu(Menu* menu) override {
+		BusTerminal* module = dynamic_cast<BusTerminal*>(this->module);
+
+		struct GainLevelItem : MenuItem {
+			BusTerminal* module;
+			float gain;
+			void onAction(const event::Action& e) override {
+				module->setGain(gain);
+			}
+		};
+
+		struct GainsItem : MenuItem {
+			BusTerminal *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string gain_titles[4] = {"No gain (default)", "2x gain", "4x gain", "8x gain"};
+				float gain_amounts[4] = {1.f, 2.f, 4.f, 8.f};
+				for (int i = 0; i < 4; i++) {
+					GainLevelItem *gain_item = new GainLevelItem;
+					gain_item->text = gain_titles[i];
+					gain_item->rightText = CHECKMARK(module->terminal_faders[0].getGain() == gain_amounts[i]);
+					gain_item->module = module;
+					gain_item->gain = gain_amounts[i];
+					menu->addChild(gain_item);
+				}
+				return menu;
+			}
+		};
+
+		// set post fader sends on blue and orange buses
+		struct PostFadeItem : MenuItem {
+			BusTerminal *module;
+			int post_fade;
+			void onAction(const event::Action &e) override {
+				module->post_fades = post_fade;
+			}
+		};
+
+		struct PostFadesItem : MenuItem {
+			BusTerminal *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string fade_titles[2] = {"Normal faders", "Post red fader sends (default)"};
+				int post_mode[2] = {0, 1};
+				for (int i = 0; i < 2; i++) {
+					PostFadeItem *post_item = new PostFadeItem;
+					post_item->text = fade_titles[i];
+					post_item->rightText = CHECKMARK(module->post_fades == post_mode[i]);
+					post_item->module = module;
+					post_item->post_fade = post_mode[i];
+					menu->addChild(post_item);
+				}
+				return menu;
+			}
+		};
+
+		struct ThemeItem : MenuItem {
+			BusTerminal* module;
+			int theme;
+			void onAction(const event::Action& e) override {
+				if (theme == 10) {
+					module->use_default_theme = true;
+					module->color_theme = gtg_default_theme;
+				} else {
+					module->use_default_theme = false;
+					module->color_theme = theme;
+				}
+			}
+		};
+
+		struct DefaultThemeItem : MenuItem {
+			BusTerminal* module;
+			int theme;
+			void onAction(const event::Action &e) override {
+				gtg_default_theme = theme;
+				saveGtgPluginDefault("default_theme", theme);
+			}
+		};
+
+		struct ThemesItem : MenuItem {
+			BusTerminal *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string theme_titles[3] = {"Default", "70's Cream", "Night Ride"};
+				int theme_selected[3] = {10, 0, 1};
+				for (int i = 0; i < 3; i++) {
+					ThemeItem *theme_item = new ThemeItem;
+					theme_item->text = theme_titles[i];
+					if (i == 0) {
+						theme_item->rightText = CHECKMARK(module->use_default_theme);
+					} else {
+						if (!module->use_default_theme) {
+							theme_item->rightText = CHECKMARK(module->color_theme == theme_selected[i]);
+						}
+					}
+					theme_item->module = module;
+					theme_item->theme = theme_selected[i];
+					menu->addChild(theme_item);
+				}
+				menu->addChild(new MenuEntry);
+				std::string default_theme_titles[2] = {"Default to 70's Cream", "Default to Night Ride"};
+				for (int i = 0; i < 2; i++) {
+					DefaultThemeItem *default_theme_item = new DefaultThemeItem;
+					default_theme_item->text = default_theme_titles[i];
+					default_theme_item->rightText = CHECKMARK(gtg_default_theme == i);
+					default_theme_item->module = module;
+					default_theme_item->theme = i;
+					menu->addChild(default_theme_item);
+				}
+				return menu;
+			}
+		};
+
+		// fade automation
+		menu->addChild(new MenuEntry);
+		menu->addChild(createMenuLabel("Fade Automation"));
+
+		FadeSliderItem *fadeInSliderItem = new FadeSliderItem(&(module->fade_in), "In");
+		fadeInSliderItem->box.size.x = 190.f;
+		menu->addChild(fadeInSliderItem);
+
+		FadeSliderItem *fadeOutSliderItem = new FadeSliderItem(&(module->fade_out), "Out");
+		fadeOutSliderItem->box.size.x = 190.f;
+		menu->addChild(fadeOutSliderItem);
+
+		FadeCurvesItem<BusTerminal> *fadeCurvesItem = createMenuItem<FadeCurvesItem<BusTerminal>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<BusTerminal> *automationItem = createMenuItem<AutomationItem<BusTerminal>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
+		// mixer settings
+		menu->addChild(new MenuEntry);
+		menu->addChild(createMenuLabel("Mixer Settings"));
+
+		GainsItem *gainsItem = createMenuItem<GainsItem>("Preamps on L/M/P/R Inputs");
+		gainsItem->rightText = RIGHT_ARROW;
+		gainsItem->module = module;
+		menu->addChild(gainsItem);
+
+		PanLawsItem<BusTerminal> *panLawsItem = createMenuItem<PanLawsItem<BusTerminal>>("Pan Law");
+		panLawsItem->rightText = RIGHT_ARROW;
+		panLawsItem->module = module;
+		menu->addChild(panLawsItem);
+
+		PostFadesItem *postFadesItem = createMenuItem<PostFadesItem>("Blue and Orange Levels");
+		postFadesItem->rightText = RIGHT_ARROW;
+		postFadesItem->module = module;
+		menu->addChild(postFadesItem);
+
+		BusLinkItem<BusTerminal> *busLinkItem = createMenuItem<BusLinkItem<BusTerminal>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<BusTerminal> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<BusTerminal>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
+#ifndef USING_CARDINAL_NOT_RACK
+		menu->addChild(new MenuEntry);
+
+		ThemesItem *themesItem = createMenuItem<ThemesItem>("Panel Themes");
+		themesItem->rightText = RIGHT_ARROW;
+		themesItem->module = module;
+		menu->addChild(themesItem);
+#endif
+	}
+
+	// retheme the panel and components only when the theme changes
+	void step() override {
+		if (module) {
+			BusTerminal *bus_terminal = (BusTerminal*)module;
+			if (bus_terminal->use_default_theme) {
+				bus_terminal->color_theme = gtg_default_theme;
+			}
+
+			// green vu lights, and red peak lights that stay on when hit
+			for (int s = 0; s < TERMINAL_STRIPS; s++) {
+				gtgMeter &meter = bus_terminal->meters[s >> 2];
+				if ((s & 3) == 0) meter.update();
+				bus_terminal->lights[BusTerminal::VU_LIGHTS + (s * 2)].setBrightness(meter.getBrightness(s & 3, -36.f, 0.f));
+				bus_terminal->lights[BusTerminal::VU_LIGHTS + (s * 2) + 1].setBrightness(meter.getPeakHold(s & 3));
+			}
+
+			if (bus_terminal->color_theme != applied_theme) {
+				applied_theme = bus_terminal->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
+#ifdef USING_CARDINAL_NOT_RACK
+		Widget* panel = getPanel();
+		panel->visible = !settings::preferDarkPanels;
+		night_panel->visible = settings::preferDarkPanels;
+#endif
+		Widget::step();
+	}
+};
+
+
+Model *modelBusTerminal = createModel<BusTerminal, BusTerminalWidget>("BusTerminal");
@@ -1,5 +1,7 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
+#include "gtgBus.hpp"
+#include "gtgScenes.hpp"
 
 
 struct EnterBus : Module {
@@ -20,10 +22,10 @@ struct EnterBus : Module {
 		NUM_LIGHTS
 	};
 
-	dsp::ClockDivider housekeeping_divider;
-
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	BusLink bus_link;
 
 	EnterBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -38,41 +40,44 @@ struct EnterBus : Module {
 		configInput(ENTER_INPUTS + 5, "Red right");
 		configInput(BUS_INPUT, "Bus chain");
 		configOutput(BUS_OUTPUT, "Bus chain");
-		housekeeping_divider.setDivision(50000);
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, LEVEL_PARAMS, 3);
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
 
-		if (housekeeping_divider.process()) {
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-		}
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
 
 		// process all inputs and levels to bus
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 0].getVoltage() * params[LEVEL_PARAMS + 0].getValue()) + inputs[BUS_INPUT].getPolyVoltage(0), 0);
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 1].getVoltage() * params[LEVEL_PARAMS + 0].getValue()) + inputs[BUS_INPUT].getPolyVoltage(1), 1);
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 2].getVoltage() * params[LEVEL_PARAMS + 1].getValue()) + inputs[BUS_INPUT].getPolyVoltage(2), 2);
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 3].getVoltage() * params[LEVEL_PARAMS + 1].getValue()) + inputs[BUS_INPUT].getPolyVoltage(3), 3);
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 4].getVoltage() * params[LEVEL_PARAMS + 2].getValue()) + inputs[BUS_INPUT].getPolyVoltage(4), 4);
-		outputs[BUS_OUTPUT].setVoltage((inputs[ENTER_INPUTS + 5].getVoltage() * params[LEVEL_PARAMS + 2].getValue()) + inputs[BUS_INPUT].getPolyVoltage(5), 5);
-
-		// set output to 3 stereo buses
-		outputs[BUS_OUTPUT].setChannels(6);
+		for (int c = 0; c < 6; c++) {
+			bus[c] += inputs[ENTER_INPUTS + c].getVoltage() * params[LEVEL_PARAMS + (c / 2)].getValue();
+		}
+
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
 	}
 
 	// save color theme
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
 		return rootJ;
 	}
 
 	// load color theme
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
 		json_t *use_default_themeJ = json_object_get(rootJ, "use_default_theme");
@@ -81,11 +86,16 @@ struct EnterBus : Module {
 		} else {
 			if (color_themeJ) use_default_theme = false;   // do not change existing patches
 		}
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 };
 
 struct EnterBusWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	EnterBusWidget(EnterBus *module) {
 		setModule(module);
@@ -120,7 +130,6 @@ struct EnterBusWidget : ModuleWidget {
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.62, 114.107)), false, module, EnterBus::BUS_OUTPUT, module ? &module->color_theme : NULL));
 	}
 
-#ifndef USING_CARDINAL_NOT_RACK
 	// build the menu
 	void appendContextMenu(Menu* menu) override {
 		EnterBus* module = dynamic_cast<EnterBus*>(this->module);
@@ -184,25 +193,45 @@ struct EnterBusWidget : ModuleWidget {
 
 		menu->addChild(new MenuEntry);
 
+		BusLinkItem<EnterBus> *busLinkItem = createMenuItem<BusLinkItem<EnterBus>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+#ifndef USING_CARDINAL_NOT_RACK
+		menu->addChild(new MenuEntry);
+
 		ThemesItem *themesItem = createMenuItem<ThemesItem>("Panel Themes");
 		themesItem->rightText = RIGHT_ARROW;
 		themesItem->module = module;
 		menu->addChild(themesItem);
-	}
 #endif
+	}
 
-	// display the panel based on the theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			EnterBus *enter_bus = (EnterBus*)module;
+			if (enter_bus->use_default_theme) {
+				enter_bus->color_theme = gtg_default_theme;
+			}
+			if (enter_bus->color_theme != applied_theme) {
+				applied_theme = enter_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((EnterBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((EnterBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
@@ -1,5 +1,8 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
+#include "gtgBus.hpp"
+#include "gtgRecorder.hpp"
+#include <osdialog.h>
 
 
 struct ExitBus : Module {
@@ -19,10 +22,14 @@ struct ExitBus : Module {
 		NUM_LIGHTS
 	};
 
-	dsp::ClockDivider housekeeping_divider;
-
 	int color_theme = 0;
 	bool use_default_theme = true;
+	int wide_bus = 0;   // 0 for the 3 bus cable, or the first of the 3 wide buses to exit
+	StemRecorder recorder;
+	std::string record_path;
+	int record_format = RECORDER_WAV;
+	int record_layout = RECORDER_ONE_FILE;
+	BusLatencyRequest latency_request;
 
 	ExitBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -34,34 +41,44 @@ struct ExitBus : Module {
 		configOutput(EXIT_OUTPUTS + 4, "Red left");
 		configOutput(EXIT_OUTPUTS + 5, "Red right");
 		configOutput(BUS_OUTPUT, "Bus chain");
-		housekeeping_divider.setDivision(50000);
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		latency_request.setup(this, BUS_INPUT, 1, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
 
-		if (housekeeping_divider.process()) {
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
+		if (wide_bus > 0) {
+			processBus<WIDE_BUSES>();
+		} else {
+			processBus<3>();
 		}
+	}
 
-		// set output to 3 stereo buses
-		outputs[BUS_OUTPUT].setChannels(6);
+	// exits 3 stereo buses and passes the whole bus on, with one more sample of latency on the chain
+	template <int BUSES>
+	void processBus() {
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = BusCable<BUSES>::read(inputs[BUS_INPUT], bus_chain);
 
-		// process all inputs and outputs
+		int bank_channel = wide_bus > 0 ? (wide_bus - 1) * 2 : 0;
 		for (int c = 0; c < 6; c++) {
-			outputs[EXIT_OUTPUTS + c].setVoltage(inputs[BUS_INPUT].getPolyVoltage(c));
-			outputs[BUS_OUTPUT].setVoltage(inputs[BUS_INPUT].getPolyVoltage(c), c);
+			outputs[EXIT_OUTPUTS + c].setVoltage(bus_chain[bank_channel + c]);
 		}
+		recorder.push(&bus_chain[bank_channel]);
+
+		BusCable<BUSES>::write(outputs[BUS_OUTPUT], bus_chain, chain_latency + 1, latency_request.isRequested());
 	}
 
 	// save color theme
 	json_t *dataToJson() override {
 		json_t *rootJ = json_object();
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "wide_bus", json_integer(wide_bus));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
+		json_object_set_new(rootJ, "record_path", json_string(record_path.c_str()));
+		json_object_set_new(rootJ, "record_format", json_integer(record_format));
+		json_object_set_new(rootJ, "record_layout", json_integer(record_layout));
 		return rootJ;
 	}
 
@@ -74,12 +91,46 @@ struct ExitBus : Module {
 			use_default_theme = json_integer_value(use_default_themeJ);
 		} else {
 			if (color_themeJ) use_default_theme = false;   // do not change existing patches
-		}	}
+		}
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) wide_bus = json_integer_value(wide_busJ);
+		json_t *record_pathJ = json_object_get(rootJ, "record_path");
+		if (record_pathJ) record_path = json_string_value(record_pathJ);
+		json_t *record_formatJ = json_object_get(rootJ, "record_format");
+		if (record_formatJ) record_format = clamp((int)json_integer_value(record_formatJ), 0, NUM_RECORDER_FORMATS - 1);
+		json_t *record_layoutJ = json_object_get(rootJ, "record_layout");
+		if (record_layoutJ) record_layout = clamp((int)json_integer_value(record_layoutJ), 0, NUM_RECORDER_LAYOUTS - 1);
+	}
+
+	// a recording is made at one sample rate, so it ends when the rate changes
+	// the engine holds its lock here, so the writer is only asked to stop and is joined later from the ui
+	void onSampleRateChange() override {
+		recorder.requestStop();
+	}
+
+	void onReset() override {
+		recorder.requestStop();
+		record_format = RECORDER_WAV;
+		record_layout = RECORDER_ONE_FILE;
+	}
+
+	// keep the file extension in step with the format
+	void setRecordFormat(int format) {
+		record_format = format;
+		if (record_path.empty()) return;
+		std::string extension = system::getExtension(record_path);
+		record_path = record_path.substr(0, record_path.size() - extension.size()) + ((record_format == RECORDER_W64) ? ".w64" : ".wav");
+	}
+
+	void startRecording() {
+		if (!record_path.empty()) recorder.start(record_path, record_format, record_layout, APP->engine->getSampleRate());
+	}
 };
 
 
 struct ExitBusWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	ExitBusWidget(ExitBus *module) {
 		setModule(module);
@@ -110,7 +161,6 @@ struct ExitBusWidget : ModuleWidget {
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.62, 114.107)), false, module, ExitBus::BUS_OUTPUT, module ? &module->color_theme : NULL));
 	}
 
-#ifndef USING_CARDINAL_NOT_RACK
 	// build the menu
 	void appendContextMenu(Menu* menu) override {
 		ExitBus* module = dynamic_cast<ExitBus*>(this->module);
@@ -172,27 +222,152 @@ struct ExitBusWidget : ModuleWidget {
 			}
 		};
 
+		struct RecordFileItem : MenuItem {
+			ExitBus *module;
+			void onAction(const event::Action &e) override {
+				std::string dir = module->record_path.empty() ? asset::user("") : system::getDirectory(module->record_path);
+				std::string name = module->record_path.empty() ? "stems" : system::getFilename(module->record_path);
+				osdialog_filters *filters = osdialog_filters_parse((module->record_format == RECORDER_W64) ? "Wave64:w64" : "WAV:wav");
+				char *pathC = osdialog_file(OSDIALOG_SAVE, dir.c_str(), name.c_str(), filters);
+				osdialog_filters_free(filters);
+				if (!pathC) return;
+				module->record_path = pathC;
+				std::free(pathC);
+				module->setRecordFormat(module->record_format);
+			}
+		};
+
+		struct RecordFormatItem : MenuItem {
+			ExitBus *module;
+			int format;
+			void onAction(const event::Action &e) override {
+				module->setRecordFormat(format);
+			}
+		};
+
+		struct RecordLayoutItem : MenuItem {
+			ExitBus *module;
+			int layout;
+			void onAction(const event::Action &e) override {
+				module->record_layout = layout;
+			}
+		};
+
+		struct RecordSettingsItem : MenuItem {
+			ExitBus *module;
+			Menu *createChildMenu() override {
+				Menu *menu = new Menu;
+				std::string format_titles[NUM_RECORDER_FORMATS] = {"WAV, 32 bit float (default)", "W64, 32 bit float, over 4 GB"};
+				for (int i = 0; i < NUM_RECORDER_FORMATS; i++) {
+					RecordFormatItem *record_format_item = new RecordFormatItem;
+					record_format_item->text = format_titles[i];
+					record_format_item->rightText = CHECKMARK(module->record_format == i);
+					record_format_item->disabled = module->recorder.isRecording();
+					record_format_item->module = module;
+					record_format_item->format = i;
+					menu->addChild(record_format_item);
+				}
+				menu->addChild(new MenuEntry);
+				std::string layout_titles[NUM_RECORDER_LAYOUTS] = {"One 6 channel file (default)", "A stereo file for each bus"};
+				for (int i = 0; i < NUM_RECORDER_LAYOUTS; i++) {
+					RecordLayoutItem *record_layout_item = new RecordLayoutItem;
+					record_layout_item->text = layout_titles[i];
+					record_layout_item->rightText = CHECKMARK(module->record_layout == i);
+					record_layout_item->disabled = module->recorder.isRecording();
+					record_layout_item->module = module;
+					record_layout_item->layout = i;
+					menu->addChild(record_layout_item);
+				}
+				return menu;
+			}
+		};
+
+		struct RecordItem : MenuItem {
+			ExitBus *module;
+			void onAction(const event::Action &e) override {
+				if (module->recorder.isRecording()) {
+					module->recorder.stop();
+				} else {
+					module->startRecording();
+				}
+			}
+		};
+
+		// recording time and losses, updated live while the menu is open
+		struct RecordStatusLabel : MenuLabel {
+			ExitBus *module;
+			void step() override {
+				StemRecorder &recorder = module->recorder;
+				if (recorder.write_failed.load()) {
+					text = "Could not write the file";
+				} else {
+					int seconds = recorder.getSeconds();
+					text = string::f("%d:%02d:%02d recorded, %u ring overruns, %llu dropped frames", seconds / 3600, (seconds / 60) % 60, seconds % 60,
+						recorder.overruns.load(), (unsigned long long)recorder.dropped_frames.load());
+				}
+				MenuLabel::step();
+			}
+		};
+
+		menu->addChild(new MenuEntry);
+		menu->addChild(createMenuLabel("Stem Recorder"));
+
+		RecordFileItem *recordFileItem = createMenuItem<RecordFileItem>("Record to", module->record_path.empty() ? "choose file" : system::getFilename(module->record_path));
+		recordFileItem->disabled = module->recorder.isRecording();
+		recordFileItem->module = module;
+		menu->addChild(recordFileItem);
+
+		RecordSettingsItem *recordSettingsItem = createMenuItem<RecordSettingsItem>("File Format");
+		recordSettingsItem->rightText = RIGHT_ARROW;
+		recordSettingsItem->module = module;
+		menu->addChild(recordSettingsItem);
+
+		RecordItem *recordItem = createMenuItem<RecordItem>(module->recorder.isRecording() ? "Stop Recording" : "Start Recording");
+		recordItem->disabled = module->record_path.empty();
+		recordItem->module = module;
+		menu->addChild(recordItem);
+
+		RecordStatusLabel *recordStatusLabel = new RecordStatusLabel;
+		recordStatusLabel->module = module;
+		menu->addChild(recordStatusLabel);
+
+		menu->addChild(new MenuEntry);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->wide_bus;
+		menu->addChild(wideBusesItem);
+
+#ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
 		ThemesItem *themesItem = createMenuItem<ThemesItem>("Panel Themes");
 		themesItem->rightText = RIGHT_ARROW;
 		themesItem->module = module;
 		menu->addChild(themesItem);
-	}
 #endif
+	}
 
-	// display the panel based on the theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			ExitBus *exit_bus = (ExitBus*)module;
+			if (exit_bus->use_default_theme) {
+				exit_bus->color_theme = gtg_default_theme;
+			}
+			if (exit_bus->color_theme != applied_theme) {
+				applied_theme = exit_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((ExitBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((ExitBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
@@ -1,6 +1,11 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
 
 
 struct GigBus : Module {
@@ -28,14 +33,11 @@ struct GigBus : Module {
 		NUM_LIGHTS
 	};
 
-	dsp::VuMeter2 vu_meters[2];
-    dsp::ClockDivider housekeeping_divider;
-	dsp::ClockDivider vu_divider;
+	gtgMeter meter;
 	dsp::ClockDivider light_divider;
 	dsp::ClockDivider audition_divider;
 	LongPressButton on_button;
 	dsp::SchmittTrigger on_cv_trigger;
-	dsp::ClockDivider pan_divider;
 	AutoFader gig_fader;
 	ConstantPan gig_pan;
 	SimpleSlewer post_fade_filter;
@@ -44,12 +46,25 @@ struct GigBus : Module {
 	const int smooth_speed = 26;
 	float fade_in = 26.f;
 	float fade_out = 26.f;
+	int fade_curve = FADE_CURVE_EXP;
 	bool auto_override = false;
 	bool post_fades = true;
 	bool auditioned = false;
-	float peak_stereo[2] = {0.f, 0.f};
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
+	int pan_law = PAN_LAW_3DB;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	BusLink bus_link;
+	int block_i = 0;   // sample position in block ramps
+	float fade_gains[DSP_BLOCK_SIZE] = {};
+	float post_gains[DSP_BLOCK_SIZE] = {};
+	float pan_levels[2][DSP_BLOCK_SIZE] = {};
+	bool fade_constant = true;
+	bool post_constant = true;
+	bool pan_constant = true;
 
 	GigBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -63,30 +78,23 @@ struct GigBus : Module {
 		configInput(R_INPUT, "Right");
 		configInput(BUS_INPUT, "Bus chain");
 		configOutput(BUS_OUTPUT, "Bus chain");
-		vu_meters[0].lambda = 25.f;
-		vu_meters[1].lambda = 25.f;
-		housekeeping_divider.setDivision(50000);
-		vu_divider.setDivision(32);
 		light_divider.setDivision(240);
 		audition_divider.setDivision(512);
-		pan_divider.setDivision(3);
 		gig_fader.setSpeed(fade_in);
 		post_fade_filter.setSlewSpeed(smooth_speed);
 		post_fade_filter.value = 1.f;
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, PAN_PARAM, 4);   // pan and levels
+		scene_memory.addFader(&gig_fader, [this](bool on) {setOnState(on);});
+		automation.addParams(this, PAN_PARAM, 4);   // pan and levels
+		automation.addFader(&gig_fader, [this](bool on) {setOnState(on);});
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
-
-		// check default theme and reset vu meters
-		if (housekeeping_divider.process()) {
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-			vu_meters[0].v = 0.f;
-			vu_meters[1].v = 0.f;
-		}
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
 
 		// on off button
 		switch (on_button.step(params[ON_PARAM])) {
@@ -94,8 +102,8 @@ struct GigBus : Module {
 		case LongPressButton::NO_PRESS:
 			break;
 		case LongPressButton::SHORT_PRESS:
-			if (audition_mixer) {
-				audition_mixer = false;   // single click turns off auditions
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+				auditions.stop(AUDITION_MIXER, audition_group);   // single click turns off auditions
 			} else {
 				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
 					auto_override = true;
@@ -121,7 +129,7 @@ struct GigBus : Module {
 			break;
 		case LongPressButton::LONG_PRESS:   // long press to audition
 
-			audition_mixer = true;   // all mixers to audition mode
+			auditions.start(AUDITION_MIXER, audition_group);   // all mixers in the group to audition mode
 
 			if (auditioned) {
 				auditioned = false;
@@ -140,45 +148,45 @@ struct GigBus : Module {
 
 		// process cv trigger
 		if (on_cv_trigger.process(inputs[ON_CV_INPUT].getVoltage())) {
-			if (!audition_mixer) {
+			if (!auditions.isActive(AUDITION_MIXER, audition_group)) {
 				auto_override = false;   // do not override automation
 				gig_fader.on = !gig_fader.on;
 			}
 		}
 
-		gig_fader.process();
-
 		if (audition_divider.process()) {
-			if (audition_mixer) {   // all mixers are in audition state
-
-				// bypass all fade automation
-				auto_override = true;
-				gig_fader.setSpeed(bypass_speed);
+			if (auditions.hasChanged(AUDITION_MIXER, audition_group, audition_epoch)) {   // only when the group changes
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {   // all mixers are in audition state
 
-				if (auditioned) {   // this mixer is being auditioned
-					gig_fader.on =  true;
-				} else {   // mute the mixers
-					if (gig_fader.on) {
-						gig_fader.temped = true;   // remember this mixer was on
-					}
-					gig_fader.on = false;
-				}
-			} else {   // stop auditions
-
-				// return to states before auditions
-				if (gig_fader.temped) {
-					gig_fader.temped = false;
+					// bypass all fade automation
 					auto_override = true;
 					gig_fader.setSpeed(bypass_speed);
-					if (auditioned) {
+
+					if (auditioned) {   // this mixer is being auditioned
+						gig_fader.on =  true;
+					} else {   // mute the mixers
+						if (gig_fader.on) {
+							gig_fader.temped = true;   // remember this mixer was on
+						}
 						gig_fader.on = false;
-					} else {
-						gig_fader.on = true;
 					}
-				}
+				} else {   // stop auditions
+
+					// return to states before auditions
+					if (gig_fader.temped) {
+						gig_fader.temped = false;
+						auto_override = true;
+						gig_fader.setSpeed(bypass_speed);
+						if (auditioned) {
+							gig_fader.on = false;
+						} else {
+							gig_fader.on = true;
+						}
+					}
 
-				// turn off auditions
-				auditioned = false;
+					// turn off auditions
+					auditioned = false;
+				}
 			}
 
 			// process fade speed changes if dragging slider
@@ -195,69 +203,59 @@ struct GigBus : Module {
 			}
 		}
 
+		// calculate fade, post fader, and pan ramps once per block
+		if (block_i == 0) {
+			fade_constant = gig_fader.processBlock(fade_gains, DSP_BLOCK_SIZE);
+			if (post_fades) {
+				post_constant = post_fade_filter.slewBlock(params[LEVEL_PARAMS + 2].getValue(), post_gains, DSP_BLOCK_SIZE);
+			} else {
+				post_constant = post_fade_filter.slewBlock(1.f, post_gains, DSP_BLOCK_SIZE);
+			}
+			pan_constant = gig_pan.levelsBlock(params[PAN_PARAM].getValue(), pan_levels[0], pan_levels[1], DSP_BLOCK_SIZE);
+		}
+		float exp_fade = fade_gains[fade_constant ? 0 : block_i];
+		float post_amount = post_gains[post_constant ? 0 : block_i];
+		int pan_i = pan_constant ? 0 : block_i;
+		float pan_left = pan_levels[0][pan_i] * exp_fade;
+		float pan_right = pan_levels[1][pan_i] * exp_fade;
+
+		// roll block position
+		block_i++;
+		if (block_i >= DSP_BLOCK_SIZE) block_i = 0;
+
 		// define input levels
 		float in_levels[3] = {0.f, 0.f, 0.f};
 
 		// get red level
 		in_levels[2] = params[LEVEL_PARAMS + 2].getValue();   // master red level
 
-		// slew a post fader level if needed
-		float post_amount = 1.f;
-		if (post_fades) {
-			post_amount = post_fade_filter.slew(in_levels[2]);
-		} else {
-			post_amount = post_fade_filter.slew(1.f);
-		}
-
 		// get orange and blue levels
 		for (int sb = 0; sb < 2; sb++) {   // send levels
 			in_levels[sb] = params[LEVEL_PARAMS + sb].getValue() * post_amount;   // multiply by master for post send levels
 		}
 
-		// get stereo pan levels
-		if (pan_divider.process()) {   // optimized by checking pan every few samples
-			gig_pan.setPan(params[PAN_PARAM].getValue());
-		}
-
-		// get exponential fade
-		float exp_fade = 0.f;
-		if (gig_fader.fading) {
-			exp_fade = gig_fader.getExpFade(2.5);
-		} else {
-			exp_fade = gig_fader.getFade();
-		}
-
-		// process inputs
+		// process inputs, silent inputs are skipped
 		float stereo_in[2] = {0.f, 0.f};
-		if (inputs[R_INPUT].isConnected()) {   // get a channel from each cable input
-			stereo_in[0] = inputs[LMP_INPUT].getVoltage() * gig_pan.getLevel(0) * exp_fade;
-			stereo_in[1] = inputs[R_INPUT].getVoltage() * gig_pan.getLevel(1) * exp_fade;
-		} else {   // split mono or sum of polyphonic cable on LMP
-			float lmp_in = inputs[LMP_INPUT].getVoltageSum();
-			for (int c = 0; c < 2; c++) {
-				stereo_in[c] = lmp_in * gig_pan.getLevel(c) * exp_fade;
+		if (!fade_constant || exp_fade > 0.f) {
+			if (inputs[R_INPUT].isConnected()) {   // get a channel from each cable input
+				stereo_in[0] = inputs[LMP_INPUT].getVoltage() * pan_left;
+				stereo_in[1] = inputs[R_INPUT].getVoltage() * pan_right;
+			} else {   // split mono or sum of polyphonic cable on LMP
+				float lmp_in = inputs[LMP_INPUT].getVoltageSum();
+				stereo_in[0] = lmp_in * pan_left;
+				stereo_in[1] = lmp_in * pan_right;
 			}
 		}
 
-		// check for peaks on red
-		for (int c = 0; c < 2; c++) {
-			if (stereo_in[c] * in_levels[2] > 10.f) peak_stereo[c] = 1.f;
-		}
-
-		// get levels for lights
-		if (vu_divider.process()) {   // check levels for lights infrequently
-			for (int i = 0; i < 2; i++) {
-				float red_level = stereo_in[i] * in_levels[2];
-				vu_meters[i].process(args.sampleTime * vu_divider.getDivision(), red_level / 10.f);
-			}
-		}
+		// red levels for the vu lights
+		meter.processStereo(stereo_in[0] * in_levels[2], stereo_in[1] * in_levels[2]);
 
 		// set lights infrequently
 		if (light_divider.process()) {   // set lights infrequently
 
 			// set on light
 			if (gig_fader.getFade() == gig_fader.getGain()) {
-				if (audition_mixer) {
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {
 					lights[ON_LIGHT + 0].value = 1.f;   // yellow when auditioned
 					lights[ON_LIGHT + 1].value = 1.f;
 				} else {
@@ -273,41 +271,23 @@ struct GigBus : Module {
 					lights[ON_LIGHT + 1].value = gig_fader.getFade() * 0.5f;
 				}
 			}
-
-			// make peak lights stay on when hit
-			for (int c = 0; c < 2; c++) {
-				if (peak_stereo[c] > 0) peak_stereo[c] -= 120.f / args.sampleRate; else peak_stereo[c] = 0.f;
-			}
-			lights[LEFT_LIGHTS + 0].setBrightness(peak_stereo[0]);
-			lights[RIGHT_LIGHTS + 0].setBrightness(peak_stereo[1]);
-
-			// green and yellow vu lights
-			for (int i = 1; i < 6; i++) {
-				lights[LEFT_LIGHTS + i].setBrightness(vu_meters[0].getBrightness((-3 * i), -3 * (i - 1)));
-				lights[RIGHT_LIGHTS + i].setBrightness(vu_meters[1].getBrightness((-3 * i), -3 * (i - 1)));
-			}
-			lights[LEFT_LIGHTS + 6].setBrightness(vu_meters[0].getBrightness(-19, -15));
-			lights[RIGHT_LIGHTS + 6].setBrightness(vu_meters[1].getBrightness(-19, -15));
-			lights[LEFT_LIGHTS + 7].setBrightness(vu_meters[0].getBrightness(-24, -19));
-			lights[RIGHT_LIGHTS + 7].setBrightness(vu_meters[1].getBrightness(-24, -19));
-			lights[LEFT_LIGHTS + 8].setBrightness(vu_meters[0].getBrightness(-30, -24));
-			lights[RIGHT_LIGHTS + 8].setBrightness(vu_meters[1].getBrightness(-30, -24));
-			lights[LEFT_LIGHTS + 9].setBrightness(vu_meters[0].getBrightness(-36, -28));
-			lights[RIGHT_LIGHTS + 9].setBrightness(vu_meters[1].getBrightness(-36, -28));
-			lights[LEFT_LIGHTS + 10].setBrightness(vu_meters[0].getBrightness(-48, -36));
-			lights[RIGHT_LIGHTS + 10].setBrightness(vu_meters[1].getBrightness(-48, -36));
 		}
 
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
+
 		// process outputs
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[0] * in_levels[0]) + inputs[BUS_INPUT].getPolyVoltage(0), 0);
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[1] * in_levels[0]) + inputs[BUS_INPUT].getPolyVoltage(1), 1);
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[0] * in_levels[1]) + inputs[BUS_INPUT].getPolyVoltage(2), 2);
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[1] * in_levels[1]) + inputs[BUS_INPUT].getPolyVoltage(3), 3);
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[0] * in_levels[2]) + inputs[BUS_INPUT].getPolyVoltage(4), 4);
-		outputs[BUS_OUTPUT].setVoltage((stereo_in[1] * in_levels[2]) + inputs[BUS_INPUT].getPolyVoltage(5), 5);
-
-		// set bus outputs for 3 stereo buses out
-		outputs[BUS_OUTPUT].setChannels(6);
+		bus[0] += stereo_in[0] * in_levels[0];
+		bus[1] += stereo_in[1] * in_levels[0];
+		bus[2] += stereo_in[0] * in_levels[1];
+		bus[3] += stereo_in[1] * in_levels[1];
+		bus[4] += stereo_in[0] * in_levels[2];
+		bus[5] += stereo_in[1] * in_levels[2];
+
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
 	}
 
 	// save on button and gain states
@@ -316,33 +296,50 @@ struct GigBus : Module {
 		json_object_set_new(rootJ, "input_on", json_integer(gig_fader.on));
 		json_object_set_new(rootJ, "post_fades", json_integer(post_fades));
 		json_object_set_new(rootJ, "gain", json_real(gig_fader.getGain()));
+		json_object_set_new(rootJ, "pan_law", json_integer(pan_law));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
 		json_object_set_new(rootJ, "fade_in", json_real(fade_in));
 		json_object_set_new(rootJ, "fade_out", json_real(fade_out));
-		json_object_set_new(rootJ, "audition_mixer", json_integer(audition_mixer));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "audition_mixer", json_integer(auditions.isActive(AUDITION_MIXER, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
 		json_object_set_new(rootJ, "auditioned", json_integer(auditioned));
 		json_object_set_new(rootJ, "temped", json_integer(gig_fader.temped));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
 		return rootJ;
 	}
 
 	// load on button and gain states
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
 		json_t *input_onJ = json_object_get(rootJ, "input_on");
 		if (input_onJ) gig_fader.on = json_integer_value(input_onJ);
 		json_t *post_fadesJ = json_object_get(rootJ, "post_fades");
 		if (post_fadesJ) post_fades = json_integer_value(post_fadesJ);
 		json_t *gainJ = json_object_get(rootJ, "gain");
 		if (gainJ) gig_fader.setGain((float)json_real_value(gainJ));
+		json_t *pan_lawJ = json_object_get(rootJ, "pan_law");
+		if (pan_lawJ) setPanLaw(json_integer_value(pan_lawJ));
 		json_t *fade_inJ = json_object_get(rootJ, "fade_in");
 		if (fade_inJ) fade_in = json_real_value(fade_inJ);
 		json_t *fade_outJ = json_object_get(rootJ, "fade_out");
 		if (fade_outJ) fade_out = json_real_value(fade_outJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
 		json_t *audition_mixerJ = json_object_get(rootJ, "audition_mixer");
 		if (audition_mixerJ) {
-			audition_mixer = json_integer_value(audition_mixerJ);
+			auditions.setActive(AUDITION_MIXER, audition_group, json_integer_value(audition_mixerJ));
 		} else {
-			audition_mixer = false;   // no auditioning when loading old patch right after auditioned patch
+			auditions.stop(AUDITION_MIXER, audition_group);   // no auditioning when loading old patch right after auditioned patch
 		}
 		json_t *auditionedJ = json_object_get(rootJ, "auditioned");
 		if (auditionedJ) auditioned = json_integer_value(auditionedJ);
@@ -356,10 +353,20 @@ struct GigBus : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// reset fader speed with new sample rate
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		on_button.setSampleRate(sample_rate);
+		gig_fader.setSampleRate(sample_rate);
+		gig_pan.setSampleRate(sample_rate);
+		post_fade_filter.setSampleRate(sample_rate);
+		meter.setSampleRate(sample_rate);
 		if (gig_fader.on) {
 			gig_fader.setSpeed(fade_in);
 		} else {
@@ -367,20 +374,57 @@ struct GigBus : Module {
 		}
 	}
 
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
+	}
+
 	// reset on state on initialize
 	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
 		gig_fader.on = true;
 		gig_fader.setGain(1.f);
 		fade_in = 26.f;
 		fade_out = 26.f;
+		setFadeCurve(FADE_CURVE_EXP);
 		post_fades = true;
-		audition_mixer = false;
+		auditions.stop(AUDITION_MIXER, audition_group);
+		setAuditionGroup(0);
+		setPanLaw(PAN_LAW_3DB);
+	}
+
+	// set pan law on pan object
+	void setPanLaw(int law) {
+		pan_law = law;
+		gig_pan.setLaw(law);
+	}
+
+	// on state from a scene or automation, turned like a single click of the on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(bool on) {
+		if (auditions.isActive(AUDITION_MIXER, audition_group) || on == gig_fader.on) return;
+		auto_override = false;   // do not override automation
+		gig_fader.on = on;
+		if (on) {
+			gig_fader.setSpeed(int(fade_in));
+		} else {
+			gig_fader.setSpeed(int(fade_out));
+		}
+	}
+
+	// set fade automation curve on fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		gig_fader.setCurve(curve);
 	}
 };
 
 
 struct GigBusWidget : ModuleWidget {
 	SvgPanel *night_panel;
+	int applied_theme = -1;
 
 	GigBusWidget(GigBus *module) {
 		setModule(module);
@@ -559,6 +603,16 @@ struct GigBusWidget : ModuleWidget {
 		fadeOutSliderItem->box.size.x = 190.f;
 		menu->addChild(fadeOutSliderItem);
 
+		FadeCurvesItem<GigBus> *fadeCurvesItem = createMenuItem<FadeCurvesItem<GigBus>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<GigBus> *automationItem = createMenuItem<AutomationItem<GigBus>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
 		// mixer settings
 		menu->addChild(new MenuEntry);
 		menu->addChild(createMenuLabel("Mixer Settings"));
@@ -568,11 +622,30 @@ struct GigBusWidget : ModuleWidget {
 		gainsItem->module = module;
 		menu->addChild(gainsItem);
 
+		PanLawsItem<GigBus> *panLawsItem = createMenuItem<PanLawsItem<GigBus>>("Pan Law");
+		panLawsItem->rightText = RIGHT_ARROW;
+		panLawsItem->module = module;
+		menu->addChild(panLawsItem);
+
 		PostFadesItem *postFadesItem = createMenuItem<PostFadesItem>("Blue and Orange Levels");
 		postFadesItem->rightText = RIGHT_ARROW;
 		postFadesItem->module = module;
 		menu->addChild(postFadesItem);
 
+		BusLinkItem<GigBus> *busLinkItem = createMenuItem<BusLinkItem<GigBus>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<GigBus> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<GigBus>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
 #ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
@@ -583,18 +656,32 @@ struct GigBusWidget : ModuleWidget {
 #endif
 	}
 
-	// display panel based on theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			GigBus *gig_bus = (GigBus*)module;
+			if (gig_bus->use_default_theme) {
+				gig_bus->color_theme = gtg_default_theme;
+			}
+
+			// vu lights from the levels the audio thread handed over
+			gig_bus->meter.update();
+			gig_bus->meter.setLadderLights(0, &gig_bus->lights[GigBus::LEFT_LIGHTS]);
+			gig_bus->meter.setLadderLights(1, &gig_bus->lights[GigBus::RIGHT_LIGHTS]);
+
+			if (gig_bus->color_theme != applied_theme) {
+				applied_theme = gig_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((GigBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((GigBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
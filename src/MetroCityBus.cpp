@@ -1,10 +1,16 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgSIMD.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
 
 
-const long HISTORY_CAP = 512000;
 const float pan_division = 3.f;
+const float pan_history_rate = 100.f;   // pan follow history values per second
 
 struct MetroCityBus : Module {
 	enum ParamIds {
@@ -39,6 +45,7 @@ struct MetroCityBus : Module {
 		NUM_LIGHTS
 	};
 
+	gtgMeter meter;
 	LongPressButton on_button;
 	dsp::SchmittTrigger on_cv_trigger;
 	dsp::SchmittTrigger reverse_poly_trigger;
@@ -48,7 +55,7 @@ struct MetroCityBus : Module {
 	dsp::ClockDivider pan_light_divider;
 	dsp::ClockDivider light_divider;
 	AutoFader metro_fader;
-	ConstantPan metro_pan[16];
+	PanBank metro_pans;
 	SimpleSlewer level_smoother[3];
 	SimpleSlewer post_btn_filters[2];
 
@@ -57,23 +64,35 @@ struct MetroCityBus : Module {
 	const int level_speed = 26;
 	float fade_in = 26.f;
 	float fade_out = 26.f;
+	int fade_curve = FADE_CURVE_EXP;
 	bool auto_override = false;
 	bool auditioned = false;
-	float pan_history[HISTORY_CAP] = {};
-	long hist_i = 0;
-	long hist_size = 0;
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
+	ControlHistory pan_history;
 	bool reverse_poly = false;
 	bool post_fades[2] = {false, false};
 	float spread_pos = 0.f;
 	int channel_no = 0;
+	float pan_targets[16] = {};
 	float light_pan[16] = {};
 	float light_delta = 2.f / 8.f;   // 8 divisions because light 1 and 9 are halved by offset
 	float light_brights[9] = {};
-	long f_delay = 0;   // follow delay
-	float pan_rate = APP->engine->getSampleRate() / pan_division;   // to work with pan clock divider
+	float pan_rate = DSP_DEFAULT_SAMPLE_RATE / pan_division;   // to work with pan clock divider, set again in onSampleRateChange
 	bool level_cv_filter = true;
+	int pan_law = PAN_LAW_3DB;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	BusLink bus_link;
+	int block_i = 0;   // sample position in block ramps
+	float fade_gains[DSP_BLOCK_SIZE] = {};
+	float level_gains[3][DSP_BLOCK_SIZE] = {};
+	float post_gains[2][DSP_BLOCK_SIZE] = {};
+	bool fade_constant = true;
+	bool level_constant[3] = {true, true, true};
+	bool post_constant[2] = {true, true};
 
 	MetroCityBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -96,6 +115,7 @@ struct MetroCityBus : Module {
 		configInput(BUS_INPUT, "Bus chain");
 		configOutput(BUS_OUTPUT, "Bus chain");
 		pan_divider.setDivision(pan_division);
+		pan_history.setRate(pan_rate, pan_history_rate);
 		pan_light_divider.setDivision(499);
 		light_divider.setDivision(512);
 		metro_fader.setSpeed(fade_in);
@@ -111,9 +131,20 @@ struct MetroCityBus : Module {
 		post_fades[1] = post_fades[0];
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, SPREAD_PARAM, 2);   // spread and pan attenuverter
+		scene_memory.addParams(this, PAN_PARAM, 4);   // pan and levels
+		scene_memory.addFader(&metro_fader, [this](bool on) {setOnState(on);});
+		scene_memory.addToggle(&reverse_poly, [this](bool on) {reverse_poly = on;});
+		scene_memory.addToggle(&post_fades[0], [this](bool on) {post_fades[0] = on;});
+		scene_memory.addToggle(&post_fades[1], [this](bool on) {post_fades[1] = on;});
+		automation.addParams(this, PAN_PARAM, 4);   // pan and levels
+		automation.addFader(&metro_fader, [this](bool on) {setOnState(on);});
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
 
 		// on off button
 		switch (on_button.step(params[ON_PARAM])) {
@@ -121,8 +152,8 @@ struct MetroCityBus : Module {
 		case LongPressButton::NO_PRESS:
 			break;
 		case LongPressButton::SHORT_PRESS:
-			if (audition_mixer) {
-				audition_mixer = false;   // single click turns off auditions
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+				auditions.stop(AUDITION_MIXER, audition_group);   // single click turns off auditions
 			} else {
 				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
 					auto_override = true;
@@ -148,7 +179,7 @@ struct MetroCityBus : Module {
 			break;
 		case LongPressButton::LONG_PRESS:   // long press to audition
 
-			audition_mixer = true;   // all mixers to audition mode
+			auditions.start(AUDITION_MIXER, audition_group);   // all mixers in the group to audition mode
 
 			if (auditioned) {
 				auditioned = false;
@@ -169,14 +200,12 @@ struct MetroCityBus : Module {
 
 		// process cv trigger
 		if (on_cv_trigger.process(inputs[ON_CV_INPUT].getVoltage())) {
-			if (!audition_mixer) {
+			if (!auditions.isActive(AUDITION_MIXER, audition_group)) {
 				auto_override = false;   // do not override automation
 				metro_fader.on = !metro_fader.on;
 			}
 		}
 
-		metro_fader.process();
-
 		// button to reverse polyphonic pan order
 		if (reverse_poly_trigger.process(params[REVERSE_PARAM].getValue())) reverse_poly = !reverse_poly;
 
@@ -186,40 +215,38 @@ struct MetroCityBus : Module {
 
 		if (light_divider.process()) {
 
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
-			if (audition_mixer) {   // all mixers are in audition state
+			if (auditions.hasChanged(AUDITION_MIXER, audition_group, audition_epoch)) {   // only when the group changes
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {   // all mixers are in audition state
 
-				// bypass all fade automation
-				auto_override = true;
-				metro_fader.setSpeed(bypass_speed);
-
-				if (auditioned) {   // this mixer is being auditioned
-					metro_fader.on =  true;
-				} else {   // mute the mixers
-					if (metro_fader.on) {
-						metro_fader.temped = true;   // remember this mixer was on
-					}
-					metro_fader.on = false;
-				}
-			} else {   // stop auditions
-
-				// return to states before auditions
-				if (metro_fader.temped) {
-					metro_fader.temped = false;
+					// bypass all fade automation
 					auto_override = true;
 					metro_fader.setSpeed(bypass_speed);
-					if (auditioned) {
+
+					if (auditioned) {   // this mixer is being auditioned
+						metro_fader.on =  true;
+					} else {   // mute the mixers
+						if (metro_fader.on) {
+							metro_fader.temped = true;   // remember this mixer was on
+						}
 						metro_fader.on = false;
-					} else {
-						metro_fader.on = true;
 					}
-				}
+				} else {   // stop auditions
+
+					// return to states before auditions
+					if (metro_fader.temped) {
+						metro_fader.temped = false;
+						auto_override = true;
+						metro_fader.setSpeed(bypass_speed);
+						if (auditioned) {
+							metro_fader.on = false;
+						} else {
+							metro_fader.on = true;
+						}
+					}
 
-				// turn off auditions
-				auditioned = false;
+					// turn off auditions
+					auditioned = false;
+				}
 			}
 
 			// process fade speed changes if dragging slider
@@ -237,7 +264,7 @@ struct MetroCityBus : Module {
 
 			// set on light
 			if (metro_fader.getFade() == metro_fader.getGain()) {
-				if (audition_mixer) {
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {
 					lights[ON_LIGHT + 0].value = 1.f;   // yellow when auditioned
 					lights[ON_LIGHT + 1].value = 1.f;
 				} else {
@@ -260,138 +287,149 @@ struct MetroCityBus : Module {
 			lights[ORANGE_POST_LIGHT].value = post_fades[1];
 		}
 
-		// get level knobs
-		float in_levels[3] = {0.f, 0.f, 0.f};
-		for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
-			in_levels[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
+		// calculate fade, level, and post fader ramps once per block
+		if (block_i == 0) {
+			fade_constant = metro_fader.processBlock(fade_gains, DSP_BLOCK_SIZE);
+
+			// get level targets and smooth them across the block
+			float level_targets[3] = {0.f, 0.f, 0.f};
+			for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
+				level_targets[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
+				if (level_cv_filter) {
+					level_constant[sb] = level_smoother[sb].slewBlock(level_targets[sb], level_gains[sb], DSP_BLOCK_SIZE);
+				}
+			}
+
+			// post fades follow the red level
+			for (int i = 0; i < 2; i++) {
+				if (post_fades[i]) {
+					post_constant[i] = post_btn_filters[i].slewBlock(level_targets[2], post_gains[i], DSP_BLOCK_SIZE);
+				} else {
+					post_constant[i] = post_btn_filters[i].slewBlock(1.f, post_gains[i], DSP_BLOCK_SIZE);
+				}
+			}
 		}
 
-		// smooth input levels
+		// get level knobs
+		float in_levels[3] = {0.f, 0.f, 0.f};
 		if (level_cv_filter) {
 			for (int sb = 0; sb < 3; sb++) {
-				in_levels[sb] = level_smoother[sb].slew(in_levels[sb]);
+				in_levels[sb] = level_gains[sb][level_constant[sb] ? 0 : block_i];
+			}
+		} else {   // unfiltered level CVs are read every sample
+			for (int sb = 0; sb < 3; sb++) {
+				in_levels[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
 			}
 		}
 
 		// set post fades on levels
 		for (int i = 0; i < 2; i++) {
-			if (post_fades[i]) {
-				in_levels[i] *= post_btn_filters[i].slew(in_levels[2]);
-			} else {
-				in_levels[i] *= post_btn_filters[i].slew(1.f);
-			}
+			in_levels[i] *= post_gains[i][post_constant[i] ? 0 : block_i];
 		}
 
+		float exp_fade = fade_gains[fade_constant ? 0 : block_i];
+
+		// roll block position
+		block_i++;
+		if (block_i >= DSP_BLOCK_SIZE) block_i = 0;
+
 		// get number of channels
 		channel_no = inputs[POLY_INPUT].getChannels();
 
 		// pans
 		if (pan_divider.process() && metro_fader.on) {   // calculate pan every few samples when input is on
 
+			// channels without a new target stay where they are
+			for (int c = 0; c < 16; c++) {
+				pan_targets[c] = metro_pans.getPosition(c);
+			}
+
 			// create follow pan when CV connected
 			if (inputs[PAN_CV_INPUT].isConnected()) {
 
 				// get pan knob with CV and attenuator
 				float pan_pos = params[PAN_PARAM].getValue() + (((inputs[PAN_CV_INPUT].getNormalVoltage(0) * 2) * params[PAN_ATT_PARAM].getValue()) * 0.1f);
-				metro_pan[0].setSmoothPan(pan_pos);
-				light_pan[0] = metro_pan[0].position;   // pan position for lights
+				pan_targets[0] = pan_pos;
 
 				// spread is only 0 to 1 for pan follow
 				spread_pos = std::abs(params[SPREAD_PARAM].getValue());
 
-				// Store pan history of first channel
-				if (hist_i >= HISTORY_CAP) hist_i = 0;   // reset history buffer index
-				pan_history[hist_i] = metro_pan[0].position;
-
-				// Calculate delay for pan
-				f_delay = std::round(spread_pos * pan_rate);   // f_delay * 16 should not be more than HISTORY_CAP
+				// store pan target history of first channel, smoothing the delayed target gives the delayed smoothed pan
+				pan_history.push(pan_pos);
 
-				// calculate pan position for other channels
+				// each channel follows the one before it by up to a second, read between stored values
 				for (int c = 1; c < channel_no; c++) {
-					long follow = c * f_delay;
-					if (follow <= hist_size) {   // stay put until there is enough history to follow
-						follow = hist_i - follow;
-						if (follow < 0) follow = HISTORY_CAP + follow;   // fix follow when buffer resets to 0
-
-						// smooth pan for dynamic channels and history catch up
-						if (inputs[POLY_INPUT].getPolyVoltage(c) > 0.f) {
-							metro_pan[c].setSmoothPan(pan_history[follow]);   // full pan calculation if there is sound
-							light_pan[c] = metro_pan[c].position;
-						} else {
-							light_pan[c] = pan_history[follow];   // set only lights on silent channels
-						}
-					}
+					pan_targets[c] = pan_history.read(c * spread_pos);
 				}
 
-				hist_i++;   // Keep history buffer rolling
-				if (hist_size < HISTORY_CAP) hist_size++;
+				metro_pans.setPans(pan_targets);
 
 			} else {   // create spread pan when no CV connected
 
-				hist_size = 0; hist_i = 0;   // reset pan history when CV not connected
+				pan_history.reset();   // reset pan history when CV not connected
 
 				// Get pan and spread positions
-				metro_pan[0].setPan(params[PAN_PARAM].getValue());   // first channel is pan knob position
-				light_pan[0] = metro_pan[0].position;   // pan position for lights
+				float first_pos = params[PAN_PARAM].getValue();   // first channel is pan knob position
+				pan_targets[0] = first_pos;
 
 				spread_pos = params[SPREAD_PARAM].getValue();
 
 				// Calculate spread as portion of field between pan knob and hard left or hard right
 				float pan_spread = 0.f;
-				if (spread_pos < 0) pan_spread = (metro_pan[0].position + 1) * spread_pos;
-				if (spread_pos > 0) pan_spread = -1 * ((metro_pan[0].position - 1) * spread_pos);
+				if (spread_pos < 0) pan_spread = (first_pos + 1) * spread_pos;
+				if (spread_pos > 0) pan_spread = -1 * ((first_pos - 1) * spread_pos);
 
-				// calculate polyphonic spread and pan levels for other channels
+				// calculate polyphonic spread for other channels
 				for (int c = 1; c < channel_no; c++) {
-					float channel_pos = metro_pan[0].position + (((float)c / (float)(channel_no - 1)) * pan_spread);
-					metro_pan[c].setSmoothPan(channel_pos);
-					light_pan[c] = metro_pan[c].position;
+					pan_targets[c] = first_pos + (((float)c / (float)(channel_no - 1)) * pan_spread);
 				}
+
+				metro_pans.setPans(pan_targets, true);   // first channel follows the knob without smoothing
+			}
+
+			// pan positions for lights
+			for (int c = 0; c < channel_no; c++) {
+				light_pan[c] = metro_pans.getPosition(c);
 			}
 		}   // end pan_divider.process()
 
-		// get exponential fade
-		float exp_fade = 0.f;
-		if (metro_fader.fading) {
-			exp_fade = metro_fader.getExpFade(2.5);
-		} else {
-			exp_fade = metro_fader.getFade();
-		}
+		// channel order for pan levels, rebuilt only when channels or reverse change
+		metro_pans.setOrder(channel_no, reverse_poly);
 
-		// process inputs
+		// process inputs, silent inputs are skipped
 		float stereo_in[2] = {0.f, 0.f};
-		if (spread_pos == 0 && metro_pan[channel_no - 1].position == params[PAN_PARAM].getValue()) {   // sum channels if no spread
-			float sum_in = inputs[POLY_INPUT].getVoltageSum();
-			for (int c = 0; c < 2; c++) {
-				stereo_in[c] = sum_in * metro_pan[0].levels[c] * exp_fade;
-			}
-		} else {
-			for (int c = 0; c < channel_no; c++) {
-				float channel_in = inputs[POLY_INPUT].getPolyVoltage(c);
-				if (reverse_poly) {   // reverses order of pan levels applied to channels
-					stereo_in[0] += channel_in * metro_pan[channel_no - c - 1].levels[0];
-					stereo_in[1] += channel_in * metro_pan[channel_no - c - 1].levels[1];
-				} else {
-					stereo_in[0] += channel_in * metro_pan[c].levels[0];
-					stereo_in[1] += channel_in * metro_pan[c].levels[1];
+		if (!fade_constant || exp_fade > 0.f) {
+			if (spread_pos == 0 && metro_pans.getPosition(std::max(channel_no - 1, 0)) == params[PAN_PARAM].getValue()) {   // sum channels if no spread
+				float sum_in = inputs[POLY_INPUT].getVoltageSum();
+				for (int c = 0; c < 2; c++) {
+					stereo_in[c] = sum_in * metro_pans.getLevel(0, c) * exp_fade;
 				}
-			}
+			} else {
+				metro_pans.mix(inputs[POLY_INPUT], stereo_in[0], stereo_in[1]);
 
-			// Apply fade after summing
-			stereo_in[0] *= exp_fade;
-			stereo_in[1] *= exp_fade;
+				// Apply fade after summing
+				stereo_in[0] *= exp_fade;
+				stereo_in[1] *= exp_fade;
+			}
 		}
 
+		// red levels for the meter
+		meter.processStereo(stereo_in[0] * in_levels[2], stereo_in[1] * in_levels[2]);
+
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
+
 		// process bus outputs
 		for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
 			for (int c = 0; c < 2; c++) {
-				int bus_channel = (2 * sb) + c;
-				outputs[BUS_OUTPUT].setVoltage((stereo_in[c] * in_levels[sb]) + inputs[BUS_INPUT].getPolyVoltage(bus_channel), bus_channel);
+				bus[(2 * sb) + c] += stereo_in[c] * in_levels[sb];
 			}
 		}
 
-		// set bus outputs for 3 stereo buses out
-		outputs[BUS_OUTPUT].setChannels(6);
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
 
 		// set lights
 		if (pan_light_divider.process()) {   // set lights infrequently
@@ -445,19 +483,32 @@ struct MetroCityBus : Module {
 		json_object_set_new(rootJ, "blue_post_fade", json_integer(post_fades[0]));
 		json_object_set_new(rootJ, "orange_post_fade", json_integer(post_fades[1]));
 		json_object_set_new(rootJ, "gain", json_real(metro_fader.getGain()));
+		json_object_set_new(rootJ, "pan_law", json_integer(pan_law));
 		json_object_set_new(rootJ, "level_cv_filter", json_integer(level_cv_filter));
 		json_object_set_new(rootJ, "fade_in", json_real(fade_in));
 		json_object_set_new(rootJ, "fade_out", json_real(fade_out));
-		json_object_set_new(rootJ, "audition_mixer", json_integer(audition_mixer));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "audition_mixer", json_integer(auditions.isActive(AUDITION_MIXER, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
 		json_object_set_new(rootJ, "auditioned", json_integer(auditioned));
 		json_object_set_new(rootJ, "temped", json_integer(metro_fader.temped));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
 		return rootJ;
 	}
 
 	// load on, post and reverse buttons, and gain states
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
 		json_t *input_onJ = json_object_get(rootJ, "input_on");
 		if (input_onJ) metro_fader.on = json_integer_value(input_onJ);
 		json_t *reverse_polyJ = json_object_get(rootJ, "reverse_poly");
@@ -468,6 +519,8 @@ struct MetroCityBus : Module {
 		if (orange_post_fadeJ) post_fades[1] = json_integer_value(orange_post_fadeJ);
 		json_t *gainJ = json_object_get(rootJ, "gain");
 		if (gainJ) metro_fader.setGain((float)json_real_value(gainJ));
+		json_t *pan_lawJ = json_object_get(rootJ, "pan_law");
+		if (pan_lawJ) setPanLaw(json_integer_value(pan_lawJ));
 		json_t *level_cv_filterJ = json_object_get(rootJ, "level_cv_filter");
 		if (level_cv_filterJ) {
 			level_cv_filter = json_integer_value(level_cv_filterJ);
@@ -478,11 +531,13 @@ struct MetroCityBus : Module {
 		if (fade_inJ) fade_in = json_real_value(fade_inJ);
 		json_t *fade_outJ = json_object_get(rootJ, "fade_out");
 		if (fade_outJ) fade_out = json_real_value(fade_outJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
 		json_t *audition_mixerJ = json_object_get(rootJ, "audition_mixer");
 		if (audition_mixerJ) {
-			audition_mixer = json_integer_value(audition_mixerJ);
+			auditions.setActive(AUDITION_MIXER, audition_group, json_integer_value(audition_mixerJ));
 		} else {
-			audition_mixer = false;   // no auditioning when loading old patch right after auditioned patch
+			auditions.stop(AUDITION_MIXER, audition_group);   // no auditioning when loading old patch right after auditioned patch
 		}
 		json_t *auditionedJ = json_object_get(rootJ, "auditioned");
 		if (auditionedJ) auditioned = json_integer_value(auditionedJ);
@@ -496,56 +551,95 @@ struct MetroCityBus : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// recalculate fader, pan smoothing, and pan_rate (used by pan follow)
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		on_button.setSampleRate(sample_rate);
+		metro_fader.setSampleRate(sample_rate);
+		meter.setSampleRate(sample_rate);
 		if (metro_fader.on) {
 			metro_fader.setSpeed(fade_in);
 		} else {
 			metro_fader.setSpeed(fade_out);
 		}
-		for (int i = 0; i < 16; i++) {
-			metro_pan[i].setSmoothSpeed(smooth_speed);
-		}
-		pan_rate = (APP->engine->getSampleRate() / pan_division);   // used by pan follow, accounts for pan clock divider
+		metro_pans.setSampleRate(sample_rate);
+		pan_rate = (sample_rate / pan_division);   // used by pan follow, accounts for pan clock divider
+		pan_history.setRate(pan_rate, pan_history_rate);
 		for (int i = 0; i < 3; i++) {
-			level_smoother[i].setSlewSpeed(level_speed);
+			level_smoother[i].setSampleRate(sample_rate);
 		}
 		for (int i = 0; i < 2; i++) {
-			post_btn_filters[i].setSlewSpeed(level_speed);
+			post_btn_filters[i].setSampleRate(sample_rate);
 		}
 	}
 
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
+	}
+
 	// Initialize on state and buttons
 	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
 		metro_fader.on = true;
 		metro_fader.setGain(1.f);
 		fade_in = 26.f;
 		fade_out = 26.f;
+		setFadeCurve(FADE_CURVE_EXP);
 		reverse_poly = false;
 		post_fades[0] = loadGtgPluginDefault("default_post_fader", 0);
 		post_fades[1] = post_fades[0];
 		initializePanObjects();
 		level_cv_filter = true;
-		audition_mixer = false;
+		auditions.stop(AUDITION_MIXER, audition_group);
+		setAuditionGroup(0);
+		setPanLaw(PAN_LAW_3DB);
+	}
+
+	// set pan law on the pan bank
+	void setPanLaw(int law) {
+		pan_law = law;
+		metro_pans.setLaw(law);
 	}
 
 	// initialize pan objects
 	void initializePanObjects () {
-		for (int i = 0; i < 16; i++) {
-			metro_pan[i].position = 0.f;
-			metro_pan[i].levels[0] = 1.f;
-			metro_pan[i].levels[1] = 1.f;
-			metro_pan[i].setSmoothSpeed(smooth_speed);
+		metro_pans.reset();
+		metro_pans.setSmoothSpeed(smooth_speed);
+	}
+
+	// on state from a scene or automation, turned like a single click of the on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(bool on) {
+		if (auditions.isActive(AUDITION_MIXER, audition_group) || on == metro_fader.on) return;
+		auto_override = false;   // do not override automation
+		metro_fader.on = on;
+		if (on) {
+			metro_fader.setSpeed(int(fade_in));
+		} else {
+			metro_fader.setSpeed(int(fade_out));
 		}
 	}
 
+	// set fade automation curve on fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		metro_fader.setCurve(curve);
+	}
 };
 
 
 struct MetroCityBusWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	MetroCityBusWidget(MetroCityBus *module) {
 		setModule(module);
@@ -592,6 +686,11 @@ struct MetroCityBusWidget : ModuleWidget {
 
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(33.231, 114.107)), false, module, MetroCityBus::BUS_OUTPUT, module ? &module->color_theme : NULL));
 
+		// slim meter beside the input
+		gtgMeterDisplay *meter_display = createWidget<gtgMeterDisplay>(mm2px(Vec(12.0, 17.6)));
+		meter_display->meter = module ? &module->meter : NULL;
+		addChild(meter_display);
+
 		addChild(createLightCentered<MediumLight<GreenLight>>(mm2px(Vec(4.423, 33.341)), module, MetroCityBus::PAN_LIGHTS + 0));
 		addChild(createLightCentered<MediumLight<GreenLight>>(mm2px(Vec(8.401, 31.86)), module, MetroCityBus::PAN_LIGHTS + 1));
 		addChild(createLightCentered<MediumLight<GreenLight>>(mm2px(Vec(12.379, 30.83)), module, MetroCityBus::PAN_LIGHTS + 2));
@@ -753,6 +852,16 @@ struct MetroCityBusWidget : ModuleWidget {
 		fadeOutSliderItem->box.size.x = 190.f;
 		menu->addChild(fadeOutSliderItem);
 
+		FadeCurvesItem<MetroCityBus> *fadeCurvesItem = createMenuItem<FadeCurvesItem<MetroCityBus>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<MetroCityBus> *automationItem = createMenuItem<AutomationItem<MetroCityBus>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
 		menu->addChild(new MenuEntry);
 		menu->addChild(createMenuLabel("Mixer Settings"));
 
@@ -761,6 +870,11 @@ struct MetroCityBusWidget : ModuleWidget {
 		gainsItem->module = module;
 		menu->addChild(gainsItem);
 
+		PanLawsItem<MetroCityBus> *panLawsItem = createMenuItem<PanLawsItem<MetroCityBus>>("Pan Law");
+		panLawsItem->rightText = RIGHT_ARROW;
+		panLawsItem->module = module;
+		menu->addChild(panLawsItem);
+
 		LevelCvFiltersItem *levelCvFiltersItem = createMenuItem<LevelCvFiltersItem>("Level CV Filters");
 		levelCvFiltersItem->rightText = RIGHT_ARROW;
 		levelCvFiltersItem->module = module;
@@ -771,6 +885,20 @@ struct MetroCityBusWidget : ModuleWidget {
 		postFadesItem->module = module;
 		menu->addChild(postFadesItem);
 
+		BusLinkItem<MetroCityBus> *busLinkItem = createMenuItem<BusLinkItem<MetroCityBus>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<MetroCityBus> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<MetroCityBus>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
 #ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
@@ -781,18 +909,26 @@ struct MetroCityBusWidget : ModuleWidget {
 #endif
 	}
 
-	// display panel based on theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			MetroCityBus *metro_city_bus = (MetroCityBus*)module;
+			if (metro_city_bus->use_default_theme) {
+				metro_city_bus->color_theme = gtg_default_theme;
+			}
+			if (metro_city_bus->color_theme != applied_theme) {
+				applied_theme = metro_city_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((MetroCityBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((MetroCityBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
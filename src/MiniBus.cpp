@@ -1,6 +1,11 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
 
 
 struct MiniBus : Module {
@@ -24,6 +29,7 @@ struct MiniBus : Module {
 		NUM_LIGHTS
 	};
 
+	gtgMeter meter;
 	LongPressButton on_button;
 	dsp::SchmittTrigger on_cv_trigger;
 	dsp::ClockDivider light_divider;
@@ -34,11 +40,22 @@ struct MiniBus : Module {
 	const int smooth_speed = 26;
 	float fade_in = 26.f;
 	float fade_out = 26.f;
+	int fade_curve = FADE_CURVE_EXP;
 	bool auto_override = false;
 	bool post_fades = false;
 	bool auditioned = false;
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	BusLink bus_link;
+	int block_i = 0;   // sample position in block ramps
+	float fade_gains[DSP_BLOCK_SIZE] = {};
+	float post_gains[DSP_BLOCK_SIZE] = {};
+	bool fade_constant = true;
+	bool post_constant = true;
 
 	MiniBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -57,9 +74,16 @@ struct MiniBus : Module {
 		post_fades = loadGtgPluginDefault("default_post_fader", false);
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, LEVEL_PARAMS, 3);
+		scene_memory.addFader(&mini_fader, [this](bool on) {setOnState(on);});
+		automation.addParams(this, LEVEL_PARAMS, 3);   // levels
+		automation.addFader(&mini_fader, [this](bool on) {setOnState(on);});
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
 
 		// on off button
 		switch (on_button.step(params[ON_PARAM])) {
@@ -67,8 +91,8 @@ struct MiniBus : Module {
 		case LongPressButton::NO_PRESS:
 			break;
 		case LongPressButton::SHORT_PRESS:
-			if (audition_mixer) {
-				audition_mixer = false;   // single click turns off auditions
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+				auditions.stop(AUDITION_MIXER, audition_group);   // single click turns off auditions
 			} else {
 				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
 					auto_override = true;
@@ -94,7 +118,7 @@ struct MiniBus : Module {
 			break;
 		case LongPressButton::LONG_PRESS:   // long press to audition
 
-			audition_mixer = true;   // all mixers to audition mode
+			auditions.start(AUDITION_MIXER, audition_group);   // all mixers in the group to audition mode
 
 			if (auditioned) {
 				auditioned = false;
@@ -114,51 +138,47 @@ struct MiniBus : Module {
 
 		// process cv trigger
 		if (on_cv_trigger.process(inputs[ON_CV_INPUT].getVoltage())) {
-			if (!audition_mixer) {
+			if (!auditions.isActive(AUDITION_MIXER, audition_group)) {
 				auto_override = false;   // do not override automation
 				mini_fader.on = !mini_fader.on;
 			}
 		}
 
-		mini_fader.process();
-
 		// process fade states, light, and default theme
 		if (light_divider.process()) {
 
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
-			if (audition_mixer) {   // all mixers are in audition state
-
-				// bypass all fade automation
-				auto_override = true;
-				mini_fader.setSpeed(bypass_speed);
+			if (auditions.hasChanged(AUDITION_MIXER, audition_group, audition_epoch)) {   // only when the group changes
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {   // all mixers are in audition state
 
-				if (auditioned) {   // this mixer is being auditioned
-					mini_fader.on =  true;
-				} else {   // mute the mixers
-					if (mini_fader.on) {
-						mini_fader.temped = true;   // remember this mixer was on
-					}
-					mini_fader.on = false;
-				}
-			} else {   // stop auditions
-
-				// return to states before auditions
-				if (mini_fader.temped) {
-					mini_fader.temped = false;
+					// bypass all fade automation
 					auto_override = true;
 					mini_fader.setSpeed(bypass_speed);
-					if (auditioned) {
+
+					if (auditioned) {   // this mixer is being auditioned
+						mini_fader.on =  true;
+					} else {   // mute the mixers
+						if (mini_fader.on) {
+							mini_fader.temped = true;   // remember this mixer was on
+						}
 						mini_fader.on = false;
-					} else {
-						mini_fader.on = true;
 					}
-				}
+				} else {   // stop auditions
+
+					// return to states before auditions
+					if (mini_fader.temped) {
+						mini_fader.temped = false;
+						auto_override = true;
+						mini_fader.setSpeed(bypass_speed);
+						if (auditioned) {
+							mini_fader.on = false;
+						} else {
+							mini_fader.on = true;
+						}
+					}
 
-				// turn off auditions
-				auditioned = false;
+					// turn off auditions
+					auditioned = false;
+				}
 			}
 
 			// process fade speed changes if dragging slider
@@ -176,7 +196,7 @@ struct MiniBus : Module {
 
 			// set lights
 			if (mini_fader.getFade() == mini_fader.getGain()) {
-				if (audition_mixer) {
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {
 					lights[ON_LIGHT + 0].value = 1.f;   // yellow when auditioned
 					lights[ON_LIGHT + 1].value = 1.f;
 				} else {
@@ -194,12 +214,26 @@ struct MiniBus : Module {
 			}
 		}
 
-		// get inputs
+		// calculate fade and post fader ramps once per block
+		if (block_i == 0) {
+			fade_constant = mini_fader.processBlock(fade_gains, DSP_BLOCK_SIZE);
+			if (post_fades) {
+				post_constant = post_fade_filter.slewBlock(params[LEVEL_PARAMS + 2].getValue(), post_gains, DSP_BLOCK_SIZE);
+			} else {
+				post_constant = post_fade_filter.slewBlock(1.f, post_gains, DSP_BLOCK_SIZE);
+			}
+		}
+		float exp_fade = fade_gains[fade_constant ? 0 : block_i];
+		float post_amount = post_gains[post_constant ? 0 : block_i];
+
+		// roll block position
+		block_i++;
+		if (block_i >= DSP_BLOCK_SIZE) block_i = 0;
+
+		// get inputs, silent inputs are skipped
 		float mono_in = 0.f;
-		if (mini_fader.fading) {
-			mono_in = inputs[MP_INPUT].getVoltageSum() * mini_fader.getExpFade(2.5);
-		} else {
-			mono_in = inputs[MP_INPUT].getVoltageSum() * mini_fader.getFade();
+		if (!fade_constant || exp_fade > 0.f) {
+			mono_in = inputs[MP_INPUT].getVoltageSum() * exp_fade;
 		}
 
 		// get levels
@@ -208,14 +242,8 @@ struct MiniBus : Module {
 		// get red level
 		in_levels[2] = params[LEVEL_PARAMS + 2].getValue();
 
-		// slew post fader level
-		float post_amount = 1.f;
-		if (post_fades) {
-			post_amount = post_fade_filter.slew(in_levels[2]);
-		} else {
-			post_amount = post_fade_filter.slew(1.f);
-		}
-		for (int sb = 0; sb < 2; sb++) {   // apply post fader level to blue and orange
+		// apply post fader level to blue and orange
+		for (int sb = 0; sb < 2; sb++) {
 			in_levels[sb] = params[LEVEL_PARAMS + sb].getValue() * post_amount;
 		}
 
@@ -225,16 +253,24 @@ struct MiniBus : Module {
 			bus_outs[sb] = mono_in * in_levels[sb];
 		}
 
+		// red level for the meter, on both sides of a mono strip
+		meter.process(bus_outs[2]);
+
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
+
 		// step through all outputs
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[0] + inputs[BUS_INPUT].getPolyVoltage(0), 0);
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[0] + inputs[BUS_INPUT].getPolyVoltage(1), 1);
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[1] + inputs[BUS_INPUT].getPolyVoltage(2), 2);
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[1] + inputs[BUS_INPUT].getPolyVoltage(3), 3);
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[2] + inputs[BUS_INPUT].getPolyVoltage(4), 4);
-		outputs[BUS_OUTPUT].setVoltage(bus_outs[2] + inputs[BUS_INPUT].getPolyVoltage(5), 5);
-
-		// always set bus outputs for 3 stereo buses out
-		outputs[BUS_OUTPUT].setChannels(6);
+		bus[0] += bus_outs[0];
+		bus[1] += bus_outs[0];
+		bus[2] += bus_outs[1];
+		bus[3] += bus_outs[1];
+		bus[4] += bus_outs[2];
+		bus[5] += bus_outs[2];
+
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
 	}
 
 	// save on button, gain states, and color theme
@@ -245,16 +281,28 @@ struct MiniBus : Module {
 		json_object_set_new(rootJ, "gain", json_real(mini_fader.getGain()));
 		json_object_set_new(rootJ, "fade_in", json_real(fade_in));
 		json_object_set_new(rootJ, "fade_out", json_real(fade_out));
-		json_object_set_new(rootJ, "audition_mixer", json_integer(audition_mixer));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "audition_mixer", json_integer(auditions.isActive(AUDITION_MIXER, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
 		json_object_set_new(rootJ, "auditioned", json_integer(auditioned));
 		json_object_set_new(rootJ, "temped", json_integer(mini_fader.temped));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
 		return rootJ;
 	}
 
 	// load on button, gain states, and color theme
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
 		json_t *input_onJ = json_object_get(rootJ, "input_on");
 		if (input_onJ) mini_fader.on = json_integer_value(input_onJ);
 		json_t *post_fadesJ = json_object_get(rootJ, "post_fades");
@@ -269,11 +317,13 @@ struct MiniBus : Module {
 		if (fade_inJ) fade_in = json_real_value(fade_inJ);
 		json_t *fade_outJ = json_object_get(rootJ, "fade_out");
 		if (fade_outJ) fade_out = json_real_value(fade_outJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
 		json_t *audition_mixerJ = json_object_get(rootJ, "audition_mixer");
 		if (audition_mixerJ) {
-			audition_mixer = json_integer_value(audition_mixerJ);
+			auditions.setActive(AUDITION_MIXER, audition_group, json_integer_value(audition_mixerJ));
 		} else {
-			audition_mixer = false;   // no auditioning when loading old patch right after auditioned patch
+			auditions.stop(AUDITION_MIXER, audition_group);   // no auditioning when loading old patch right after auditioned patch
 		}
 		json_t *auditionedJ = json_object_get(rootJ, "auditioned");
 		if (auditionedJ) auditioned = json_integer_value(auditionedJ);
@@ -287,32 +337,70 @@ struct MiniBus : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// reset fader speed
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		on_button.setSampleRate(sample_rate);
+		mini_fader.setSampleRate(sample_rate);
+		meter.setSampleRate(sample_rate);
 		if (mini_fader.on) {
 			mini_fader.setSpeed(fade_in);
 		} else {
 			mini_fader.setSpeed(fade_out);
 		}
-		post_fade_filter.setSlewSpeed(smooth_speed);
+		post_fade_filter.setSampleRate(sample_rate);
+	}
+
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
 	}
 
 	// reset fader on state when initialized
 	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
 		mini_fader.on = true;
 		mini_fader.setGain(1.f);
 		fade_in = 26.f;
 		fade_out = 26.f;
+		setFadeCurve(FADE_CURVE_EXP);
 		post_fades = loadGtgPluginDefault("default_post_fader", 0);
-		audition_mixer = false;
+		auditions.stop(AUDITION_MIXER, audition_group);
+		setAuditionGroup(0);
+	}
+
+	// on state from a scene or automation, turned like a single click of the on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(bool on) {
+		if (auditions.isActive(AUDITION_MIXER, audition_group) || on == mini_fader.on) return;
+		auto_override = false;   // do not override automation
+		mini_fader.on = on;
+		if (on) {
+			mini_fader.setSpeed(int(fade_in));
+		} else {
+			mini_fader.setSpeed(int(fade_out));
+		}
+	}
+
+	// set fade automation curve on fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		mini_fader.setCurve(curve);
 	}
 };
 
 
 struct MiniBusWidget : ModuleWidget {
 	SvgPanel *night_panel;
+	int applied_theme = -1;
 
 	MiniBusWidget(MiniBus *module) {
 		setModule(module);
@@ -343,6 +431,11 @@ struct MiniBusWidget : ModuleWidget {
 		addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.62, 103.85)), true, module, MiniBus::BUS_INPUT, module ? &module->color_theme : NULL));
 
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.62, 114.1)), false, module, MiniBus::BUS_OUTPUT, module ? &module->color_theme : NULL));
+
+		// slim meter beside the input
+		gtgMeterDisplay *meter_display = createWidget<gtgMeterDisplay>(mm2px(Vec(11.6, 30.8)));
+		meter_display->meter = module ? &module->meter : NULL;
+		addChild(meter_display);
 	}
 
 	// build the menu
@@ -489,6 +582,16 @@ struct MiniBusWidget : ModuleWidget {
 		fadeOutSliderItem->box.size.x = 190.f;
 		menu->addChild(fadeOutSliderItem);
 
+		FadeCurvesItem<MiniBus> *fadeCurvesItem = createMenuItem<FadeCurvesItem<MiniBus>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<MiniBus> *automationItem = createMenuItem<AutomationItem<MiniBus>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
 		menu->addChild(new MenuEntry);
 		menu->addChild(createMenuLabel("Mixer Settings"));
 
@@ -502,6 +605,20 @@ struct MiniBusWidget : ModuleWidget {
 		postFadesItem->module = module;
 		menu->addChild(postFadesItem);
 
+		BusLinkItem<MiniBus> *busLinkItem = createMenuItem<BusLinkItem<MiniBus>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<MiniBus> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<MiniBus>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
 #ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
@@ -512,18 +629,26 @@ struct MiniBusWidget : ModuleWidget {
 #endif
 	}
 
-	// display panel based on theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			MiniBus *mini_bus = (MiniBus*)module;
+			if (mini_bus->use_default_theme) {
+				mini_bus->color_theme = gtg_default_theme;
+			}
+			if (mini_bus->color_theme != applied_theme) {
+				applied_theme = mini_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((MiniBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((MiniBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
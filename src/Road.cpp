@@ -1,6 +1,8 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgScenes.hpp"
 
 struct Road : Module {
 	enum ParamIds {
@@ -23,12 +25,21 @@ struct Road : Module {
 	LongPressButton onauButtons[6];
 	dsp::ClockDivider light_divider;
 	AutoFader road_fader[6];
+	BusDelayLine road_delays[6];
 
 	const int fade_speed = 26;
 	bool bus_audition[6] = {false, false, false, false, false, false};
 	bool auditioning = false;
+	int bus_latencies[6] = {};
+	bool latency_compensation = true;
+	std::atomic<bool> latency_in_use {false};   // lining up 2 or more chains, the panel then walks them
+	std::atomic<int> latency_spread {0};   // samples between the shortest and longest chain
+	BusLatencyRequest latency_request;
+	BusLatencyMarks latency_marks;
+	bool wide_bus = false;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
 
 	Road() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -49,11 +60,21 @@ struct Road : Module {
 		for (int i = 0; i < 6; i++) {
 			road_fader[i].setSpeed(fade_speed);
 		}
+		setDelayLines(DSP_DEFAULT_SAMPLE_RATE);
+		latency_request.setup(this, BUS_INPUTS, 6, BUS_OUTPUT);
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		for (int i = 0; i < 6; i++) {
+			scene_memory.addFader(&road_fader[i], [this, i](bool on) {setOnState(i, on);});
+		}
+	}
+
+	~Road() {
+		latency_marks.update(this, false);
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
 
 		// get button presses
 		for (int i = 0; i < 6; i++) {
@@ -93,10 +114,6 @@ struct Road : Module {
 
 		if (light_divider.process()) {
 
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
 			if (auditioning) {
 				for (int i = 0; i < 6; i++) {
 					if (bus_audition[i]) {
@@ -146,24 +163,69 @@ struct Road : Module {
 
 		}   // end light_divider.process()
 
+		if (wide_bus) {
+			processBuses<WIDE_BUSES>();
+		} else {
+			processBuses<3>();
+		}
+	}
+
+	// sums the connected bus chains, a wide bus carries no latency to line up
+	template <int BUSES>
+	void processBuses() {
+
+		// latency of each connected bus chain, the longest chain sets the delay of the others
+		int max_latency = 0;
+		int min_latency = 0;
+		int chains = 0;
+		for (int b = 0; b < 6; b++) {
+			bus_latencies[b] = 0;
+			if (inputs[BUS_INPUTS + b].isConnected()) {
+				bus_latencies[b] = getBusLatency(inputs[BUS_INPUTS + b]);
+				min_latency = (chains == 0) ? bus_latencies[b] : std::min(min_latency, bus_latencies[b]);
+				chains++;
+			}
+			max_latency = std::max(max_latency, bus_latencies[b]);
+		}
+		latency_in_use.store(latency_compensation && BUSES == 3 && chains >= 2, std::memory_order_relaxed);   // chains feeding this Road carry latency only while it lines them up
+		latency_spread.store(max_latency - min_latency, std::memory_order_relaxed);
+
 		// sum channels from connected buses
-		float bus_sum[6] = {};
+		float bus_sum[WIDE_BUS_CHANNELS] = {};
 
 		for (int b = 0; b < 6; b++) {
 			if (inputs[BUS_INPUTS + b].isConnected()) {
-				for (int c = 0; c < 6; c++) {
-					bus_sum[c] += inputs[BUS_INPUTS + b].getPolyVoltage(c) * road_fader[b].getFade();
-				}
+				float bus_in[WIDE_BUS_CHANNELS] = {};
+				BusCable<BUSES>::read(inputs[BUS_INPUTS + b], bus_in);
+
+				// delay shorter chains so every chain lines up with the longest
+				if (latency_compensation) road_delays[b].process(bus_in, bus_in, max_latency - bus_latencies[b]);
+
+				BusCable<BUSES>::mix(bus_sum, bus_in, road_fader[b].getFade());
 			}
 		}
 
-		// set output bus to summed channels
-		for (int c = 0; c < 6; c++) {
-			outputs[BUS_OUTPUT].setVoltage(bus_sum[c], c);
+		// bus out with one more sample of latency on the longest chain
+		BusCable<BUSES>::write(outputs[BUS_OUTPUT], bus_sum, max_latency + 1, latency_request.isRequested());
+	}
+
+	// on state of a bus from a scene, turned like a single click of its button, left alone while auditioning
+	void setOnState(int i, bool on) {
+		if (auditioning) return;
+		road_fader[i].on = on;
+	}
+
+	// delay lines for chains up to BUS_LATENCY_RANGE_MS apart, sized outside of process()
+	void setDelayLines(float sample_rate) {
+		int max_delay = (int)std::ceil(sample_rate * BUS_LATENCY_RANGE_MS * 0.001f);
+		for (int b = 0; b < 6; b++) {
+			road_delays[b].setMaxDelay(max_delay);
 		}
+	}
 
-		// set output to 3 stereo buses
-		outputs[BUS_OUTPUT].setChannels(6);
+	// chains further apart than the delay lines hold are lined up only as far as they go
+	bool isLatencyOutOfRange() {
+		return latency_compensation && latency_spread.load(std::memory_order_relaxed) > road_delays[0].getMaxDelay();
 	}
 
 	// save color theme
@@ -190,11 +252,16 @@ struct Road : Module {
 		json_object_set_new(rootJ, "temped6", json_integer(road_fader[5].temped));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "latency_compensation", json_integer(latency_compensation));
+		json_object_set_new(rootJ, "wide_bus", json_integer(wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
 		return rootJ;
 	}
 
 	// load color theme
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
 		json_t *onau_1J = json_object_get(rootJ, "onau_1");
 		if (onau_1J) road_fader[0].on = json_integer_value(onau_1J);
 		json_t *onau_2J = json_object_get(rootJ, "onau_2");
@@ -245,28 +312,44 @@ struct Road : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *latency_compensationJ = json_object_get(rootJ, "latency_compensation");
+		if (latency_compensationJ) {
+			latency_compensation = json_integer_value(latency_compensationJ);
+		} else {
+			if (onau_1J) latency_compensation = false;   // do not change existing patches
+		}
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// reset fader speed
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
 		for (int i = 0; i < 6; i++) {
+			onauButtons[i].setSampleRate(sample_rate);
+			road_fader[i].setSampleRate(sample_rate);
 			road_fader[i].setSpeed(fade_speed);
 		}
+		setDelayLines(sample_rate);
 	}
 
 	// reset on audition states when initialized
 	void onReset() override {
+		scene_memory.clear();
 		auditioning = false;
 		for (int i = 0; i < 6; i++) {
 			bus_audition[i] = false;
 			road_fader[i].on = true;
 		}
+		latency_compensation = true;
 	}
 };
 
 
 struct RoadWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
+	int walk_frame = 0;
 
 	RoadWidget(Road *module) {
 		setModule(module);
@@ -311,11 +394,24 @@ struct RoadWidget : ModuleWidget {
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.62, 114.107)), false, module, Road::BUS_OUTPUT, module ? &module->color_theme : NULL));
 	}
 
-#ifndef USING_CARDINAL_NOT_RACK
 	// build the menu
 	void appendContextMenu(Menu* menu) override {
 		Road* module = dynamic_cast<Road*>(this->module);
 
+		struct LatencyCompensationItem : MenuItem {
+			Road *module;
+			void onAction(const event::Action &e) override {
+				module->latency_compensation = !module->latency_compensation;
+			}
+		};
+
+		struct WideBusItem : MenuItem {
+			Road *module;
+			void onAction(const event::Action &e) override {
+				module->wide_bus = !module->wide_bus;
+			}
+		};
+
 		struct ThemeItem : MenuItem {
 			Road* module;
 			int theme;
@@ -375,25 +471,51 @@ struct RoadWidget : ModuleWidget {
 
 		menu->addChild(new MenuEntry);
 
+		LatencyCompensationItem *latencyCompensationItem = createMenuItem<LatencyCompensationItem>("Line Up Bus Chain Latencies", CHECKMARK(module->latency_compensation));
+		latencyCompensationItem->module = module;
+		menu->addChild(latencyCompensationItem);
+		if (module->isLatencyOutOfRange()) {
+			menu->addChild(createMenuLabel(string::f("Chains %d samples apart, lined up to %d", module->latency_spread.load(), module->road_delays[0].getMaxDelay())));
+		}
+
+		WideBusItem *wideBusItem = createMenuItem<WideBusItem>("Wide Bus, 8 Buses", CHECKMARK(module->wide_bus));
+		wideBusItem->module = module;
+		menu->addChild(wideBusItem);
+
+#ifndef USING_CARDINAL_NOT_RACK
+		menu->addChild(new MenuEntry);
+
 		ThemesItem *themesItem = createMenuItem<ThemesItem>("Panel Themes");
 		themesItem->rightText = RIGHT_ARROW;
 		themesItem->module = module;
 		menu->addChild(themesItem);
-	}
 #endif
+	}
 
-	// display the panel based on the theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			Road *road = (Road*)module;
+			if (road->use_default_theme) {
+				road->color_theme = gtg_default_theme;
+			}
+			if (++walk_frame >= 30) {   // follow cables patched up the chains twice a second or so
+				walk_frame = 0;
+				road->latency_marks.update(road, road->latency_in_use.load());
+			}
+			if (road->color_theme != applied_theme) {
+				applied_theme = road->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((Road*)module)->color_theme) == 0);
-			night_panel->visible = ((((Road*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
@@ -1,6 +1,11 @@
 #include "plugin.hpp"
 #include "gtgComponents.hpp"
 #include "gtgDSP.hpp"
+#include "gtgBus.hpp"
+#include "gtgAudition.hpp"
+#include "gtgMeter.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
 
 
 struct SchoolBus : Module {
@@ -33,11 +38,11 @@ struct SchoolBus : Module {
 		NUM_LIGHTS
 	};
 
+	gtgMeter meter;
 	LongPressButton on_button;
 	dsp::SchmittTrigger on_cv_trigger;
 	dsp::SchmittTrigger blue_post_trigger;
 	dsp::SchmittTrigger orange_post_trigger;
-	dsp::ClockDivider pan_divider;
 	dsp::ClockDivider light_divider;
 	AutoFader school_fader;
 	ConstantPan school_pan;
@@ -45,17 +50,33 @@ struct SchoolBus : Module {
 	SimpleSlewer post_btn_filters[2];
 
 	const int bypass_speed = 26;
-	const int pan_speed = 52;   // milliseconds from left to right
+	const int pan_speed = 156;   // milliseconds from left to right
 	const int level_speed = 26;   // for level cv filter
 	float fade_in = 26.f;
 	float fade_out = 26.f;
+	int fade_curve = FADE_CURVE_EXP;
 	bool auto_override = false;
 	bool auditioned = false;
+	int audition_group = 0;
+	uint32_t audition_epoch = AUDITION_EPOCH_UNSEEN;
 	bool post_fades[2] = {false, false};
 	bool pan_cv_filter = true;
 	bool level_cv_filter = true;
+	int pan_law = PAN_LAW_3DB;
 	int color_theme = 0;
 	bool use_default_theme = true;
+	SceneMemory scene_memory;
+	AutomationRecorder automation;
+	BusLink bus_link;
+	int block_i = 0;   // sample position in block ramps
+	float fade_gains[DSP_BLOCK_SIZE] = {};
+	float level_gains[3][DSP_BLOCK_SIZE] = {};
+	float post_gains[2][DSP_BLOCK_SIZE] = {};
+	float pan_levels[2][DSP_BLOCK_SIZE] = {};
+	bool fade_constant = true;
+	bool level_constant[3] = {true, true, true};
+	bool post_constant[2] = {true, true};
+	bool pan_constant = true;
 
 	SchoolBus() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -76,7 +97,6 @@ struct SchoolBus : Module {
 		configInput(LEVEL_CV_INPUTS + 2, "Red level CV");
 		configInput(BUS_INPUT, "Bus chain");
 		configOutput(BUS_OUTPUT, "Bus chain");
-		pan_divider.setDivision(3);
 		light_divider.setDivision(512);
 		school_fader.setSpeed(fade_in);
 		school_pan.setSmoothSpeed(pan_speed);
@@ -91,9 +111,20 @@ struct SchoolBus : Module {
 		post_fades[1] = post_fades[0];
 		gtg_default_theme = loadGtgPluginDefault("default_theme", 0);
 		color_theme = gtg_default_theme;
+		scene_memory.addParams(this, PAN_ATT_PARAM, 2);   // pan attenuverter and pan
+		scene_memory.addParams(this, LEVEL_PARAMS, 3);
+		scene_memory.addFader(&school_fader, [this](bool on) {setOnState(on);});
+		scene_memory.addToggle(&post_fades[0], [this](bool on) {post_fades[0] = on;});
+		scene_memory.addToggle(&post_fades[1], [this](bool on) {post_fades[1] = on;});
+		automation.addParams(this, PAN_PARAM, 1);
+		automation.addParams(this, LEVEL_PARAMS, 3);
+		automation.addFader(&school_fader, [this](bool on) {setOnState(on);});
+		bus_link.setup(this, BUS_INPUT, BUS_OUTPUT);
 	}
 
 	void process(const ProcessArgs &args) override {
+		scene_memory.process(args.sampleTime);   // scene commands from a Bus Depot
+		automation.process();   // recorded on states and knob moves
 
 		// on off button
 		switch (on_button.step(params[ON_PARAM])) {
@@ -101,8 +132,8 @@ struct SchoolBus : Module {
 		case LongPressButton::NO_PRESS:
 			break;
 		case LongPressButton::SHORT_PRESS:
-			if (audition_mixer) {
-				audition_mixer = false;   // single click turns off auditions
+			if (auditions.isActive(AUDITION_MIXER, audition_group)) {
+				auditions.stop(AUDITION_MIXER, audition_group);   // single click turns off auditions
 			} else {
 				if ((APP->window->getMods() & RACK_MOD_MASK) == RACK_MOD_CTRL) {   // bypass fades with ctrl click
 					auto_override = true;
@@ -128,7 +159,7 @@ struct SchoolBus : Module {
 			break;
 		case LongPressButton::LONG_PRESS:   // long press to audition
 
-			audition_mixer = true;   // all mixers to audition mode
+			auditions.start(AUDITION_MIXER, audition_group);   // all mixers in the group to audition mode
 
 			if (auditioned) {
 				auditioned = false;
@@ -149,14 +180,12 @@ struct SchoolBus : Module {
 
 		// process cv trigger
 		if (on_cv_trigger.process(inputs[ON_CV_INPUT].getVoltage())) {
-			if (!audition_mixer) {
+			if (!auditions.isActive(AUDITION_MIXER, audition_group)) {
 				auto_override = false;   // do not override automation
 				school_fader.on = !school_fader.on;
 			}
 		}
 
-		school_fader.process();
-
 		// post fader send buttons
 		if (blue_post_trigger.process(params[BLUE_POST_PARAM].getValue())) post_fades[0] = !post_fades[0];
 		if (orange_post_trigger.process(params[ORANGE_POST_PARAM].getValue())) post_fades[1] = !post_fades[1];
@@ -164,40 +193,38 @@ struct SchoolBus : Module {
 		// process fade states and light
 		if (light_divider.process()) {
 
-			if (use_default_theme) {
-				color_theme = gtg_default_theme;
-			}
-
-			if (audition_mixer) {   // all mixers are in audition state
-
-				// bypass all fade automation
-				auto_override = true;
-				school_fader.setSpeed(bypass_speed);
-
-				if (auditioned) {   // this mixer is being auditioned
-					school_fader.on =  true;
-				} else {   // mute the mixers
-					if (school_fader.on) {
-						school_fader.temped = true;   // remember this mixer was on
-					}
-					school_fader.on = false;
-				}
-			} else {   // stop auditions
+			if (auditions.hasChanged(AUDITION_MIXER, audition_group, audition_epoch)) {   // only when the group changes
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {   // all mixers are in audition state
 
-				// return to states before auditions
-				if (school_fader.temped) {
-					school_fader.temped = false;
+					// bypass all fade automation
 					auto_override = true;
 					school_fader.setSpeed(bypass_speed);
-					if (auditioned) {
+
+					if (auditioned) {   // this mixer is being auditioned
+						school_fader.on =  true;
+					} else {   // mute the mixers
+						if (school_fader.on) {
+							school_fader.temped = true;   // remember this mixer was on
+						}
 						school_fader.on = false;
-					} else {
-						school_fader.on = true;
 					}
-				}
+				} else {   // stop auditions
+
+					// return to states before auditions
+					if (school_fader.temped) {
+						school_fader.temped = false;
+						auto_override = true;
+						school_fader.setSpeed(bypass_speed);
+						if (auditioned) {
+							school_fader.on = false;
+						} else {
+							school_fader.on = true;
+						}
+					}
 
-				// turn off auditions
-				auditioned = false;
+					// turn off auditions
+					auditioned = false;
+				}
 			}
 
 			// process fade speed changes if dragging slider
@@ -218,7 +245,7 @@ struct SchoolBus : Module {
 			lights[ORANGE_POST_LIGHT].value = post_fades[1];
 
 			if (school_fader.getFade() == school_fader.getGain()) {
-				if (audition_mixer) {
+				if (auditions.isActive(AUDITION_MIXER, audition_group)) {
 					lights[ON_LIGHT + 0].value = 1.f;   // yellow when auditioned
 					lights[ON_LIGHT + 1].value = 1.f;
 				} else {
@@ -236,72 +263,93 @@ struct SchoolBus : Module {
 			}
 		}
 
-		// get input levels
-		float in_levels[3] = {0.f, 0.f, 0.f};
-		for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
-			in_levels[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
-		}
+		// calculate fade, level, post fader, and pan ramps once per block
+		if (block_i == 0) {
+			fade_constant = school_fader.processBlock(fade_gains, DSP_BLOCK_SIZE);
 
-		// smooth input levels
-		if (level_cv_filter) {
-			for (int sb = 0; sb < 3; sb++) {
-				in_levels[sb] = level_smoother[sb].slew(in_levels[sb]);
+			// get level targets and smooth them across the block
+			float level_targets[3] = {0.f, 0.f, 0.f};
+			for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
+				level_targets[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
+				if (level_cv_filter) {
+					level_constant[sb] = level_smoother[sb].slewBlock(level_targets[sb], level_gains[sb], DSP_BLOCK_SIZE);
+				}
 			}
-		}
 
-		// set post fades on levels
-		for (int i = 0; i < 2; i++) {
-			if (post_fades[i]) {
-				in_levels[i] *= post_btn_filters[i].slew(in_levels[2]);
-			} else {
-				in_levels[i] *= post_btn_filters[i].slew(1.f);
+			// post fades follow the red level
+			for (int i = 0; i < 2; i++) {
+				if (post_fades[i]) {
+					post_constant[i] = post_btn_filters[i].slewBlock(level_targets[2], post_gains[i], DSP_BLOCK_SIZE);
+				} else {
+					post_constant[i] = post_btn_filters[i].slewBlock(1.f, post_gains[i], DSP_BLOCK_SIZE);
+				}
 			}
-		}
 
-		// get stereo pan levels
-		if (pan_divider.process()) {   // calculate pan infrequently, useful for auto panning
+			// get stereo pan levels, useful for auto panning
 			if (inputs[PAN_CV_INPUT].isConnected()) {
 				float pan_pos = params[PAN_PARAM].getValue() + (((inputs[PAN_CV_INPUT].getNormalVoltage(0) * 2) * params[PAN_ATT_PARAM].getValue()) * 0.1);
-				if (pan_cv_filter) {
-					school_pan.setSmoothPan(pan_pos);
-				} else {
-					school_pan.setPan(pan_pos);
-				}
+				pan_constant = school_pan.levelsBlock(pan_pos, pan_levels[0], pan_levels[1], DSP_BLOCK_SIZE, pan_cv_filter);
 			} else {
-				school_pan.setPan(params[PAN_PARAM].getValue());
+				pan_constant = school_pan.levelsBlock(params[PAN_PARAM].getValue(), pan_levels[0], pan_levels[1], DSP_BLOCK_SIZE);
 			}
 		}
 
-		// get exponential fade
-		float exp_fade = 0.f;
-		if (school_fader.fading) {
-			exp_fade = school_fader.getExpFade(2.5);
-		} else {
-			exp_fade = school_fader.getFade();
+		// get input levels
+		float in_levels[3] = {0.f, 0.f, 0.f};
+		if (level_cv_filter) {
+			for (int sb = 0; sb < 3; sb++) {
+				in_levels[sb] = level_gains[sb][level_constant[sb] ? 0 : block_i];
+			}
+		} else {   // unfiltered level CVs are read every sample
+			for (int sb = 0; sb < 3; sb++) {
+				in_levels[sb] = clamp(inputs[LEVEL_CV_INPUTS + sb].getNormalVoltage(10) * 0.1f, 0.f, 1.f) * params[LEVEL_PARAMS + sb].getValue();
+			}
+		}
+
+		// set post fades on levels
+		for (int i = 0; i < 2; i++) {
+			in_levels[i] *= post_gains[i][post_constant[i] ? 0 : block_i];
 		}
 
-		// process inputs
+		float exp_fade = fade_gains[fade_constant ? 0 : block_i];
+		int pan_i = pan_constant ? 0 : block_i;
+
+		// roll block position
+		block_i++;
+		if (block_i >= DSP_BLOCK_SIZE) block_i = 0;
+
+		// process inputs, silent inputs are skipped
 		float stereo_in[2] = {0.f, 0.f};
-		if (inputs[R_INPUT].isConnected()) {   // get a channel from each cable input
-			stereo_in[0] = inputs[LMP_INPUT].getVoltage() * school_pan.getLevel(0) * exp_fade;
-			stereo_in[1] = inputs[R_INPUT].getVoltage() * school_pan.getLevel(1) * exp_fade;
-		} else {   // split mono or sum of polyphonic cable on LMP
-			float lmp_in = inputs[LMP_INPUT].getVoltageSum();
-			for (int c = 0; c < 2; c++) {
-				stereo_in[c] = lmp_in * school_pan.getLevel(c) * exp_fade;
+		if (!fade_constant || exp_fade > 0.f) {
+			float pan_left = pan_levels[0][pan_i] * exp_fade;
+			float pan_right = pan_levels[1][pan_i] * exp_fade;
+			if (inputs[R_INPUT].isConnected()) {   // get a channel from each cable input
+				stereo_in[0] = inputs[LMP_INPUT].getVoltage() * pan_left;
+				stereo_in[1] = inputs[R_INPUT].getVoltage() * pan_right;
+			} else {   // split mono or sum of polyphonic cable on LMP
+				float lmp_in = inputs[LMP_INPUT].getVoltageSum();
+				stereo_in[0] = lmp_in * pan_left;
+				stereo_in[1] = lmp_in * pan_right;
 			}
 		}
 
+		// red levels for the meter
+		meter.processStereo(stereo_in[0] * in_levels[2], stereo_in[1] * in_levels[2]);
+
+		// bus chain from the cable, or from a linked module on the left
+		float bus_chain[WIDE_BUS_CHANNELS] = {};
+		int chain_latency = bus_link.read(this, inputs[BUS_INPUT], bus_chain);
+		float *bus = bus_chain + bus_link.bankChannel();   // this module's 3 stereo buses
+
 		// process outputs
 		for (int sb = 0; sb < 3; sb++) {   // sb = stereo bus
 			for (int c = 0; c < 2; c++) {
-				int bus_channel = (2 * sb) + c;
-				outputs[BUS_OUTPUT].setVoltage((stereo_in[c] * in_levels[sb]) + inputs[BUS_INPUT].getPolyVoltage(bus_channel), bus_channel);
+				bus[(2 * sb) + c] += stereo_in[c] * in_levels[sb];
 			}
 		}
 
-		// set bus outputs for 3 stereo buses out
-		outputs[BUS_OUTPUT].setChannels(6);
+		// bus out with one more sample of latency on the chain, and on to a linked module on the right
+		bus_link.write(this, outputs[BUS_OUTPUT], bus_chain, chain_latency + 1);
 	}
 
 	// load on, post fades, and gain states
@@ -311,20 +359,33 @@ struct SchoolBus : Module {
 		json_object_set_new(rootJ, "blue_post_fade", json_integer(post_fades[0]));
 		json_object_set_new(rootJ, "orange_post_fade", json_integer(post_fades[1]));
 		json_object_set_new(rootJ, "gain", json_real(school_fader.getGain()));
+		json_object_set_new(rootJ, "pan_law", json_integer(pan_law));
 		json_object_set_new(rootJ, "pan_cv_filter", json_integer(pan_cv_filter));
 		json_object_set_new(rootJ, "level_cv_filter", json_integer(level_cv_filter));
 		json_object_set_new(rootJ, "fade_in", json_real(fade_in));
 		json_object_set_new(rootJ, "fade_out", json_real(fade_out));
-		json_object_set_new(rootJ, "audition_mixer", json_integer(audition_mixer));
+		json_object_set_new(rootJ, "fade_curve", json_integer(fade_curve));
+		json_object_set_new(rootJ, "audition_mixer", json_integer(auditions.isActive(AUDITION_MIXER, audition_group)));
+		json_object_set_new(rootJ, "audition_group", json_integer(audition_group));
 		json_object_set_new(rootJ, "auditioned", json_integer(auditioned));
 		json_object_set_new(rootJ, "temped", json_integer(school_fader.temped));
 		json_object_set_new(rootJ, "color_theme", json_integer(color_theme));
 		json_object_set_new(rootJ, "use_default_theme", json_integer(use_default_theme));
+		json_object_set_new(rootJ, "bus_link", json_integer(bus_link.linked));
+		json_object_set_new(rootJ, "wide_bus", json_integer(bus_link.wide_bus));
+		json_object_set_new(rootJ, "scenes", scene_memory.toJson());
+		json_object_set_new(rootJ, "automation", automation.toJson());
 		return rootJ;
 	}
 
 	// load on, post fades, and gain states
 	void dataFromJson(json_t *rootJ) override {
+		json_t *scenesJ = json_object_get(rootJ, "scenes");
+		if (scenesJ) scene_memory.fromJson(scenesJ);
+		json_t *automationJ = json_object_get(rootJ, "automation");
+		if (automationJ) automation.fromJson(automationJ);
+		json_t *audition_groupJ = json_object_get(rootJ, "audition_group");
+		if (audition_groupJ) setAuditionGroup(json_integer_value(audition_groupJ));
 		json_t *input_onJ = json_object_get(rootJ, "input_on");
 		if (input_onJ) school_fader.on = json_integer_value(input_onJ);
 		json_t *blue_post_fadeJ = json_object_get(rootJ, "blue_post_fade");
@@ -333,6 +394,8 @@ struct SchoolBus : Module {
 		if (orange_post_fadeJ) post_fades[1] = json_integer_value(orange_post_fadeJ);
 		json_t *gainJ = json_object_get(rootJ, "gain");
 		if (gainJ) school_fader.setGain((float)json_real_value(gainJ));
+		json_t *pan_lawJ = json_object_get(rootJ, "pan_law");
+		if (pan_lawJ) setPanLaw(json_integer_value(pan_lawJ));
 		json_t *pan_cv_filterJ = json_object_get(rootJ, "pan_cv_filter");
 		if (pan_cv_filterJ) {
 			pan_cv_filter = json_integer_value(pan_cv_filterJ);
@@ -349,11 +412,13 @@ struct SchoolBus : Module {
 		if (fade_inJ) fade_in = json_real_value(fade_inJ);
 		json_t *fade_outJ = json_object_get(rootJ, "fade_out");
 		if (fade_outJ) fade_out = json_real_value(fade_outJ);
+		json_t *fade_curveJ = json_object_get(rootJ, "fade_curve");
+		if (fade_curveJ) setFadeCurve(json_integer_value(fade_curveJ));
 		json_t *audition_mixerJ = json_object_get(rootJ, "audition_mixer");
 		if (audition_mixerJ) {
-			audition_mixer = json_integer_value(audition_mixerJ);
+			auditions.setActive(AUDITION_MIXER, audition_group, json_integer_value(audition_mixerJ));
 		} else {
-			audition_mixer = false;   // no auditioning when loading old patch right after auditioned patch
+			auditions.stop(AUDITION_MIXER, audition_group);   // no auditioning when loading old patch right after auditioned patch
 		}
 		json_t *auditionedJ = json_object_get(rootJ, "auditioned");
 		if (auditionedJ) auditioned = json_integer_value(auditionedJ);
@@ -367,41 +432,86 @@ struct SchoolBus : Module {
 		}
 		json_t *color_themeJ = json_object_get(rootJ, "color_theme");
 		if (color_themeJ) color_theme = json_integer_value(color_themeJ);
+		json_t *bus_linkJ = json_object_get(rootJ, "bus_link");
+		if (bus_linkJ) bus_link.linked = json_integer_value(bus_linkJ);
+		json_t *wide_busJ = json_object_get(rootJ, "wide_bus");
+		if (wide_busJ) bus_link.wide_bus = json_integer_value(wide_busJ);
 	}
 
 	// reset fader speed on sample rate change
 	void onSampleRateChange() override {
+		float sample_rate = APP->engine->getSampleRate();
+		on_button.setSampleRate(sample_rate);
+		school_fader.setSampleRate(sample_rate);
+		meter.setSampleRate(sample_rate);
 		if (school_fader.on) {
 			school_fader.setSpeed(fade_in);
 		} else {
 			school_fader.setSpeed(fade_out);
 		}
-		school_pan.setSmoothSpeed(pan_speed);
+		school_pan.setSampleRate(sample_rate);
 		for (int i = 0; i < 3; i++) {
-			level_smoother[i].setSlewSpeed(level_speed);
+			level_smoother[i].setSampleRate(sample_rate);
 		}
 		for (int i = 0; i < 2; i++) {
-			post_btn_filters[i].setSlewSpeed(level_speed);
+			post_btn_filters[i].setSampleRate(sample_rate);
 		}
 	}
 
+	// move to another solo group, the next check picks up the new group's state
+	void setAuditionGroup(int group) {
+		audition_group = clamp(group, 0, AUDITION_GROUPS - 1);
+		audition_epoch = AUDITION_EPOCH_UNSEEN;
+	}
+
 	// Initialize on state and post fades
 	void onReset() override {
+		scene_memory.clear();
+		automation.clear_requested.store(true);
 		school_fader.on = true;
 		school_fader.setGain(1.f);
 		fade_in = 26.f;
 		fade_out = 26.f;
+		setFadeCurve(FADE_CURVE_EXP);
 		post_fades[0] = loadGtgPluginDefault("default_post_fader", 0);
 		post_fades[1] = post_fades[0];
 		pan_cv_filter = true;
 		level_cv_filter = true;
-		audition_mixer = false;
+		auditions.stop(AUDITION_MIXER, audition_group);
+		setAuditionGroup(0);
+		setPanLaw(PAN_LAW_3DB);
+	}
+
+	// set pan law on pan object
+	void setPanLaw(int law) {
+		pan_law = law;
+		school_pan.setLaw(law);
+	}
+
+	// on state from a scene or automation, turned like a single click of the on button
+	// left alone while the audition group is active, so auditions are not undone
+	void setOnState(bool on) {
+		if (auditions.isActive(AUDITION_MIXER, audition_group) || on == school_fader.on) return;
+		auto_override = false;   // do not override automation
+		school_fader.on = on;
+		if (on) {
+			school_fader.setSpeed(int(fade_in));
+		} else {
+			school_fader.setSpeed(int(fade_out));
+		}
+	}
+
+	// set fade automation curve on fader
+	void setFadeCurve(int curve) {
+		fade_curve = curve;
+		school_fader.setCurve(curve);
 	}
 };
 
 
 struct SchoolBusWidget : ModuleWidget {
 	SvgPanel* night_panel;
+	int applied_theme = -1;
 
 	SchoolBusWidget(SchoolBus *module) {
 		setModule(module);
@@ -445,6 +555,11 @@ struct SchoolBusWidget : ModuleWidget {
 		addInput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(7.45, 114.1)), true, module, SchoolBus::BUS_INPUT, module ? &module->color_theme : NULL));
 
 		addOutput(createThemedPortCentered<gtgNutPort>(mm2px(Vec(23.1, 114.1)), false, module, SchoolBus::BUS_OUTPUT, module ? &module->color_theme : NULL));
+
+		// slim meter beside the input
+		gtgMeterDisplay *meter_display = createWidget<gtgMeterDisplay>(mm2px(Vec(11.0, 17.8)));
+		meter_display->meter = module ? &module->meter : NULL;
+		addChild(meter_display);
 	}
 
 	// create menu
@@ -623,6 +738,16 @@ struct SchoolBusWidget : ModuleWidget {
 		fadeOutSliderItem->box.size.x = 190.f;
 		menu->addChild(fadeOutSliderItem);
 
+		FadeCurvesItem<SchoolBus> *fadeCurvesItem = createMenuItem<FadeCurvesItem<SchoolBus>>("Fade Curve");
+		fadeCurvesItem->rightText = RIGHT_ARROW;
+		fadeCurvesItem->module = module;
+		menu->addChild(fadeCurvesItem);
+
+		AutomationItem<SchoolBus> *automationItem = createMenuItem<AutomationItem<SchoolBus>>("Automation Recorder");
+		automationItem->rightText = RIGHT_ARROW;
+		automationItem->module = module;
+		menu->addChild(automationItem);
+
 		menu->addChild(new MenuEntry);
 		menu->addChild(createMenuLabel("Mixer Settings"));
 
@@ -631,6 +756,11 @@ struct SchoolBusWidget : ModuleWidget {
 		gainsItem->module = module;
 		menu->addChild(gainsItem);
 
+		PanLawsItem<SchoolBus> *panLawsItem = createMenuItem<PanLawsItem<SchoolBus>>("Pan Law");
+		panLawsItem->rightText = RIGHT_ARROW;
+		panLawsItem->module = module;
+		menu->addChild(panLawsItem);
+
 		PanCvFiltersItem *panCvFiltersItem = createMenuItem<PanCvFiltersItem>("Pan CV Filter");
 		panCvFiltersItem->rightText = RIGHT_ARROW;
 		panCvFiltersItem->module = module;
@@ -646,6 +776,20 @@ struct SchoolBusWidget : ModuleWidget {
 		postFadesItem->module = module;
 		menu->addChild(postFadesItem);
 
+		BusLinkItem<SchoolBus> *busLinkItem = createMenuItem<BusLinkItem<SchoolBus>>("Bus In from Module on Left", CHECKMARK(module->bus_link.linked));
+		busLinkItem->module = module;
+		menu->addChild(busLinkItem);
+
+		WideBusesItem *wideBusesItem = createMenuItem<WideBusesItem>("Wide Bus");
+		wideBusesItem->rightText = RIGHT_ARROW;
+		wideBusesItem->wide_bus = &module->bus_link.wide_bus;
+		menu->addChild(wideBusesItem);
+
+		AuditionGroupsItem<SchoolBus> *auditionGroupsItem = createMenuItem<AuditionGroupsItem<SchoolBus>>("Audition Group");
+		auditionGroupsItem->rightText = RIGHT_ARROW;
+		auditionGroupsItem->module = module;
+		menu->addChild(auditionGroupsItem);
+
 #ifndef USING_CARDINAL_NOT_RACK
 		menu->addChild(new MenuEntry);
 
@@ -656,18 +800,26 @@ struct SchoolBusWidget : ModuleWidget {
 #endif
 	}
 
-	// display panel based on theme
+	// retheme the panel and components only when the theme changes
 	void step() override {
+		if (module) {
+			SchoolBus *school_bus = (SchoolBus*)module;
+			if (school_bus->use_default_theme) {
+				school_bus->color_theme = gtg_default_theme;
+			}
+			if (school_bus->color_theme != applied_theme) {
+				applied_theme = school_bus->color_theme;
+				applyGtgTheme(this, applied_theme);
+#ifndef USING_CARDINAL_NOT_RACK
+				getPanel()->visible = (applied_theme == 0);
+				night_panel->visible = (applied_theme == 1);
+#endif
+			}
+		}
 #ifdef USING_CARDINAL_NOT_RACK
 		Widget* panel = getPanel();
 		panel->visible = !settings::preferDarkPanels;
 		night_panel->visible = settings::preferDarkPanels;
-#else
-		if (module) {
-			Widget* panel = getPanel();
-			panel->visible = ((((SchoolBus*)module)->color_theme) == 0);
-			night_panel->visible = ((((SchoolBus*)module)->color_theme) == 1);
-		}
 #endif
 		Widget::step();
 	}
@@ -0,0 +1,98 @@
+#pragma once
+#include "plugin.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+
+// solo groups for auditioning, shared by every module on every engine thread
+// mixers use groups 1 to 4 and depots have their own 4, so a solo only mutes its own group
+// every start, stop, or change of who is auditioned adds to the group's epoch
+// modules keep the last epoch they saw and only rework their audition state when it moves
+
+const int AUDITION_GROUPS = 4;
+
+enum AuditionKinds {
+	AUDITION_MIXER,
+	AUDITION_DEPOT,
+	NUM_AUDITION_KINDS
+};
+
+struct AuditionCoordinator {
+
+	// starts auditions in a group, or tells the group a module joined or left the audition
+	void start(int kind, int group) {
+		AuditionGroup &g = getGroup(kind, group);
+		g.active.store(true);
+		g.epoch.fetch_add(1);
+	}
+
+	void stop(int kind, int group) {
+		AuditionGroup &g = getGroup(kind, group);
+		if (g.active.exchange(false)) g.epoch.fetch_add(1);
+	}
+
+	void setActive(int kind, int group, bool active) {
+		if (active) {
+			start(kind, group);
+		} else {
+			stop(kind, group);
+		}
+	}
+
+	bool isActive(int kind, int group) {
+		return getGroup(kind, group).active.load(std::memory_order_relaxed);
+	}
+
+	// true once after every change to the group, seen_epoch is kept by the module
+	bool hasChanged(int kind, int group, uint32_t &seen_epoch) {
+		uint32_t epoch = getGroup(kind, group).epoch.load();
+		if (epoch == seen_epoch) return false;
+		seen_epoch = epoch;
+		return true;
+	}
+
+private:
+
+	struct AuditionGroup {
+		std::atomic<bool> active {false};
+		std::atomic<uint32_t> epoch {0};
+	};
+
+	AuditionGroup groups[NUM_AUDITION_KINDS][AUDITION_GROUPS];
+
+	AuditionGroup &getGroup(int kind, int group) {
+		return groups[kind][std::min(std::max(group, 0), AUDITION_GROUPS - 1)];
+	}
+};
+
+extern AuditionCoordinator auditions;
+
+// a module's seen epoch starts here so its first check always reworks its state
+const uint32_t AUDITION_EPOCH_UNSEEN = UINT32_MAX;
+
+template <typename TModule>
+struct AuditionGroupItem : MenuItem {
+	TModule *module;
+	int group;
+	void onAction(const event::Action &e) override {
+		module->setAuditionGroup(group);
+	}
+};
+
+template <typename TModule>
+struct AuditionGroupsItem : MenuItem {
+	TModule *module;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+		for (int i = 0; i < AUDITION_GROUPS; i++) {
+			AuditionGroupItem<TModule> *audition_group_item = new AuditionGroupItem<TModule>;
+			audition_group_item->text = "Group " + std::to_string(i + 1) + ((i == 0) ? " (default)" : "");
+			audition_group_item->rightText = CHECKMARK(module->audition_group == i);
+			audition_group_item->module = module;
+			audition_group_item->group = i;
+			menu->addChild(audition_group_item);
+		}
+		return menu;
+	}
+};
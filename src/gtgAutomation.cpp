@@ -0,0 +1,147 @@
+#include "gtgAutomation.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// one thread for the whole plugin, it looks in on every armed strip and makes a spare chunk for any that took theirs
+// it runs only while a strip is armed, and is stopped by the last strip to disarm rather than at library unload
+struct AutomationFeeder {
+	std::mutex mutex;
+	std::vector<AutomationRecorder*> recorders;
+	std::condition_variable wake;
+	std::thread thread;
+	bool running = false;
+	uint32_t generation = 0;   // a thread quits once it is not the newest, even if another started right behind it
+
+	~AutomationFeeder() {
+		if (thread.joinable()) thread.detach();   // every strip is gone by now, so this is never reached while feeding
+	}
+
+	void add(AutomationRecorder *recorder) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (std::find(recorders.begin(), recorders.end(), recorder) == recorders.end()) recorders.push_back(recorder);
+		if (!running) {
+			running = true;
+			thread = std::thread(&AutomationFeeder::feedLoop, this, ++generation);
+		}
+	}
+
+	void remove(AutomationRecorder *recorder) {
+		std::thread stopped;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			recorders.erase(std::remove(recorders.begin(), recorders.end(), recorder), recorders.end());
+			if (!recorders.empty() || !running) return;
+			running = false;
+			stopped = std::move(thread);
+		}
+		wake.notify_all();
+		if (stopped.joinable()) stopped.join();   // outside the lock, the loop takes it to see running
+	}
+
+	void feedLoop(uint32_t thread_generation) {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (running && generation == thread_generation) {
+			for (AutomationRecorder *recorder : recorders) {
+				if (!recorder->spare.load()) recorder->spare.store(new AutomationChunk);   // only the audio thread empties it
+			}
+			wake.wait_for(lock, std::chrono::milliseconds(20));
+		}
+	}
+};
+
+static AutomationFeeder feeder;
+
+AutomationRecorder::~AutomationRecorder() {
+	feeder.remove(this);
+	AutomationChunk *chunk = head;
+	while (chunk) {
+		AutomationChunk *next = chunk->next.load();
+		delete chunk;
+		chunk = next;
+	}
+	delete spare.load();
+}
+
+// the first chunk is made here, later ones come from the feeder
+// disarming stops a take on the audio thread, the spare chunk left behind still takes its last events
+void AutomationRecorder::setArmed(bool arm) {
+	if (arm) {
+		if (!head) head = new AutomationChunk;
+		feeder.add(this);
+		armed.store(true, std::memory_order_release);
+	} else {
+		armed.store(false, std::memory_order_release);
+		stop_requested.store(true);
+		feeder.remove(this);
+	}
+}
+
+json_t *AutomationRecorder::toJson() {
+	std::vector<uint8_t> bytes;
+	for (AutomationChunk *chunk = head; chunk; chunk = chunk->next.load()) {
+		bytes.insert(bytes.end(), chunk->bytes, chunk->bytes + chunk->used.load());
+	}
+	uint64_t take_length = (state.load() == AUTOMATION_RECORDING) ? position.load() : length.load();
+
+	json_t *automationJ = json_object();
+	json_object_set_new(automationJ, "armed", json_integer(armed.load()));
+	json_object_set_new(automationJ, "looping", json_integer(looping.load()));
+	json_object_set_new(automationJ, "lanes", json_integer(param_ids.size() + faders.size()));
+	json_object_set_new(automationJ, "length", json_integer(take_length));
+	json_object_set_new(automationJ, "events", json_string(string::toBase64(bytes.data(), bytes.size()).c_str()));
+	return automationJ;
+}
+
+// the engine is stopped while a patch or preset loads, so the chunks can be remade here
+void AutomationRecorder::fromJson(json_t *automationJ) {
+	state.store(AUTOMATION_IDLE);
+	json_t *loopingJ = json_object_get(automationJ, "looping");
+	if (loopingJ) looping.store(json_integer_value(loopingJ));
+
+	std::vector<uint8_t> bytes;
+	json_t *lanesJ = json_object_get(automationJ, "lanes");
+	json_t *eventsJ = json_object_get(automationJ, "events");
+	if (lanesJ && eventsJ && json_integer_value(lanesJ) == (int)(param_ids.size() + faders.size())) {   // takes from another version are left out
+		bytes = string::fromBase64(json_string_value(eventsJ));
+	}
+
+	if (!head && !bytes.empty()) head = new AutomationChunk;
+	startTake();
+
+	// split into chunks on event boundaries, a broken event ends the take
+	size_t i = 0;
+	uint32_t event_count = 0;
+	while (i < bytes.size()) {
+		size_t size = 0;
+		while (i + size < bytes.size() && (bytes[i + size] & 0x80)) size++;   // time
+		size += 2;
+		if (i + size <= bytes.size() && !(bytes[i + size - 1] & AUTOMATION_ON_LANE)) {   // move
+			while (i + size < bytes.size() && (bytes[i + size] & 0x80)) size++;
+			size++;
+		}
+		if (i + size > bytes.size() || size > (size_t)AUTOMATION_EVENT_BYTES) break;
+
+		int used = write_chunk->used.load();
+		if (used + (int)size > AUTOMATION_CHUNK_BYTES) {
+			AutomationChunk *next = write_chunk->next.load();
+			if (!next) {
+				next = new AutomationChunk;
+				write_chunk->next.store(next);
+			}
+			write_chunk = next;
+			used = 0;
+		}
+		std::copy(bytes.begin() + i, bytes.begin() + i + size, write_chunk->bytes + used);
+		write_chunk->used.store(used + size);
+		i += size;
+		event_count++;
+	}
+	events.store(event_count);
+	json_t *lengthJ = json_object_get(automationJ, "length");
+	length.store((event_count > 0 && lengthJ) ? json_integer_value(lengthJ) : 0);
+
+	json_t *armedJ = json_object_get(automationJ, "armed");
+	setArmed(armedJ && json_integer_value(armedJ));
+}
@@ -0,0 +1,400 @@
+#pragma once
+#include "plugin.hpp"
+#include "gtgDSP.hpp"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+
+// records and plays back on states, level and pan moves of a mixer strip
+// events are a varint of samples since the last event, a lane byte, and for knob lanes a varint of the move since that knob's last event
+// knobs are 16 bit steps of their range, and moves are zigzag coded so small turns either way take one byte
+// the audio thread writes into chunks made ahead of time, and a plugin wide feeder thread keeps a spare chunk ready
+// Record, Play and Stop go to every armed strip at once, so strips recorded together stay together
+// on states are played back through the module's set_on, so the module can treat them like a click on its button
+
+const int AUTOMATION_CHUNK_BYTES = 1 << 16;
+const int AUTOMATION_EVENT_BYTES = 14;   // longest event, 10 byte time, lane, 3 byte move
+const int AUTOMATION_TICK = 32;   // samples between checks for knob moves
+const uint8_t AUTOMATION_ON_LANE = 0x80;   // lane byte of an on state, 0x40 is the state and the rest is the fader
+
+enum AutomationCommands {
+	AUTOMATION_STOP,
+	AUTOMATION_RECORD,
+	AUTOMATION_PLAY
+};
+
+enum AutomationStates {
+	AUTOMATION_IDLE,
+	AUTOMATION_RECORDING,
+	AUTOMATION_PLAYING
+};
+
+// epoch above the command in one word, so every armed strip starts on the same command
+struct AutomationTransport {
+	std::atomic<uint32_t> command_word {0};
+
+	void send(int command) {
+		uint32_t word = command_word.load();
+		while (!command_word.compare_exchange_weak(word, (((word >> 8) + 1) << 8) | (command & 0xff))) {}
+	}
+};
+
+extern AutomationTransport automation_transport;
+
+struct AutomationChunk {
+	uint8_t bytes[AUTOMATION_CHUNK_BYTES];
+	std::atomic<int> used {0};   // whole events only
+	std::atomic<AutomationChunk*> next {NULL};
+};
+
+struct AutomationRecorder {
+
+	// read from the ui thread
+	std::atomic<int> state {AUTOMATION_IDLE};
+	std::atomic<bool> armed {false};
+	std::atomic<bool> looping {false};
+	std::atomic<bool> clear_requested {false};
+	std::atomic<bool> stop_requested {false};   // disarmed, transport commands no longer reach the strip
+	std::atomic<uint64_t> length {0};   // samples in the take
+	std::atomic<uint64_t> position {0};   // samples into the take while recording or playing
+	std::atomic<uint32_t> events {0};
+	std::atomic<uint32_t> dropped_events {0};   // writes that found no room, a knob or button tries again until one fits
+
+	// spare chunk made by the feeder thread, taken by the audio thread
+	std::atomic<AutomationChunk*> spare {NULL};
+
+	AutomationRecorder() {
+		seen_word = automation_transport.command_word.load();
+	}
+
+	~AutomationRecorder();
+
+	// set up in the module constructor
+	void addParams(Module *module, int first_param, int count) {
+		automation_module = module;
+		for (int i = 0; i < count; i++) {
+			ParamQuantity *quantity = module->paramQuantities[first_param + i];
+			param_ids.push_back(first_param + i);
+			param_mins.push_back(quantity->getMinValue());
+			param_ranges.push_back(quantity->getMaxValue() - quantity->getMinValue());
+			last_values.push_back(0);
+		}
+	}
+
+	void addFader(AutoFader *fader, std::function<void(bool)> set_on) {
+		faders.push_back(fader);
+		fader_setters.push_back(set_on);
+		last_ons.push_back(false);
+	}
+
+	// every sample, before the module uses its params and faders
+	void process() {
+		uint32_t word = automation_transport.command_word.load(std::memory_order_relaxed);
+		if (word != seen_word) {
+			seen_word = word;
+			if (armed.load(std::memory_order_acquire)) command(word & 0xff);
+		}
+		if (stop_requested.load(std::memory_order_relaxed)) {
+			stop_requested.store(false);
+			command(AUTOMATION_STOP);   // a take recording when disarmed keeps what it has
+		}
+		if (clear_requested.load(std::memory_order_relaxed)) {
+			clear_requested.store(false);
+			state.store(AUTOMATION_IDLE);
+			startTake();   // an empty take
+		}
+
+		int current_state = state.load(std::memory_order_relaxed);
+		if (current_state == AUTOMATION_RECORDING) {
+			record();
+		} else if (current_state == AUTOMATION_PLAYING) {
+			play();
+		}
+	}
+
+	// ui thread
+	void setArmed(bool arm);
+	json_t *toJson();
+	void fromJson(json_t *automationJ);
+
+	uint64_t getBytes() {
+		uint64_t bytes = 0;
+		for (AutomationChunk *chunk = head; chunk; chunk = chunk->next.load()) {
+			bytes += chunk->used.load();
+		}
+		return bytes;
+	}
+
+private:
+
+	Module *automation_module = NULL;
+	std::vector<int> param_ids;
+	std::vector<float> param_mins;
+	std::vector<float> param_ranges;
+	std::vector<uint16_t> last_values;   // last recorded or played
+	std::vector<AutoFader*> faders;
+	std::vector<std::function<void(bool)>> fader_setters;
+	std::vector<bool> last_ons;
+	uint32_t seen_word = 0;
+
+	AutomationChunk *head = NULL;   // made on the ui thread before arming or by loading, never freed while armed
+	AutomationChunk *write_chunk = NULL;
+	uint64_t time = 0;   // samples into the take
+	uint64_t event_time = 0;   // of the last event written, or of the next event to play
+	int tick = 0;
+
+	// playback cursor, and the next event already read
+	AutomationChunk *read_chunk = NULL;
+	int read_i = 0;
+	bool has_event = false;
+	uint8_t event_lane = 0;
+	int event_move = 0;
+
+	void command(int command) {
+		int current_state = state.load(std::memory_order_relaxed);
+		if (current_state == AUTOMATION_RECORDING) length.store(time);
+		if (command == AUTOMATION_RECORD && head) {
+			startTake();
+			state.store(AUTOMATION_RECORDING);
+			for (size_t f = 0; f < faders.size(); f++) {   // the take starts from the strip as it is now
+				last_ons[f] = faders[f]->on;
+				writeEvent(AUTOMATION_ON_LANE | (last_ons[f] ? 0x40 : 0) | f, 0);
+			}
+			for (size_t i = 0; i < param_ids.size(); i++) {   // first moves are from 0
+				last_values[i] = quantize(i);
+				writeEvent(i, last_values[i]);
+			}
+		} else if (command == AUTOMATION_PLAY && head && length.load() > 0) {
+			startPlayback();
+			state.store(AUTOMATION_PLAYING);
+		} else {
+			state.store(AUTOMATION_IDLE);
+		}
+	}
+
+	// empty every chunk, they are kept for the next take so recording never frees or allocates
+	void startTake() {
+		for (AutomationChunk *chunk = head; chunk; chunk = chunk->next.load(std::memory_order_relaxed)) {
+			chunk->used.store(0, std::memory_order_release);
+		}
+		write_chunk = head;
+		time = 0;
+		event_time = 0;
+		tick = 0;
+		length.store(0);
+		position.store(0);
+		events.store(0);
+		dropped_events.store(0);
+	}
+
+	uint16_t quantize(int i) {
+		float value = (automation_module->params[param_ids[i]].getValue() - param_mins[i]) / param_ranges[i];
+		return (uint16_t)(clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+	}
+
+	void record() {
+		for (size_t f = 0; f < faders.size(); f++) {   // on states every sample, a dropped event is tried again
+			if (faders[f]->on != last_ons[f] && writeEvent(AUTOMATION_ON_LANE | (faders[f]->on ? 0x40 : 0) | f, 0)) {
+				last_ons[f] = faders[f]->on;
+			}
+		}
+		if (--tick <= 0) {   // knobs at control rate
+			tick = AUTOMATION_TICK;
+			for (size_t i = 0; i < param_ids.size(); i++) {
+				uint16_t value = quantize(i);
+				if (value != last_values[i] && writeEvent(i, value - last_values[i])) {
+					last_values[i] = value;
+				}
+			}
+		}
+		time++;
+		position.store(time, std::memory_order_relaxed);
+	}
+
+	// varint, 7 bits at a time with the top bit set on every byte but the last
+	static int putVarint(uint8_t *bytes, uint64_t value) {
+		int size = 0;
+		do {
+			bytes[size++] = (value & 0x7f) | ((value > 0x7f) ? 0x80 : 0);
+			value >>= 7;
+		} while (value > 0);
+		return size;
+	}
+
+	static uint64_t getVarint(const uint8_t *bytes, int &i) {
+		uint64_t value = 0;
+		int shift = 0;
+		uint8_t byte;
+		do {
+			byte = bytes[i++];
+			value |= (uint64_t)(byte & 0x7f) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+		return value;
+	}
+
+	bool writeEvent(uint8_t lane, int move) {
+		uint8_t event[AUTOMATION_EVENT_BYTES];
+		int size = putVarint(event, time - event_time);
+		event[size++] = lane;
+		if (!(lane & AUTOMATION_ON_LANE)) size += putVarint(event + size, (uint32_t)((move << 1) ^ (move >> 31)));
+
+		// move to the next chunk, or take the spare when the chunks run out
+		int used = write_chunk->used.load(std::memory_order_relaxed);
+		if (used + size > AUTOMATION_CHUNK_BYTES) {
+			AutomationChunk *next = write_chunk->next.load(std::memory_order_acquire);
+			if (!next) {
+				next = spare.exchange(NULL);
+				if (!next) {
+					dropped_events.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				write_chunk->next.store(next, std::memory_order_release);
+			}
+			write_chunk = next;
+			used = 0;
+		}
+		std::copy(event, event + size, write_chunk->bytes + used);
+		write_chunk->used.store(used + size, std::memory_order_release);
+		event_time = time;
+		events.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void startPlayback() {
+		read_chunk = head;
+		read_i = 0;
+		time = 0;
+		event_time = 0;
+		std::fill(last_values.begin(), last_values.end(), 0);
+		readEvent();
+	}
+
+	// reads the next event ahead of its time
+	void readEvent() {
+		while (read_chunk && read_i >= read_chunk->used.load(std::memory_order_acquire)) {
+			read_chunk = read_chunk->next.load(std::memory_order_acquire);
+			read_i = 0;
+		}
+		has_event = (read_chunk != NULL);
+		if (!has_event) return;
+		const uint8_t *bytes = read_chunk->bytes;
+		event_time += getVarint(bytes, read_i);
+		event_lane = bytes[read_i++];
+		if (!(event_lane & AUTOMATION_ON_LANE)) {
+			uint32_t zigzag = getVarint(bytes, read_i);
+			event_move = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+		}
+	}
+
+	// events land on the sample they were recorded on
+	void play() {
+		while (has_event && event_time <= time) {
+			if (event_lane & AUTOMATION_ON_LANE) {
+				size_t f = event_lane & 0x3f;
+				if (f < faders.size()) fader_setters[f](event_lane & 0x40);
+			} else if (event_lane < param_ids.size()) {
+				last_values[event_lane] += event_move;
+				automation_module->params[param_ids[event_lane]].setValue(param_mins[event_lane] + (param_ranges[event_lane] * last_values[event_lane] * (1.f / 65535.f)));
+			}
+			readEvent();
+		}
+		time++;
+		position.store(time, std::memory_order_relaxed);
+		if (time >= length.load(std::memory_order_relaxed)) {
+			if (looping.load(std::memory_order_relaxed)) {
+				startPlayback();
+			} else {
+				state.store(AUTOMATION_IDLE);
+			}
+		}
+	}
+};
+
+
+// automation menu for any module with an AutomationRecorder automation
+template <typename TModule>
+struct AutomationItem : MenuItem {
+	TModule *module;
+
+	struct ArmItem : MenuItem {
+		TModule *module;
+		void onAction(const event::Action &e) override {
+			module->automation.setArmed(!module->automation.armed.load());
+		}
+	};
+
+	struct TransportItem : MenuItem {
+		int command;
+		void onAction(const event::Action &e) override {
+			automation_transport.send(command);
+		}
+	};
+
+	struct LoopItem : MenuItem {
+		TModule *module;
+		void onAction(const event::Action &e) override {
+			module->automation.looping.store(!module->automation.looping.load());
+		}
+	};
+
+	struct ClearItem : MenuItem {
+		TModule *module;
+		void onAction(const event::Action &e) override {
+			module->automation.clear_requested.store(true);
+		}
+	};
+
+	// state and size of the take, updated live while the menu is open
+	struct StatusLabel : MenuLabel {
+		TModule *module;
+		void step() override {
+			AutomationRecorder &automation = module->automation;
+			float sample_rate = APP->engine->getSampleRate();
+			int seconds = automation.position.load() / sample_rate;
+			int take_seconds = automation.length.load() / sample_rate;
+			int state = automation.state.load();
+			if (state == AUTOMATION_RECORDING) {
+				text = string::f("Recording %d:%02d", seconds / 60, seconds % 60);
+			} else if (state == AUTOMATION_PLAYING) {
+				text = string::f("Playing %d:%02d of %d:%02d", seconds / 60, seconds % 60, take_seconds / 60, take_seconds % 60);
+			} else {
+				text = string::f("Take %d:%02d", take_seconds / 60, take_seconds % 60);
+			}
+			text += string::f(", %u events, %.1f KB", automation.events.load(), automation.getBytes() / 1024.f);
+			if (automation.dropped_events.load() > 0) text += string::f(", %u dropped", automation.dropped_events.load());
+			MenuLabel::step();
+		}
+	};
+
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+
+		ArmItem *arm_item = createMenuItem<ArmItem>("Arm This Strip", CHECKMARK(module->automation.armed.load()));
+		arm_item->module = module;
+		menu->addChild(arm_item);
+
+		std::string transport_titles[3] = {"Stop Armed Strips", "Record Armed Strips", "Play Armed Strips"};
+		int transport_commands[3] = {AUTOMATION_RECORD, AUTOMATION_PLAY, AUTOMATION_STOP};
+		for (int i = 0; i < 3; i++) {
+			TransportItem *transport_item = createMenuItem<TransportItem>(transport_titles[transport_commands[i]]);
+			transport_item->command = transport_commands[i];
+			menu->addChild(transport_item);
+		}
+
+		LoopItem *loop_item = createMenuItem<LoopItem>("Loop Playback", CHECKMARK(module->automation.looping.load()));
+		loop_item->module = module;
+		menu->addChild(loop_item);
+
+		ClearItem *clear_item = createMenuItem<ClearItem>("Clear This Strip");
+		clear_item->module = module;
+		menu->addChild(clear_item);
+
+		menu->addChild(new MenuEntry);
+		StatusLabel *status_label = new StatusLabel;
+		status_label->module = module;
+		menu->addChild(status_label);
+		return menu;
+	}
+};
@@ -0,0 +1,84 @@
+#include "gtgBus.hpp"
+#include <mutex>
+
+// every bus module with a latency request, held while a Road walks the patch so none is freed under it
+static std::mutex requests_mutex;
+static std::vector<BusLatencyRequest*> requests;
+static uint64_t last_serial = 0;
+
+static BusLatencyRequest *findRequest(Module *module) {
+	for (BusLatencyRequest *request : requests) {
+		if (request->module == module) return request;
+	}
+	return NULL;
+}
+
+static BusLatencyRequest *findRequest(uint64_t serial) {
+	for (BusLatencyRequest *request : requests) {
+		if (request->serial == serial) return request;
+	}
+	return NULL;
+}
+
+BusLatencyRequest::~BusLatencyRequest() {
+	std::lock_guard<std::mutex> lock(requests_mutex);
+	requests.erase(std::remove(requests.begin(), requests.end(), this), requests.end());
+}
+
+void BusLatencyRequest::setup(Module *bus_module, int bus_input, int bus_inputs, int bus_output, bool *link) {
+	std::lock_guard<std::mutex> lock(requests_mutex);
+	module = bus_module;
+	first_input = bus_input;
+	input_count = bus_inputs;
+	output = bus_output;
+	linked = link;
+	serial = ++last_serial;
+	if (std::find(requests.begin(), requests.end(), this) == requests.end()) requests.push_back(this);
+}
+
+// from the Road upstream through bus inputs to bus outputs, and through links to the module on the left
+void BusLatencyMarks::update(Module *road, bool in_use) {
+	std::lock_guard<std::mutex> lock(requests_mutex);
+	std::vector<uint64_t> chain;
+	if (in_use) {
+		std::vector<engine::Cable*> cables;
+		for (int64_t cable_id : APP->engine->getCableIds()) {
+			engine::Cable *cable = APP->engine->getCable(cable_id);
+			if (cable) cables.push_back(cable);
+		}
+
+		std::vector<Module*> walked = {road};
+		for (size_t w = 0; w < walked.size(); w++) {
+			BusLatencyRequest *request = findRequest(walked[w]);
+			if (!request) continue;
+
+			std::vector<Module*> upstream;
+			for (engine::Cable *cable : cables) {
+				if (cable->inputModule != walked[w] || cable->inputId < request->first_input || cable->inputId >= request->first_input + request->input_count) continue;
+				BusLatencyRequest *upstream_request = findRequest(cable->outputModule);
+				if (upstream_request && cable->outputId == upstream_request->output) upstream.push_back(cable->outputModule);
+			}
+			if (request->linked && *request->linked && !walked[w]->inputs[request->first_input].isConnected() && walked[w]->leftExpander.module) {
+				if (findRequest(walked[w]->leftExpander.module)) upstream.push_back(walked[w]->leftExpander.module);
+			}
+
+			for (Module *module : upstream) {
+				if (std::find(walked.begin(), walked.end(), module) != walked.end()) continue;   // a loop in the patch
+				walked.push_back(module);
+				chain.push_back(findRequest(module)->serial);
+			}
+		}
+	}
+
+	// count this Road on modules newly reached, and take it off modules no longer reached
+	for (uint64_t serial : chain) {
+		if (std::find(marked.begin(), marked.end(), serial) != marked.end()) continue;
+		findRequest(serial)->roads.fetch_add(1);
+	}
+	for (uint64_t serial : marked) {
+		if (std::find(chain.begin(), chain.end(), serial) != chain.end()) continue;
+		BusLatencyRequest *request = findRequest(serial);
+		if (request) request->roads.fetch_sub(1);
+	}
+	marked = chain;
+}
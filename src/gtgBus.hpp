@@ -0,0 +1,275 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+#include <vector>
+
+
+// the bus cable carries 3 stereo buses on 6 channels
+// while the chain feeds a Road lining chains up, it also carries the chain latency on a 7th channel and a fixed tag on an 8th
+// every module adds the samples it delays the chain, and Road delays the shorter chains to match the longest
+// the tag keeps other poly cables from being read as latency, and chains that reach no such Road stay at 6 channels
+const int BUS_CHANNELS = 6;
+const int BUS_LATENCY_CHANNEL = 6;
+const int BUS_TAG_CHANNEL = 7;
+const int BUS_LATENCY_CHANNELS = 8;
+const float BUS_LATENCY_VOLTS = 0.01f;   // volts per sample of latency, 10 V is 1000 samples
+const float BUS_LATENCY_TAG = -7.6171875f;   // exact in a float, and not a voltage anything sends on purpose
+const float BUS_LATENCY_RANGE_MS = 250.f;   // Road lines up chains this far apart, a Bus Route at its longest delay with room for limiters and hops
+
+// the bus ports of a module, and the Roads lining up a chain it feeds
+// each Road walks the cables and links upstream from its bus inputs and counts itself on every bus module it reaches
+// set up in the module constructor, the registry lives in gtgBus.cpp
+struct BusLatencyRequest {
+	Module *module = NULL;
+	int first_input = 0;
+	int input_count = 1;
+	int output = 0;
+	bool *linked = NULL;   // the module takes its bus from the module on the left while its bus input is unpatched
+	uint64_t serial = 0;   // never reused, so a Road cannot count off a module that replaced one it counted
+	std::atomic<int> roads {0};
+
+	~BusLatencyRequest();
+	void setup(Module *bus_module, int bus_input, int bus_inputs, int bus_output, bool *link = NULL);
+
+	bool isRequested() {
+		return roads.load(std::memory_order_relaxed) > 0;
+	}
+};
+
+// the bus modules a Road counts itself on, walked again from the ui thread while it lines chains up
+struct BusLatencyMarks {
+	std::vector<uint64_t> marked;
+
+	// in_use false takes the Road off every module, as when it is removed
+	void update(Module *road, bool in_use);
+};
+
+inline int busLatency(float voltage) {
+	return std::max((int)std::round(voltage / BUS_LATENCY_VOLTS), 0);
+}
+
+inline bool isBusLatencyCarrier(int channels, float tag) {
+	return channels == BUS_LATENCY_CHANNELS && tag == BUS_LATENCY_TAG;
+}
+
+// the wide bus carries 8 stereo buses on all 16 channels, with no room left for latency
+// each module on a wide chain adds to 3 neighbouring buses, chosen in its menu
+const int WIDE_BUSES = 8;
+const int WIDE_BUS_CHANNELS = 16;
+
+// latency of a bus input, a bus without the tag or a wide bus counts as 0
+inline int getBusLatency(Input &bus_input) {
+	if (!isBusLatencyCarrier(bus_input.getChannels(), bus_input.getVoltage(BUS_TAG_CHANNEL))) return 0;
+	return busLatency(bus_input.getVoltage(BUS_LATENCY_CHANNEL));
+}
+
+// sets the channel count of a bus output, with the latency and tag while a Road down the chain is using them
+inline void setBusLatency(Output &bus_output, int latency, bool carry_latency) {
+	if (carry_latency) {
+		bus_output.setVoltage(latency * BUS_LATENCY_VOLTS, BUS_LATENCY_CHANNEL);
+		bus_output.setVoltage(BUS_LATENCY_TAG, BUS_TAG_CHANNEL);
+		bus_output.setChannels(BUS_LATENCY_CHANNELS);
+	} else {
+		bus_output.setChannels(BUS_CHANNELS);
+	}
+}
+
+
+// bus cable formats, 3 stereo buses with latency or the wide bus
+// read() fills bus with CHANNELS values from the cable and returns the chain latency, write() sets the cable from bus
+// mix() adds a bus times a level, and mixStereo() sums every stereo bus to left and right
+// modules pick a format once per sample, so the bus count is fixed at compile time in their loops
+template <int BUSES>
+struct BusCable;
+
+template <>
+struct BusCable<3> {
+	static const int CHANNELS = BUS_CHANNELS;
+
+	static int read(Input &bus_input, float *bus) {
+		for (int c = 0; c < CHANNELS; c++) {
+			bus[c] = bus_input.getPolyVoltage(c);
+		}
+		return getBusLatency(bus_input);
+	}
+
+	static void write(Output &bus_output, const float *bus, int latency, bool carry_latency) {
+		for (int c = 0; c < CHANNELS; c++) {
+			bus_output.setVoltage(bus[c], c);
+		}
+		setBusLatency(bus_output, latency, carry_latency);
+	}
+
+	static void mix(float *sum, const float *bus, float level) {
+		for (int c = 0; c < CHANNELS; c++) {
+			sum[c] += bus[c] * level;
+		}
+	}
+
+	static void mixStereo(const float *bus, float *stereo) {
+		for (int c = 0; c < 2; c++) {
+			stereo[c] = bus[c] + bus[c + 2] + bus[c + 4];
+		}
+	}
+};
+
+template <>
+struct BusCable<WIDE_BUSES> {
+	static const int CHANNELS = WIDE_BUS_CHANNELS;
+
+	static int read(Input &bus_input, float *bus) {
+		for (int c = 0; c < CHANNELS; c += 4) {
+			bus_input.getPolyVoltageSimd<simd::float_4>(c).store(&bus[c]);
+		}
+
+		// silence channels past the cable, and the latency and tag of a 3 bus cable
+		int channels = bus_input.getChannels();
+		if (channels > 1) {
+			if (isBusLatencyCarrier(channels, bus_input.getVoltage(BUS_TAG_CHANNEL))) channels = BUS_CHANNELS;
+			for (int c = channels; c < CHANNELS; c++) {
+				bus[c] = 0.f;
+			}
+		}
+		return 0;
+	}
+
+	static void write(Output &bus_output, const float *bus, int latency, bool carry_latency) {
+		for (int c = 0; c < CHANNELS; c += 4) {
+			bus_output.setVoltageSimd(simd::float_4::load(&bus[c]), c);
+		}
+		bus_output.setChannels(CHANNELS);
+	}
+
+	static void mix(float *sum, const float *bus, float level) {
+		for (int c = 0; c < CHANNELS; c += 4) {
+			simd::float_4 mixed = simd::float_4::load(&sum[c]) + simd::float_4::load(&bus[c]) * level;
+			mixed.store(&sum[c]);
+		}
+	}
+
+	static void mixStereo(const float *bus, float *stereo) {
+		simd::float_4 pairs = 0.f;   // left, right, left, right
+		for (int c = 0; c < CHANNELS; c += 4) {
+			pairs += simd::float_4::load(&bus[c]);
+		}
+		stereo[0] = pairs.s[0] + pairs.s[2];
+		stereo[1] = pairs.s[1] + pairs.s[3];
+	}
+};
+
+
+// bus chain modules that can pass the 6 bus channels to a touching module without a cable
+inline bool isBusLinkModel(Model *model) {
+	return model == modelGigBus || model == modelMiniBus || model == modelSchoolBus || model == modelMetroCityBus
+		|| model == modelEnterBus || model == modelBusRoute || model == modelBusDepot || model == modelBusTerminal;
+}
+
+struct BusMessage {
+	float voltages[WIDE_BUS_CHANNELS] = {};
+	int channels = 0;   // channels of the sending module's bus output
+};
+
+// bus chain through Rack expanders, from the module on the left to the module on the right
+// a linked module takes its bus from the left module only while its bus input is unpatched
+// Rack flips expander messages once per frame, so each link still delays the bus by one sample like a cable
+
+struct BusLink {
+	bool linked = false;   // take the bus from the module on the left, off so old patches do not change
+	int wide_bus = 0;   // 0 for the 3 bus cable, or the first of the 3 wide buses this module uses
+	BusMessage messages[2];
+	BusLatencyRequest latency_request;
+
+	void setup(Module *module, int bus_input, int bus_output) {
+		module->leftExpander.producerMessage = &messages[0];
+		module->leftExpander.consumerMessage = &messages[1];
+		latency_request.setup(module, bus_input, 1, bus_output, &linked);
+	}
+
+	bool isLinked(Module *module, Input &bus_input) {
+		return linked && !bus_input.isConnected() && module->leftExpander.module && isBusLinkModel(module->leftExpander.module->model);
+	}
+
+	// first channel of the 3 stereo buses this module uses
+	int bankChannel() {
+		return wide_bus > 0 ? (wide_bus - 1) * 2 : 0;
+	}
+
+	// fills bus from the cable, or from the module on the left when linked, and returns the chain latency
+	// bus needs room for WIDE_BUS_CHANNELS
+	int read(Module *module, Input &bus_input, float *bus) {
+		if (wide_bus > 0) return read<WIDE_BUSES>(module, bus_input, bus);
+		return read<3>(module, bus_input, bus);
+	}
+
+	template <int BUSES>
+	int read(Module *module, Input &bus_input, float *bus) {
+		if (!isLinked(module, bus_input)) return BusCable<BUSES>::read(bus_input, bus);
+
+		BusMessage *message = (BusMessage*)module->leftExpander.consumerMessage;
+		for (int c = 0; c < BusCable<BUSES>::CHANNELS; c++) {
+			bus[c] = message->voltages[c];
+		}
+		if (!isBusLatencyCarrier(message->channels, message->voltages[BUS_TAG_CHANNEL])) return 0;
+		if (BusCable<BUSES>::CHANNELS > BUS_LATENCY_CHANNEL) {
+			bus[BUS_LATENCY_CHANNEL] = 0.f;   // a wide module reading a 3 bus module
+			bus[BUS_TAG_CHANNEL] = 0.f;
+			return 0;
+		}
+		return busLatency(message->voltages[BUS_LATENCY_CHANNEL]);
+	}
+
+	// sets the bus output, then passes it on to a bus module on the right
+	void write(Module *module, Output &bus_output, const float *bus, int latency) {
+		if (wide_bus > 0) {
+			BusCable<WIDE_BUSES>::write(bus_output, bus, latency, false);
+		} else {
+			BusCable<3>::write(bus_output, bus, latency, latency_request.isRequested());
+		}
+		int channels = bus_output.getChannels();   // with or without the latency and tag
+
+		Module *right_module = module->rightExpander.module;
+		if (right_module && isBusLinkModel(right_module->model)) {
+			BusMessage *message = (BusMessage*)right_module->leftExpander.producerMessage;
+			for (int c = 0; c < WIDE_BUS_CHANNELS; c++) {
+				message->voltages[c] = c < channels ? bus_output.getVoltage(c) : 0.f;
+			}
+			message->channels = channels;
+			right_module->leftExpander.requestMessageFlip();
+		}
+	}
+};
+
+
+// menu toggle for taking the bus from a linked module on the left
+template <typename TModule>
+struct BusLinkItem : MenuItem {
+	TModule *module;
+	void onAction(const event::Action &e) override {
+		module->bus_link.linked = !module->bus_link.linked;
+	}
+};
+
+// menu for the 3 bus cable or a bank of the wide bus
+struct WideBusItem : MenuItem {
+	int *wide_bus;
+	int setting;
+	void onAction(const event::Action &e) override {
+		*wide_bus = setting;
+	}
+};
+
+struct WideBusesItem : MenuItem {
+	int *wide_bus;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+		for (int i = 0; i <= WIDE_BUSES - 2; i++) {
+			WideBusItem *wide_bus_item = new WideBusItem;
+			wide_bus_item->text = (i == 0) ? "Off, 3 Buses" : "Buses " + std::to_string(i) + "-" + std::to_string(i + 2) + " of 8";
+			wide_bus_item->rightText = CHECKMARK(*wide_bus == i);
+			wide_bus_item->wide_bus = wide_bus;
+			wide_bus_item->setting = i;
+			menu->addChild(wide_bus_item);
+		}
+		return menu;
+	}
+};
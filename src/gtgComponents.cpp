@@ -1,6 +1,17 @@
 #include "gtgComponents.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
+// themed components are direct children of the module widget
+void applyGtgTheme(Widget *module_widget, int theme) {
+	for (Widget *child : module_widget->children) {
+		gtgThemedWidget *themed = dynamic_cast<gtgThemedWidget*>(child);
+		if (themed) themed->setTheme(theme);
+	}
+}
+
 // themed button (switch)
 void gtgThemedSvgSwitch::addFrameAll(std::shared_ptr<Svg> svg) {
 	framesAll.push_back(svg);
@@ -10,21 +21,18 @@ void gtgThemedSvgSwitch::addFrameAll(std::shared_ptr<Svg> svg) {
 	}
 }
 
-void gtgThemedSvgSwitch::step() {
-	if(theme != NULL && *theme != old_theme) {
-		if ((*theme) == 0 || framesAll.size() < 4) {
-			frames[0]=framesAll[0];
-			frames[1]=framesAll[1];
-		}
-		else {
-			frames[0]=framesAll[2];
-			frames[1]=framesAll[3];
-		}
-		old_theme = *theme;
-		onChange(*(new event::Change()));
-		fb->dirty = true;
+void gtgThemedSvgSwitch::setTheme(int theme) {
+	if (theme == 0 || framesAll.size() < 4) {
+		frames[0] = framesAll[0];
+		frames[1] = framesAll[1];
+	}
+	else {
+		frames[0] = framesAll[2];
+		frames[1] = framesAll[3];
 	}
-	SvgSwitch::step();
+	event::Change e;   // show the frame for the current value
+	onChange(e);
+	fb->dirty = true;
 }
 
 // themed knob
@@ -35,18 +43,9 @@ void gtgThemedSvgKnob::addFrameAll(std::shared_ptr<Svg> svg) {
 	}
 }
 
-void gtgThemedSvgKnob::step() {
-	if(theme != NULL && *theme != old_theme) {
-		if ((*theme) == 0) {
-			setSvg(framesAll[0]);
-		}
-		else {
-			setSvg(framesAll[1]);
-		}
-		old_theme = *theme;
-		fb->dirty = true;
-	}
-	SvgKnob::step();
+void gtgThemedSvgKnob::setTheme(int theme) {
+	setSvg(framesAll[(theme == 0) ? 0 : 1]);
+	fb->dirty = true;
 }
 
 // themed snap knob
@@ -57,18 +56,9 @@ void gtgThemedRoundBlackSnapKnob::addFrameAll(std::shared_ptr<Svg> svg) {
 	}
 }
 
-void gtgThemedRoundBlackSnapKnob::step() {
-	if(theme != NULL && *theme != old_theme) {
-		if ((*theme) == 0) {
-			setSvg(framesAll[0]);
-		}
-		else {
-			setSvg(framesAll[1]);
-		}
-		old_theme = *theme;
-		fb->dirty = true;
-	}
-	SvgKnob::step();
+void gtgThemedRoundBlackSnapKnob::setTheme(int theme) {
+	setSvg(framesAll[(theme == 0) ? 0 : 1]);
+	fb->dirty = true;
 }
 
 // themed port
@@ -79,13 +69,9 @@ void gtgThemedSvgPort::addFrame(std::shared_ptr<Svg> svg) {
 	}
 }
 
-void gtgThemedSvgPort::step() {
-	if(theme != NULL && *theme != old_theme) {
-		sw->setSvg(frames[*theme]);
-		old_theme = *theme;
-		fb->dirty = true;
-	}
-	PortWidget::step();
+void gtgThemedSvgPort::setTheme(int theme) {
+	sw->setSvg(frames[clamp(theme, 0, (int)frames.size() - 1)]);
+	fb->dirty = true;
 }
 
 // themed screw
@@ -96,60 +82,126 @@ void gtgThemedSvgScrew::addFrame(std::shared_ptr<Svg> svg) {
 	}
 }
 
-void gtgThemedSvgScrew::step() {
-	if(theme != NULL && *theme != old_theme) {
-		sw->setSvg(frames[*theme]);
-		old_theme = *theme;
-		fb->dirty = true;
-	}
-	SvgScrew::step();
+void gtgThemedSvgScrew::setTheme(int theme) {
+	sw->setSvg(frames[clamp(theme, 0, (int)frames.size() - 1)]);
+	fb->dirty = true;
 }
 
-// save a plugin default integer
-void saveGtgPluginDefault(const char* plugin_setting, int setting_value) {
-	json_t *settingsJ = json_object();
-	std::string settingsFilename = asset::user("GlueTheGiant.json");
-
-	FILE *file;
+// plugin defaults are read from GlueTheGiant.json once and kept in memory
+// saves update the memory copy and wake a writer thread, which waits a moment so a burst of saves is one write
+// the plugin stops the writer from destroy(), nothing is joined in a static destructor
+struct GtgPluginDefaults {
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::thread writer;
+	json_t *settingsJ = NULL;
+	bool dirty = false;
+	bool stopping = false;
+
+	// write anything not yet written and stop the writer, saves after this write straight to the file
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		if (writer.joinable()) writer.join();
+	}
 
-	file = fopen(settingsFilename.c_str(), "r");
-	if (file) {
-		json_error_t error;
-		settingsJ = json_loadf(file, 0, &error);
-		fclose(file);
+	// stop() has already run, a writer left over here is let go rather than joined
+	~GtgPluginDefaults() {
+		if (writer.joinable()) writer.detach();
+		if (settingsJ) json_decref(settingsJ);
 	}
 
-	json_object_set_new(settingsJ, plugin_setting, json_integer(setting_value));
+	// call with the mutex locked
+	void loadFile() {
+		if (settingsJ) return;
+		std::string settingsFilename = asset::user("GlueTheGiant.json");
+		FILE *file = fopen(settingsFilename.c_str(), "r");
+		if (file) {
+			json_error_t error;
+			settingsJ = json_loadf(file, 0, &error);
+			fclose(file);
+		}
+		if (!settingsJ) settingsJ = json_object();   // file does not exist or invalid
+	}
 
-	file = fopen(settingsFilename.c_str(), "w");
-	if (file) {
-		json_dumpf(settingsJ, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
-		fclose(file);
+	void load() {
+		std::lock_guard<std::mutex> lock(mutex);
+		loadFile();
 	}
 
-	json_decref(settingsJ);
-}
+	int get(const char* plugin_setting, int default_value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		loadFile();
+		json_t *default_valueJ = json_object_get(settingsJ, plugin_setting);
+		if (default_valueJ) default_value = json_integer_value(default_valueJ);
+		return default_value;
+	}
 
-// load a plugin default integer
-int loadGtgPluginDefault(const char* plugin_setting, int default_value) {
-	std::string settingsFilename = asset::user("GlueTheGiant.json");
+	void set(const char* plugin_setting, int setting_value) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			loadFile();
+			json_object_set_new(settingsJ, plugin_setting, json_integer(setting_value));
+			if (stopping) {
+				writeFile(settingsJ);
+				return;
+			}
+			dirty = true;
+			if (!writer.joinable()) writer = std::thread(&GtgPluginDefaults::writeLoop, this);
+		}
+		wake.notify_one();
+	}
 
-	FILE *file = fopen(settingsFilename.c_str(), "r");
-	if (!file) {   // file does not exist
-		return default_value;
+	void writeLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			wake.wait(lock, [this] { return dirty || stopping; });
+			if (!stopping) {   // let more saves arrive before writing
+				wake.wait_for(lock, std::chrono::milliseconds(250), [this] { return stopping; });
+			}
+			if (dirty) {
+				json_t *snapshotJ = json_deep_copy(settingsJ);
+				dirty = false;
+				lock.unlock();
+				writeFile(snapshotJ);
+				json_decref(snapshotJ);
+				lock.lock();
+			}
+			if (stopping && !dirty) return;
+		}
 	}
 
-	json_error_t error;
-	json_t *settingsJ = json_loadf(file, 0, &error);
-	if (!settingsJ) {   // file invalid
-		fclose(file);
-		return default_value;
+	void writeFile(json_t *snapshotJ) {
+		std::string settingsFilename = asset::user("GlueTheGiant.json");
+		FILE *file = fopen(settingsFilename.c_str(), "w");
+		if (file) {
+			json_dumpf(snapshotJ, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
+			fclose(file);
+		}
 	}
+};
 
-	json_t *default_valueJ = json_object_get(settingsJ, plugin_setting);
-	if (default_valueJ) default_value = json_integer_value(default_valueJ);
-	fclose(file);
+static GtgPluginDefaults gtg_plugin_defaults;
 
-	json_decref(settingsJ);
-	return default_value;
+// read the plugin defaults file, called once from init
+void loadGtgPluginDefaults() {
+	gtg_plugin_defaults.load();
+}
+
+// write pending plugin defaults and stop the writer thread, called from destroy before the plugin is unloaded
+void stopGtgPluginDefaults() {
+	gtg_plugin_defaults.stop();
+}
+
+// save a plugin default integer
+void saveGtgPluginDefault(const char* plugin_setting, int setting_value) {
+	gtg_plugin_defaults.set(plugin_setting, setting_value);
+}
+
+// load a plugin default integer
+int loadGtgPluginDefault(const char* plugin_setting, int default_value) {
+	return gtg_plugin_defaults.get(plugin_setting, default_value);
 }
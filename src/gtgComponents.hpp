@@ -8,47 +8,51 @@
 #pragma once
 
 #include <rack.hpp>
+#include "gtgDSP.hpp"
 
 using namespace rack;
 
 extern Plugin *pluginInstance;
 
 
+// themed widgets are told their theme by their module widget, only when the theme changes
+struct gtgThemedWidget {
+	virtual ~gtgThemedWidget() {}
+	virtual void setTheme(int theme) = 0;
+};
+
+// retheme the themed components of a module widget
+void applyGtgTheme(Widget *module_widget, int theme);
+
 // themed button and knob params
 template <class TThemedParam>
 TThemedParam* createThemedParamCentered(Vec pos, Module *module, int paramId, int* theme) {
 	TThemedParam *o = createParamCentered<TThemedParam>(pos, module, paramId);
-	o->theme = theme;
+	if (theme) o->setTheme(*theme);
 	return o;
 }
 
-struct gtgThemedSvgSwitch : SvgSwitch {
-	int* theme = NULL;
-	int old_theme = -1;
+struct gtgThemedSvgSwitch : SvgSwitch, gtgThemedWidget {
 	std::vector<std::shared_ptr<Svg>> framesAll;
 
 	void addFrameAll(std::shared_ptr<Svg> svg);
-	void step() override;
+	void setTheme(int theme) override;
 };
 
-struct gtgThemedSvgKnob : SvgKnob {
-	int* theme = NULL;
-	int old_theme = -1;
+struct gtgThemedSvgKnob : SvgKnob, gtgThemedWidget {
 	std::vector<std::shared_ptr<Svg>> framesAll;
 
 	void setOrientation(float angle);
 	void addFrameAll(std::shared_ptr<Svg> svg);
-	void step() override;
+	void setTheme(int theme) override;
 };
 
-struct gtgThemedRoundBlackSnapKnob : SvgKnob {
-	int* theme = NULL;
-	int old_theme = -1;
+struct gtgThemedRoundBlackSnapKnob : SvgKnob, gtgThemedWidget {
 	std::vector<std::shared_ptr<Svg>> framesAll;
 
 	void setOrientation(float angle);
 	void addFrameAll(std::shared_ptr<Svg> svg);
-	void step() override;
+	void setTheme(int theme) override;
 };
 
 // themed port widgets
@@ -57,34 +61,30 @@ TThemedPort* createThemedPortCentered(Vec pos, bool isInput, Module *module, int
 	TThemedPort *o = isInput ?
 		createInputCentered<TThemedPort>(pos, module, portId) :
 		createOutputCentered<TThemedPort>(pos, module, portId);
-	o->theme = theme;
+	if (theme) o->setTheme(*theme);
 	return o;
 }
 
-struct gtgThemedSvgPort : SvgPort {
-	int* theme = NULL;
-	int old_theme = -1;
+struct gtgThemedSvgPort : SvgPort, gtgThemedWidget {
 	std::vector<std::shared_ptr<Svg>> frames;
 
 	void addFrame(std::shared_ptr<Svg> svg);
-	void step() override;
+	void setTheme(int theme) override;
 };
 
 // themed widgets for screws
 template <class TWidget>
 TWidget *createThemedWidget(Vec pos, int* theme) {
 	TWidget *o = createWidget<TWidget>(pos);
-	o->theme = theme;
+	if (theme) o->setTheme(*theme);
 	return o;
 }
 
-struct gtgThemedSvgScrew : SvgScrew {
-	int* theme = NULL;
-	int old_theme = -1;
+struct gtgThemedSvgScrew : SvgScrew, gtgThemedWidget {
 	std::vector<std::shared_ptr<Svg>> frames;
 
 	void addFrame(std::shared_ptr<Svg> svg);
-	void step() override;
+	void setTheme(int theme) override;
 };
 
 // long press button, from Audible Instruments Segments (Stages)
@@ -96,14 +96,19 @@ struct LongPressButton {
 	};
 
 	float pressedTime = 0.f;
+	float sampleTime = 1.f / 44100.f;
 	dsp::BooleanTrigger trigger;
 
+	void setSampleRate(float sampleRate) {   // set from the module's onSampleRateChange()
+		sampleTime = 1.f / sampleRate;
+	}
+
 	Events step(Param &param) {
 		Events result = NO_PRESS;
 
 		bool pressed = param.value > 0.f;
 		if (pressed && pressedTime >= 0.f) {
-			pressedTime += APP->engine->getSampleTime();
+			pressedTime += sampleTime;
 			if (pressedTime >= 0.7f) {
 				pressedTime = -1.f;
 				result = LONG_PRESS;
@@ -122,7 +127,12 @@ struct LongPressButton {
 	}
 };
 
-// saving and loading default theme
+// saving and loading default theme, the file is read once and saves are written in the background
+
+void loadGtgPluginDefaults();
+
+// write pending plugin defaults and stop the writer thread
+void stopGtgPluginDefaults();
 
 void saveGtgPluginDefault(const char* setting, int value);
 
@@ -168,6 +178,62 @@ struct FadeSliderItem : ui::Slider {
 	}
 };
 
+// fade automation curve submenu, for any module with fade_curve and setFadeCurve()
+template <typename TModule>
+struct FadeCurveItem : MenuItem {
+	TModule *module;
+	int curve;
+	void onAction(const event::Action &e) override {
+		module->setFadeCurve(curve);
+	}
+};
+
+template <typename TModule>
+struct FadeCurvesItem : MenuItem {
+	TModule *module;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+		std::string curve_titles[NUM_FADE_CURVES] = {"Exponential (default)", "Logarithmic", "S-curve", "Equal power", "Linear"};
+		for (int i = 0; i < NUM_FADE_CURVES; i++) {
+			FadeCurveItem<TModule> *fade_curve_item = new FadeCurveItem<TModule>;
+			fade_curve_item->text = curve_titles[i];
+			fade_curve_item->rightText = CHECKMARK(module->fade_curve == i);
+			fade_curve_item->module = module;
+			fade_curve_item->curve = i;
+			menu->addChild(fade_curve_item);
+		}
+		return menu;
+	}
+};
+
+// pan law submenu, for any module with pan_law and setPanLaw()
+template <typename TModule>
+struct PanLawItem : MenuItem {
+	TModule *module;
+	int law;
+	void onAction(const event::Action &e) override {
+		module->setPanLaw(law);
+	}
+};
+
+template <typename TModule>
+struct PanLawsItem : MenuItem {
+	TModule *module;
+	Menu *createChildMenu() override {
+		Menu *menu = new Menu;
+		std::string law_titles[NUM_PAN_LAWS] = {"-3 dB constant power (default)", "-4.5 dB", "-6 dB linear", "Linear balance"};
+		for (int i = 0; i < NUM_PAN_LAWS; i++) {
+			PanLawItem<TModule> *pan_law_item = new PanLawItem<TModule>;
+			pan_law_item->text = law_titles[i];
+			pan_law_item->rightText = CHECKMARK(module->pan_law == i);
+			pan_law_item->module = module;
+			pan_law_item->law = i;
+			menu->addChild(pan_law_item);
+		}
+		return menu;
+	}
+};
+
 // custom components
 struct gtgBlackButton : gtgThemedSvgSwitch {
 	gtgBlackButton() {
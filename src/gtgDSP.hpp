@@ -1,5 +1,67 @@
 #pragma once
-#include "plugin.hpp"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// dsp only, no Rack SDK here so it builds and runs headless with make dsp
+// modules pass the engine sample rate in with setSampleRate() from onSampleRateChange()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#ifndef M_PI_2
+#define M_PI_2 1.57079632679489661923
+#endif
+#ifndef M_SQRT2
+#define M_SQRT2 1.41421356237309504880
+#endif
+
+
+// sample rate used until a module passes in the engine sample rate
+const float DSP_DEFAULT_SAMPLE_RATE = 44100.f;
+
+// number of samples in each block of fade, pan, and slew ramps
+const int DSP_BLOCK_SIZE = 16;
+
+
+// fade curves used by fade automation
+enum FadeCurves {
+	FADE_CURVE_EXP,   // x^2.5, the original curve
+	FADE_CURVE_LOG,
+	FADE_CURVE_S,
+	FADE_CURVE_EQUAL_POWER,
+	FADE_CURVE_LINEAR,
+	NUM_FADE_CURVES
+};
+
+const int FADE_TABLE_SIZE = 256;
+
+// precomputed fade curve tables shared by every fader
+// linear interpolation keeps every curve within 1e-5 of the exact curve
+struct FadeCurveTables {
+	float tables[NUM_FADE_CURVES][FADE_TABLE_SIZE + 2] = {};   // extra point so interpolation never reads past the end
+
+	FadeCurveTables() {
+		for (int i = 0; i < FADE_TABLE_SIZE + 2; i++) {
+			double x = std::fmin((double)i / FADE_TABLE_SIZE, 1.0);
+			tables[FADE_CURVE_EXP][i] = std::pow(x, 2.5);
+			tables[FADE_CURVE_LOG][i] = 1.0 - std::pow(1.0 - x, 2.5);
+			tables[FADE_CURVE_S][i] = 0.5 - (0.5 * std::cos(x * M_PI));
+			tables[FADE_CURVE_EQUAL_POWER][i] = std::sin(x * M_PI_2);
+			tables[FADE_CURVE_LINEAR][i] = x;
+		}
+	}
+
+	const float* getTable(int curve) const {
+		return tables[std::min(std::max(curve, 0), NUM_FADE_CURVES - 1)];
+	}
+};
+
+// tables are created once, the first time a fader needs them
+inline const FadeCurveTables &getFadeCurveTables() {
+	static const FadeCurveTables fade_curve_tables;
+	return fade_curve_tables;
+}
 
 
 // simple fader for smoothing on off states and setting a common gain
@@ -11,14 +73,39 @@ struct AutoFader {
 	float fade = 0.f;
 	int last_speed = 26;   // can be checked to see if a fade speed has changed
 
-	void setSpeed(int speed) {   // uses sampleRate and gain to keep time consistent
+	void setSampleRate(float rate) {
+		sample_rate = rate;
+		samples_per_ms = sample_rate * 0.001f;
+		setSpeed(last_speed);
+	}
+
+	void setSpeed(int speed) {   // uses sample_rate and gain to keep time consistent
 		last_speed = speed;
-		float sampleRate = APP->engine->getSampleRate();
-		delta = gain / (sampleRate * 0.001f * (float)speed);   // milliseconds from 0 to full gain
+		modulated_speed = -1.f;
+		inverse_samples = 1.f / (samples_per_ms * (float)speed);
+		delta = gain * inverse_samples;   // milliseconds from 0 to full gain
+	}
+
+	// speed from cv that can change every sample, in milliseconds
+	// small changes refine the last reciprocal with Newton steps, so only a jump in speed needs a divide
+	void modulateSpeed(float speed) {
+		if (speed == modulated_speed) return;
+		modulated_speed = speed;
+		float samples = samples_per_ms * speed;
+		float error = samples * inverse_samples;
+		if (error > 0.96875f && error < 1.03125f) {   // within 1/32, two steps leave an error under 1e-6
+			inverse_samples *= 2.f - error;
+			inverse_samples *= 2.f - (samples * inverse_samples);
+		} else {
+			inverse_samples = 1.f / samples;
+		}
+		delta = gain * inverse_samples;
+		last_speed = (int)(speed + 0.5f);
 	}
 
 	void setGain(float amount) {
 		gain = amount;
+		inverse_gain = 1.f / gain;
 		setSpeed(last_speed);   // initializes delta when necessary
 		if (fade > 0.f) fade = gain;   // keep from getting a fade stuck higher than gain
 	}
@@ -31,8 +118,20 @@ struct AutoFader {
 		return fade;
 	}
 
-	float getExpFade(double power) {   // exponential curve on fade
-		return std::pow(fade / gain, power) * gain;
+	void setCurve(int new_curve) {
+		curve = new_curve;
+		curve_table = getFadeCurveTables().getTable(curve);
+	}
+
+	int getCurve() {
+		return curve;
+	}
+
+	float getCurveFade() {   // fade curve from the table, interpolated
+		float table_pos = fade * inverse_gain * FADE_TABLE_SIZE;
+		int table_i = std::min(std::max((int)table_pos, 0), FADE_TABLE_SIZE);
+		float table_frac = table_pos - table_i;
+		return (curve_table[table_i] + ((curve_table[table_i + 1] - curve_table[table_i]) * table_frac)) * gain;
 	}
 
 	void process() {   // increments or decreases fade value
@@ -57,20 +156,100 @@ struct AutoFader {
 		}
 	}
 
+	// fills gains with n samples of the curved fade
+	// returns true when nothing is moving and only gains[0] is set
+	bool processBlock(float* gains, int n) {
+		if (fade == (on ? gain : 0.f)) {
+			fading = false;
+			gains[0] = fade;
+			return true;
+		}
+		for (int i = 0; i < n; i++) {
+			process();
+			gains[i] = fading ? getCurveFade() : fade;
+		}
+		return false;
+	}
+
 private:
 
 	float delta = 0.001f;
+	float sample_rate = DSP_DEFAULT_SAMPLE_RATE;
+	float samples_per_ms = DSP_DEFAULT_SAMPLE_RATE * 0.001f;
+	float inverse_samples = 1.f / (DSP_DEFAULT_SAMPLE_RATE * 0.026f);   // of the speed in samples
+	float modulated_speed = -1.f;   // last speed from modulateSpeed(), so a steady cv costs nothing
 	float gain = 1.f;
+	float inverse_gain = 1.f;
+	int curve = FADE_CURVE_EXP;
+	const float* curve_table = getFadeCurveTables().getTable(FADE_CURVE_EXP);
+};
+
+
+// pan laws, all adjusted so center is 1.f
+enum PanLaws {
+	PAN_LAW_3DB,   // constant power, the original law
+	PAN_LAW_4_5DB,   // halfway between constant power and linear
+	PAN_LAW_6DB,   // linear crossfade
+	PAN_LAW_LINEAR,   // balance, center is unity and the far side fades out
+	NUM_PAN_LAWS
 };
 
+// polynomial for sin(x * pi / 2) on 0 to 1, max error under 6e-7 (below -120 dB)
+// folds x from 1 to 2 back down to keep the roll back of pans beyond hard left or right
+// templated so the same pan law works on floats and SIMD vectors
+template <typename T>
+T panSin(T x) {
+	using std::fmin;
+	x = fmin(x, 2.f - x);
+	T x2 = x * x;
+	return x * (1.57079101f + x2 * (-0.64589288f + x2 * (0.07943442f + x2 * -0.00433314f)));
+}
 
-// constant power pan with optional smoothing
+// left and right levels for a pan position from -1.f to 1.f
+template <typename T>
+void panLevels(int law, T position, T &left, T &right) {
+	using std::fmin;
+	using std::fmax;
+	using std::sqrt;
+	T pan_angle = (position + 1.f) * 0.5f;
+	switch (law) {
+	default:
+	case PAN_LAW_3DB:
+		left = panSin(1.f - pan_angle) * (float)M_SQRT2;
+		right = panSin(pan_angle) * (float)M_SQRT2;
+		break;
+	case PAN_LAW_4_5DB:
+		pan_angle = fmin(fmax(pan_angle, 0.f), 1.f);
+		left = sqrt((1.f - pan_angle) * panSin(1.f - pan_angle)) * 1.68179283f;   // 2^0.75 sets center to 1.f
+		right = sqrt(pan_angle * panSin(pan_angle)) * 1.68179283f;
+		break;
+	case PAN_LAW_6DB:
+		pan_angle = fmin(fmax(pan_angle, 0.f), 1.f);
+		left = (1.f - pan_angle) * 2.f;
+		right = pan_angle * 2.f;
+		break;
+	case PAN_LAW_LINEAR:
+		pan_angle = fmin(fmax(pan_angle, 0.f), 1.f);
+		left = fmin((1.f - pan_angle) * 2.f, 1.f);
+		right = fmin(pan_angle * 2.f, 1.f);
+		break;
+	}
+}
+
+
+// pan with a selectable pan law and optional smoothing
 // set pan position with setPan() and then get levels for each channel with getLevel()
 
 struct ConstantPan {
 
 	float position = 0.f;   // pan position from -1.f to 1.f
 	float levels[2] = {1.f, 1.f};   // left and right levels
+	int law = PAN_LAW_3DB;
+
+	void setLaw(int new_law) {
+		law = new_law;
+		setLevels(position);
+	}
 
 	void setPan(float new_position) {
 		if (new_position != position) {   // recalculates pan only after a change
@@ -79,9 +258,14 @@ struct ConstantPan {
 		}
 	}
 
-	void setSmoothSpeed(int speed) {   // uses sampleRate to keep smoothing speed consistent
-		float sampleRate = APP->engine->getSampleRate();
-		delta = 2.0f/(sampleRate * 0.001f * (float)speed);   // milliseconds from pan left to pan right
+	void setSampleRate(float rate) {
+		sample_rate = rate;
+		setSmoothSpeed(last_speed);
+	}
+
+	void setSmoothSpeed(int speed) {   // uses sample_rate to keep smoothing speed consistent
+		last_speed = speed;
+		delta = 2.0f/(sample_rate * 0.001f * (float)speed);   // milliseconds from pan left to pan right
 	}
 
 	void setSmoothPan(float new_position) {
@@ -99,15 +283,45 @@ struct ConstantPan {
 		return levels[index];
 	}
 
+	// moves to a new position over n samples and fills left and right with ramped levels
+	// returns true when the position has not changed and only left[0] and right[0] are set
+	bool levelsBlock(float new_position, float* left, float* right, int n, bool smooth = false) {
+		if (new_position == position) {
+			left[0] = levels[0];
+			right[0] = levels[1];
+			return true;
+		}
+		float start_levels[2] = {levels[0], levels[1]};
+		if (smooth) {   // delta is per sample, so a block can move n deltas
+			if (new_position > position) {
+				position = std::fmin(position + (delta * n), new_position);
+			} else {
+				position = std::fmax(position - (delta * n), new_position);
+			}
+		} else {
+			position = new_position;
+		}
+		setLevels(position);
+
+		// linear ramp between the constant power levels at each end of the block
+		float step = 1.f / n;
+		for (int i = 0; i < n; i++) {
+			float ramp = (i + 1) * step;
+			left[i] = start_levels[0] + ((levels[0] - start_levels[0]) * ramp);
+			right[i] = start_levels[1] + ((levels[1] - start_levels[1]) * ramp);
+		}
+		return false;
+	}
+
 private:
 
 	float delta = 0.0005f;
+	float sample_rate = DSP_DEFAULT_SAMPLE_RATE;
+	int last_speed = 91;   // matches the default delta
 
-	// efficient constant power pan law that adjusts center to 1.f and sounds nice
+	// efficient pan law that adjusts center to 1.f and sounds nice
 	void setLevels(float final_position) {
-		float pan_angle = (final_position + 1.f) * 0.5f;
-		levels[0] = sin((1.f - pan_angle) * M_PI_2) * M_SQRT2;   // left level
-		levels[1] = sin(pan_angle * M_PI_2) * M_SQRT2;   // right level
+		panLevels(law, final_position, levels[0], levels[1]);
 	}
 };
 
@@ -129,12 +343,439 @@ struct SimpleSlewer {
 		return value;
 	}
 
+	// fills out with n slewed samples, returns true when the value has settled and only out[0] is set
+	bool slewBlock(float new_value, float* out, int n) {
+		if (new_value == value) {
+			out[0] = value;
+			return true;
+		}
+		for (int i = 0; i < n; i++) {
+			out[i] = slew(new_value);
+		}
+		return false;
+	}
+
+	void setSampleRate(float rate) {
+		sample_rate = rate;
+		setSlewSpeed(last_speed);
+	}
+
 	void setSlewSpeed(int speed) {
-		float sampleRate = APP->engine->getSampleRate();
-		delta = 1.f/(sampleRate * 0.001f * (float)speed);   // milliseconds from 0 to 1
+		last_speed = speed;
+		delta = 1.f/(sample_rate * 0.001f * (float)speed);   // milliseconds from 0 to 1
 	}
 
 private:
 
 	float delta = 0.0005f;
+	float sample_rate = DSP_DEFAULT_SAMPLE_RATE;
+	int last_speed = 45;   // matches the default delta
+};
+
+
+// history of a control signal stored at a low rate and read back with fractional delays
+// push() once per control tick, read() interpolates between stored values and the latest value
+// 2048 values at 100 per second hold about 20 seconds in 8 KB
+
+struct ControlHistory {
+
+	static const int HISTORY_SIZE = 2048;   // power of 2 for index wrapping
+
+	void setRate(float tick_rate, float history_rate) {   // ticks per second in, values per second stored
+		ticks_per_value = std::max((int)std::round(tick_rate / history_rate), 1);
+		values_per_second = tick_rate / ticks_per_value;
+	}
+
+	void reset() {
+		primed = false;
+	}
+
+	void push(float value) {
+		if (!primed) {   // starts full of the first value so reads never wait for history
+			std::fill(history, history + HISTORY_SIZE, value);
+			tick = 0;
+			tick_sum = 0.f;
+			primed = true;
+		}
+		latest = value;
+		tick_sum += value;
+		tick++;
+		if (tick >= ticks_per_value) {   // store the average of each period
+			write_i = (write_i + 1) & (HISTORY_SIZE - 1);
+			history[write_i] = tick_sum / tick;
+			tick = 0;
+			tick_sum = 0.f;
+		}
+	}
+
+	float read(float seconds_ago) {
+		float back = seconds_ago * values_per_second;
+		// age of the newest stored value, an average sits halfway through its period
+		float newest_age = (tick + ((ticks_per_value - 1) * 0.5f)) / ticks_per_value;
+		if (back <= newest_age) {
+			if (newest_age <= 0.f) return latest;
+			return latest + ((history[write_i] - latest) * (back / newest_age));
+		}
+		back = std::min(back - newest_age, (float)(HISTORY_SIZE - 2));
+		int back_i = (int)back;
+		float frac = back - back_i;
+		float newer = history[(write_i - back_i) & (HISTORY_SIZE - 1)];
+		float older = history[(write_i - back_i - 1) & (HISTORY_SIZE - 1)];
+		return newer + ((older - newer) * frac);
+	}
+
+private:
+
+	float history[HISTORY_SIZE] = {};
+	float latest = 0.f;
+	float tick_sum = 0.f;
+	float values_per_second = 100.f;
+	int ticks_per_value = 1;
+	int tick = 0;
+	int write_i = 0;
+	bool primed = false;
+};
+
+
+// delay line for the 6 channels of a bus chain, in whole samples
+// size it with setMaxDelay() outside of process(), longer delays are held at the longest
+
+struct BusDelayLine {
+
+	void setMaxDelay(int samples) {
+		size = 1;
+		while (size < samples + 1) size <<= 1;   // power of 2, longest delay is size - 1
+		buffer.assign(size * 6, 0.f);
+		write_i = 0;
+	}
+
+	int getMaxDelay() {
+		return size - 1;
+	}
+
+	// in and out can be the same array
+	void process(const float *in, float *out, int delay) {
+		for (int c = 0; c < 6; c++) {
+			buffer[(write_i * 6) + c] = in[c];
+		}
+		int read_i = (write_i - std::min(std::max(delay, 0), size - 1)) & (size - 1);
+		for (int c = 0; c < 6; c++) {
+			out[c] = buffer[(read_i * 6) + c];
+		}
+		write_i = (write_i + 1) & (size - 1);
+	}
+
+private:
+
+	std::vector<float> buffer = std::vector<float>(6, 0.f);
+	int size = 1;
+	int write_i = 0;
+};
+
+
+// stereo delay line with fractional delays, the left and right of each sample sit side by side
+// size it with setMaxDelay() outside of process(), the first 3 frames are copied past the end so reads never wrap
+// whole sample delays are read straight out, fractions use a 4 point Catmull-Rom spline
+
+struct StereoDelayLine {
+
+	void setMaxDelay(int samples) {
+		size = 4;
+		while (size < samples + 4) size <<= 1;   // power of 2 with room for the taps
+		buffer.assign((size + 3) * 2, 0.f);
+		write_i = 0;
+	}
+
+	int getMaxDelay() {
+		return size - 4;
+	}
+
+	// in and out are left and right, and can be the same array
+	void process(const float *in, float *out, float delay) {
+		buffer[write_i * 2] = in[0];
+		buffer[(write_i * 2) + 1] = in[1];
+		if (write_i < 3) {
+			buffer[(size + write_i) * 2] = in[0];
+			buffer[((size + write_i) * 2) + 1] = in[1];
+		}
+
+		delay = std::min(std::max(delay, 0.f), (float)(size - 4));
+		int delay_i = (int)delay;
+		float frac = delay - delay_i;
+		int mask = size - 1;
+		if (frac == 0.f) {
+			const float *frame = &buffer[((write_i - delay_i) & mask) * 2];
+			out[0] = frame[0];
+			out[1] = frame[1];
+		} else if (delay_i == 0) {   // under a sample there is no newer sample for the spline
+			const float *newer = &buffer[write_i * 2];
+			const float *older = &buffer[((write_i - 1) & mask) * 2];
+			out[0] = newer[0] + ((older[0] - newer[0]) * frac);
+			out[1] = newer[1] + ((older[1] - newer[1]) * frac);
+		} else {
+			const float *p = &buffer[((write_i - delay_i - 2) & mask) * 2];   // 4 frames, oldest first
+			float u = 1.f - frac;
+			for (int c = 0; c < 2; c++) {
+				float p0 = p[c], p1 = p[2 + c], p2 = p[4 + c], p3 = p[6 + c];
+				out[c] = p1 + (0.5f * u * ((p2 - p0) + (u * ((2.f * p0) - (5.f * p1) + (4.f * p2) - p3 + (u * ((3.f * (p1 - p2)) + p3 - p0))))));
+			}
+		}
+		write_i = (write_i + 1) & mask;
+	}
+
+private:
+
+	std::vector<float> buffer = std::vector<float>(14, 0.f);
+	int size = 4;
+	int write_i = 0;
+};
+
+
+// look-ahead brickwall limiter for up to 16 linked channels, constant work per sample at any sample rate
+// the channels are delayed by the look-ahead while a sliding window max of the level finds the gain each one needs
+// the held gain is averaged over the look-ahead, so the gain is already down when a peak leaves the delay
+// each average only takes gains held over the delayed sample, so the output never passes the ceiling
+// restart() forgets the sound before it without clearing the buffers, so it is cheap enough for process()
+
+struct LookAheadLimiter {
+
+	static const int LIMITER_CHANNELS = 16;
+	static const int LIMITER_SIZE = 1024;   // power of 2, longest look-ahead is LIMITER_SIZE / 2
+
+	void setSampleRate(float sample_rate) {
+		look_ahead = std::min(std::max((int)std::round(sample_rate * 0.0015f), 1), LIMITER_SIZE / 2);   // 1.5 ms, shorter past 341 kHz
+		release = 1.f - std::exp(-1.f / (sample_rate * 0.08f));   // 80 ms
+		reset();
+	}
+
+	void setCeiling(float level) {
+		ceiling = level;
+	}
+
+	// samples the channels are delayed by
+	int getLatency() {
+		return look_ahead;
+	}
+
+	// last gain applied, 1.f when not limiting
+	float getGain() {
+		return envelope;
+	}
+
+	void reset() {
+		for (int i = 0; i < LIMITER_SIZE; i++) {
+			for (int c = 0; c < LIMITER_CHANNELS; c++) {
+				buffer[i][c] = 0.f;
+			}
+			held_gains[i] = 1.f;
+		}
+		gain_sum = look_ahead;
+		envelope = 1.f;
+		window_front = 0;
+		window_back = 0;
+		write_i = 0;
+		fresh = look_ahead;
+	}
+
+	// the same sound as after reset(), slots not written since read as silence with a gain of 1
+	void restart() {
+		gain_sum = look_ahead;
+		envelope = 1.f;
+		window_front = window_back;
+		fresh = 0;
+	}
+
+	// delays and limits channels in place, level is the peak to keep under the ceiling, usually max(|left|, |right|) of the mix
+	void process(float *channels, int channel_count, float level) {
+
+		// sliding window max over the last look_ahead + 1 levels, a monotonic queue of falling levels
+		while (window_back != window_front && window_levels[(window_back - 1) & (LIMITER_SIZE - 1)] <= level) {
+			window_back = (window_back - 1) & (LIMITER_SIZE - 1);
+		}
+		window_levels[window_back] = level;
+		window_times[window_back] = write_i;
+		window_back = (window_back + 1) & (LIMITER_SIZE - 1);
+		if (((write_i - window_times[window_front]) & (LIMITER_SIZE - 1)) > look_ahead) {
+			window_front = (window_front + 1) & (LIMITER_SIZE - 1);
+		}
+		float window_max = window_levels[window_front];
+
+		// gain held for the window, averaged over the look-ahead
+		float held_gain = (window_max > ceiling) ? ceiling / window_max : 1.f;
+		bool primed = (fresh >= look_ahead);   // the slot look_ahead back was written since the restart
+		gain_sum += held_gain - (primed ? held_gains[(write_i - look_ahead) & (LIMITER_SIZE - 1)] : 1.f);
+		held_gains[write_i] = held_gain;
+		float gain = std::min((float)(gain_sum / look_ahead), 1.f);
+
+		// instant attack, the average has already ramped, and a slow release
+		if (gain < envelope) {
+			envelope = gain;
+		} else {
+			envelope += (gain - envelope) * release;
+		}
+
+		// delay the channels with the gain
+		int read_i = (write_i - look_ahead) & (LIMITER_SIZE - 1);
+		for (int c = 0; c < channel_count; c++) {
+			buffer[write_i][c] = channels[c];
+			channels[c] = primed ? buffer[read_i][c] * envelope : 0.f;
+		}
+		write_i = (write_i + 1) & (LIMITER_SIZE - 1);
+		if (!primed) fresh++;
+	}
+
+private:
+
+	float buffer[LIMITER_SIZE][LIMITER_CHANNELS] = {};
+	float held_gains[LIMITER_SIZE] = {};
+	float window_levels[LIMITER_SIZE] = {};
+	int window_times[LIMITER_SIZE] = {};
+	int window_front = 0;
+	int window_back = 0;
+	double gain_sum = 1.0;   // double so adding and taking away the same gains does not drift
+	float envelope = 1.f;
+	float ceiling = 10.f;
+	float release = 0.0003f;
+	int look_ahead = 66;
+	int write_i = 0;
+	int fresh = 66;   // samples written since a restart, up to the look-ahead
+};
+
+
+// measures the latency of a send and return with a burst of maximum length sequence noise
+// the burst plays for 2 periods and the second period of the return is recorded, so the path has settled
+// the recording is then circularly correlated with the sequence a few thousand products each sample, which keeps the engine smooth
+// the latency is the first lag that reaches half of the strongest, so a reverb reports its first arrival
+// size it with setMaxLatency() outside of process(), the sequence is the shortest that is longer than every lag
+
+struct LatencyProbe {
+
+	static const int PROBE_STEPS_PER_SAMPLE = 2048;   // sequence positions correlated each sample, on both channels
+
+	enum ProbeStates {
+		PROBE_IDLE,
+		PROBE_PLAYING,
+		PROBE_CORRELATING,
+		PROBE_FOUND,
+		PROBE_FAILED
+	};
+
+	LatencyProbe() {
+		setMaxLatency(999);
+	}
+
+	// measures 0 to samples, any state is dropped
+	void setMaxLatency(int samples) {
+		static const int masks[9] = {0x240, 0x500, 0xe08, 0x1c80, 0x3802, 0x6000, 0xd008, 0x12000, 0x20400};   // galois taps of 10 to 18 bits
+		int bits = 10;
+		while (bits < 18 && (1 << bits) - 1 <= samples) bits++;
+		period = (1 << bits) - 1;
+		lags = std::min(samples + 1, period);
+		sequence.assign(period * 2, 0.f);
+		int lfsr = 1;
+		for (int i = 0; i < period; i++) {
+			sequence[i] = sequence[i + period] = (lfsr & 1) ? 1.f : -1.f;
+			lfsr = (lfsr >> 1) ^ ((lfsr & 1) ? masks[bits - 10] : 0);
+		}
+		recorded[0].assign(period, 0.f);
+		recorded[1].assign(period, 0.f);
+		scores.assign(lags, 0.f);
+		state = PROBE_IDLE;
+		latency = -1;
+	}
+
+	// longest latency that can be measured
+	int getMaxLatency() {
+		return lags - 1;
+	}
+
+	void start() {
+		state = PROBE_PLAYING;
+		t = 0;
+		n = 0;
+		sums[0] = sums[1] = 0.f;
+		latency = -1;
+	}
+
+	bool isRunning() {
+		return state == PROBE_PLAYING || state == PROBE_CORRELATING;
+	}
+
+	int getState() {
+		return state;
+	}
+
+	// PROBE_FOUND or PROBE_FAILED once, then back to idle
+	int takeResult() {
+		int result = state;
+		if (!isRunning()) state = PROBE_IDLE;
+		return result;
+	}
+
+	int getLatency() {
+		return latency;
+	}
+
+	// once per sample with this sample's returns, gives the voltage to send
+	float process(float return_left, float return_right) {
+		if (state == PROBE_PLAYING) {
+			if (t >= period) {
+				recorded[0][t - period] = return_left;
+				recorded[1][t - period] = return_right;
+			}
+			if (t < period * 2) return sequence[t++ % period] * amplitude;
+			state = PROBE_CORRELATING;
+			t = 0;
+		}
+		if (state == PROBE_CORRELATING) {
+			int steps = PROBE_STEPS_PER_SAMPLE;   // a lag can take several samples once the sequence is long
+			while (steps > 0 && t < lags) {
+				const float *shifted = sequence.data() + period - t;   // sequence[(n - t) mod period]
+				int end = std::min(n + steps, period);
+				steps -= end - n;
+				for (; n < end; n++) {
+					sums[0] += recorded[0][n] * shifted[n];
+					sums[1] += recorded[1][n] * shifted[n];
+				}
+				if (n == period) {
+					scores[t++] = std::fabs(sums[0]) + std::fabs(sums[1]);
+					sums[0] = sums[1] = 0.f;
+					n = 0;
+				}
+			}
+			if (t >= lags) findLatency();
+		}
+		return 0.f;
+	}
+
+private:
+
+	std::vector<float> sequence;   // twice over so every lag reads straight through
+	std::vector<float> recorded[2];
+	std::vector<float> scores;
+	float amplitude = 2.f;
+	int period = 1023;
+	int lags = 1000;
+	int state = PROBE_IDLE;
+	int t = 0;
+	int n = 0;
+	float sums[2] = {0.f, 0.f};
+	int latency = -1;
+
+	// a clear peak stands well above the average lag, otherwise nothing came back within range
+	void findLatency() {
+		float peak = 0.f;
+		float mean = 0.f;
+		for (int i = 0; i < lags; i++) {
+			peak = std::max(peak, scores[i]);
+			mean += scores[i];
+		}
+		mean /= lags;
+		if (peak < 0.01f * amplitude * period || peak < 8.f * mean) {
+			state = PROBE_FAILED;
+			return;
+		}
+		for (latency = 0; scores[latency] < peak * 0.5f; latency++) {}
+		state = PROBE_FOUND;
+	}
 };
@@ -0,0 +1,236 @@
+#pragma once
+#include "plugin.hpp"
+#include "gtgDSP.hpp"
+#include <atomic>
+#include <cstdint>
+
+using simd::float_4;
+
+
+// EBU R128 loudness and true peak of a stereo pair, left and right in float_4 lanes 0 and 1
+// every sample pays for the K-weighting biquads, a sum of squares, and a 4x polyphase true peak
+// every 100 ms block updates momentary (400 ms), short term (3 s) and the gated integrated histogram
+// results are handed to the ui thread through atomics, in LUFS and dBTP with 10 V as full scale
+
+const int LOUDNESS_SHORT_BLOCKS = 30;   // 3 s of 100 ms blocks
+const int LOUDNESS_MOMENTARY_BLOCKS = 4;   // 400 ms
+const int LOUDNESS_BINS = 1000;   // integrated histogram, 0.1 LU bins from -70 to +30 LUFS
+const float LOUDNESS_BIN_MIN = -70.f;
+const float LOUDNESS_BIN_SIZE = 0.1f;
+const int TRUE_PEAK_TAPS = 12;   // per phase, 48 taps at 4x
+
+inline float energyToLufs(double energy) {
+	return (energy > 0.0) ? (float)(-0.691 + 10.0 * std::log10(energy)) : -INFINITY;
+}
+
+// energy at the middle of each histogram bin, made once and shared by every meter
+struct LoudnessBinEnergies {
+	double energies[LOUDNESS_BINS];
+
+	LoudnessBinEnergies() {
+		for (int i = 0; i < LOUDNESS_BINS; i++) {
+			double lufs = LOUDNESS_BIN_MIN + ((i + 0.5) * LOUDNESS_BIN_SIZE);
+			energies[i] = std::pow(10.0, (lufs + 0.691) / 10.0);
+		}
+	}
+};
+
+inline const LoudnessBinEnergies &getLoudnessBinEnergies() {
+	static const LoudnessBinEnergies bin_energies;
+	return bin_energies;
+}
+
+// biquad on float_4 lanes, direct form 2 transposed
+struct Float4Biquad {
+	float b[3] = {1.f, 0.f, 0.f};
+	float a[2] = {0.f, 0.f};
+	float_4 z[2] = {};
+
+	void setCoefficients(double b0, double b1, double b2, double a1, double a2) {
+		b[0] = b0; b[1] = b1; b[2] = b2;
+		a[0] = a1; a[1] = a2;
+	}
+
+	void reset() {
+		z[0] = 0.f;
+		z[1] = 0.f;
+	}
+
+	float_4 process(float_4 in) {
+		float_4 out = (in * b[0]) + z[0];
+		z[0] = (in * b[1]) - (out * a[0]) + z[1];
+		z[1] = (in * b[2]) - (out * a[1]);
+		return out;
+	}
+};
+
+struct LoudnessMeter {
+
+	// read from the ui thread
+	std::atomic<float> momentary {-INFINITY};
+	std::atomic<float> short_term {-INFINITY};
+	std::atomic<float> integrated {-INFINITY};
+	std::atomic<float> true_peak {-INFINITY};
+
+	LoudnessMeter() {
+		getLoudnessBinEnergies();   // make the shared table here, not on the audio thread
+		setTruePeakFilter();
+		setSampleRate(DSP_DEFAULT_SAMPLE_RATE);
+	}
+
+	// K-weighting from ITU-R BS.1770, worked out again for each sample rate
+	void setSampleRate(float sample_rate) {
+		double k = std::tan(M_PI * 1681.974450955533 / sample_rate);
+		double q = 0.7071752369554196;
+		double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+		double vb = std::pow(vh, 0.4996667741545416);
+		double a0 = 1.0 + (k / q) + (k * k);
+		shelf.setCoefficients((vh + (vb * k / q) + (k * k)) / a0, 2.0 * ((k * k) - vh) / a0, (vh - (vb * k / q) + (k * k)) / a0,
+			2.0 * ((k * k) - 1.0) / a0, (1.0 - (k / q) + (k * k)) / a0);
+
+		k = std::tan(M_PI * 38.13547087602444 / sample_rate);
+		q = 0.5003270373238773;
+		a0 = 1.0 + (k / q) + (k * k);
+		highpass.setCoefficients(1.0, -2.0, 1.0, 2.0 * ((k * k) - 1.0) / a0, (1.0 - (k / q) + (k * k)) / a0);
+
+		block_length = std::max((int)std::round(sample_rate * 0.1f), 1);
+		reset();
+	}
+
+	// start a new measurement, call from the audio thread or ask with requestReset()
+	void reset() {
+		shelf.reset();
+		highpass.reset();
+		block_squares = 0.f;
+		block_samples = 0;
+		blocks_seen = 0;
+		block_i = 0;
+		for (int i = 0; i < LOUDNESS_SHORT_BLOCKS; i++) block_energies[i] = 0.0;
+		for (int i = 0; i < LOUDNESS_BINS; i++) histogram[i] = 0;
+		for (int i = 0; i < TRUE_PEAK_TAPS * 2; i++) history[0][i] = history[1][i] = 0.f;
+		peaks = 0.f;
+		momentary.store(-INFINITY);
+		short_term.store(-INFINITY);
+		integrated.store(-INFINITY);
+		true_peak.store(-INFINITY);
+	}
+
+	void requestReset() {
+		reset_requested.store(true);
+	}
+
+	void process(float left, float right) {
+		float_4 in = float_4(left, right, 0.f, 0.f) * 0.1f;   // 10 V is full scale
+
+		// K-weighted energy
+		float_4 weighted = highpass.process(shelf.process(in));
+		block_squares += weighted * weighted;
+
+		// true peak, each lane of the sum is one of the 4 phases between this sample and the last
+		history_i = (history_i == 0) ? TRUE_PEAK_TAPS - 1 : history_i - 1;
+		for (int c = 0; c < 2; c++) {
+			history[c][history_i] = history[c][history_i + TRUE_PEAK_TAPS] = in.s[c];
+			float_4 phases = 0.f;
+			for (int t = 0; t < TRUE_PEAK_TAPS; t++) {
+				phases += phase_taps[t] * history[c][history_i + t];
+			}
+			peaks = simd::fmax(peaks, simd::fabs(phases));
+		}
+
+		if (++block_samples >= block_length) processBlock();
+	}
+
+private:
+
+	Float4Biquad shelf;
+	Float4Biquad highpass;
+	int block_length = 4410;
+	float_4 block_squares = 0.f;
+	int block_samples = 0;
+
+	double block_energies[LOUDNESS_SHORT_BLOCKS] = {};   // ring of 100 ms block energies
+	int block_i = 0;
+	int blocks_seen = 0;
+	uint32_t histogram[LOUDNESS_BINS] = {};   // gated 400 ms windows by loudness
+
+	float_4 phase_taps[TRUE_PEAK_TAPS];
+	float history[2][TRUE_PEAK_TAPS * 2] = {};   // doubled so every read is contiguous
+	int history_i = 0;
+	float_4 peaks = 0.f;
+
+	std::atomic<bool> reset_requested {false};
+
+	// 4x interpolator, windowed sinc split into 4 phases with unity gain each
+	void setTruePeakFilter() {
+		const int taps = TRUE_PEAK_TAPS * 4;
+		float h[taps];
+		for (int n = 0; n < taps; n++) {
+			double x = (n - ((taps - 1) / 2.0)) / 4.0;
+			double sinc = (x == 0.0) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+			double window = 0.5 - (0.5 * std::cos(2.0 * M_PI * (n + 0.5) / taps));
+			h[n] = sinc * window;
+		}
+		for (int p = 0; p < 4; p++) {
+			float sum = 0.f;
+			for (int t = 0; t < TRUE_PEAK_TAPS; t++) sum += h[(t * 4) + p];
+			for (int t = 0; t < TRUE_PEAK_TAPS; t++) phase_taps[t].s[p] = h[(t * 4) + p] / sum;
+		}
+	}
+
+	void processBlock() {
+		if (reset_requested.exchange(false)) {
+			reset();
+			return;
+		}
+
+		// add the block to the ring, channel weights are 1 for left and right
+		block_energies[block_i] = (double)(block_squares.s[0] + block_squares.s[1]) / block_samples;
+		block_i = (block_i + 1) % LOUDNESS_SHORT_BLOCKS;
+		blocks_seen++;
+		block_squares = 0.f;
+		block_samples = 0;
+
+		// momentary and short term are the means of the last 4 and 30 blocks
+		double sum = 0.0;
+		double momentary_energy = 0.0;
+		for (int i = 1; i <= LOUDNESS_SHORT_BLOCKS; i++) {
+			sum += block_energies[(block_i + LOUDNESS_SHORT_BLOCKS - i) % LOUDNESS_SHORT_BLOCKS];
+			if (i == LOUDNESS_MOMENTARY_BLOCKS) momentary_energy = sum / LOUDNESS_MOMENTARY_BLOCKS;
+		}
+		float momentary_lufs = (blocks_seen >= LOUDNESS_MOMENTARY_BLOCKS) ? energyToLufs(momentary_energy) : -INFINITY;
+		momentary.store(momentary_lufs);
+		short_term.store((blocks_seen >= LOUDNESS_SHORT_BLOCKS) ? energyToLufs(sum / LOUDNESS_SHORT_BLOCKS) : -INFINITY);
+
+		// every block completes a 400 ms window overlapping the last by 75%, windows under -70 LUFS are gated out
+		if (momentary_lufs >= LOUDNESS_BIN_MIN) {
+			int bin = std::min((int)((momentary_lufs - LOUDNESS_BIN_MIN) / LOUDNESS_BIN_SIZE), LOUDNESS_BINS - 1);
+			histogram[bin]++;
+			integrated.store(getIntegrated());
+		}
+
+		float peak = std::max(peaks.s[0], peaks.s[1]);
+		true_peak.store((peak > 0.f) ? 20.f * std::log10(peak) : -INFINITY);
+	}
+
+	// relative gate 10 LU under the absolute gated mean, then the mean of what is left
+	float getIntegrated() {
+		const double *bin_energies = getLoudnessBinEnergies().energies;
+		double energy = 0.0;
+		uint32_t windows = 0;
+		for (int i = 0; i < LOUDNESS_BINS; i++) {
+			if (histogram[i] == 0) continue;
+			energy += histogram[i] * bin_energies[i];
+			windows += histogram[i];
+		}
+		if (windows == 0) return -INFINITY;
+		float relative_gate = energyToLufs(energy / windows) - 10.f;
+		int first_bin = std::max((int)std::ceil((relative_gate - LOUDNESS_BIN_MIN) / LOUDNESS_BIN_SIZE), 0);
+		energy = 0.0;
+		windows = 0;
+		for (int i = first_bin; i < LOUDNESS_BINS; i++) {
+			energy += histogram[i] * bin_energies[i];
+			windows += histogram[i];
+		}
+		return (windows > 0) ? energyToLufs(energy / windows) : -INFINITY;
+	}
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+
+using simd::float_4;
+
+
+// level meter for up to 4 channels, one per float_4 lane
+// the audio thread only keeps a block peak and sum of squares, and hands them over every METER_BLOCK samples
+// the ui thread takes what was handed over and does the ballistics, dB mapping and light brightness
+
+const int METER_BLOCK = 256;
+const int METER_LIGHTS = 11;
+
+struct gtgMeter {
+
+	// audio thread
+
+	void process(float_4 levels) {
+		block_peaks = simd::fmax(block_peaks, simd::fabs(levels));
+		block_squares += levels * levels;
+		if (++block_samples >= METER_BLOCK) publish();
+	}
+
+	void processStereo(float left, float right) {
+		process(float_4(left, right, 0.f, 0.f));
+	}
+
+	void setSampleRate(float sample_rate) {   // set from the module's onSampleRateChange()
+		sample_time.store(1.f / sample_rate);
+		max_shared_samples = std::max((int)sample_rate, METER_BLOCK);
+	}
+
+	// ui thread
+
+	// take the levels handed over since the last update
+	void update() {
+		int samples = shared_samples.exchange(0);
+		if (samples == 0) return;
+		float delta_time = samples * sample_time.load();
+		float vu_step = 1.f - std::exp(-lambda * delta_time);
+		for (int c = 0; c < 4; c++) {
+			float peak = shared_peaks[c].exchange(0.f) / 10.f;   // 10 V is 0 dB
+			float squares = shared_squares[c].exchange(0.f) / 100.f;
+
+			// peak vu like dsp::VuMeter2, peak light is held when over 0 dB and falls in 2 seconds
+			if (peak >= vu[c]) vu[c] = peak; else vu[c] += (peak - vu[c]) * vu_step;
+			if (peak > 1.f) peak_hold[c] = 1.f; else peak_hold[c] = std::max(peak_hold[c] - (0.5f * delta_time), 0.f);
+			rms[c] = std::sqrt(squares / samples);
+		}
+	}
+
+	float getBrightness(int c, float db_min, float db_max) {
+		float db = dsp::amplitudeToDb(vu[c]);
+		return clamp(rescale(db, db_min, db_max, 0.f, 1.f), 0.f, 1.f);
+	}
+
+	float getPeakHold(int c) {
+		return peak_hold[c];
+	}
+
+	// rms of the last update, 1.f is 10 V
+	float getRms(int c) {
+		return rms[c];
+	}
+
+	// the 11 light ladder of the Gig Bus and Bus Depot, red peak light on top and -48 dB at the bottom
+	float getLadderBrightness(int c, int light) {
+		static const float ladder_db[METER_LIGHTS][2] = {
+			{0.f, 0.f}, {-3.f, 0.f}, {-6.f, -3.f}, {-9.f, -6.f}, {-12.f, -9.f}, {-15.f, -12.f},
+			{-19.f, -15.f}, {-24.f, -19.f}, {-30.f, -24.f}, {-36.f, -28.f}, {-48.f, -36.f}
+		};
+		if (light == 0) return getPeakHold(c);
+		return getBrightness(c, ladder_db[light][0], ladder_db[light][1]);
+	}
+
+	void setLadderLights(int c, Light *ladder) {
+		for (int i = 0; i < METER_LIGHTS; i++) {
+			ladder[i].setBrightness(getLadderBrightness(c, i));
+		}
+	}
+
+private:
+
+	// audio thread block
+	float_4 block_peaks = 0.f;
+	float_4 block_squares = 0.f;
+	int block_samples = 0;
+
+	// handed to the ui thread, added to until it takes them
+	std::atomic<float> shared_peaks[4] = {};
+	std::atomic<float> shared_squares[4] = {};
+	std::atomic<int> shared_samples {0};
+	std::atomic<float> sample_time {1.f / 44100.f};
+	int max_shared_samples = 44100;   // about 1 second, past that the handed over levels are halved
+
+	// ui thread ballistics
+	const float lambda = 25.f;
+	float vu[4] = {};
+	float peak_hold[4] = {};
+	float rms[4] = {};
+
+	// with no meter widget taking the levels (no ui or the module is off screen), samples and squares are halved together past a second
+	// that keeps the rms while the count never overflows and the squares stay bounded
+	void publish() {
+		int samples = shared_samples.load(std::memory_order_relaxed);
+		bool halve = false;
+		do {
+			halve = samples > max_shared_samples;
+		} while (!shared_samples.compare_exchange_weak(samples, (halve ? samples / 2 : samples) + block_samples));
+		for (int c = 0; c < 4; c++) {
+			float peak = shared_peaks[c].load(std::memory_order_relaxed);
+			while (block_peaks.s[c] > peak && !shared_peaks[c].compare_exchange_weak(peak, block_peaks.s[c])) {}
+			float squares = shared_squares[c].load(std::memory_order_relaxed);
+			while (!shared_squares[c].compare_exchange_weak(squares, (halve ? squares * 0.5f : squares) + block_squares.s[c])) {}
+		}
+		block_peaks = 0.f;
+		block_squares = 0.f;
+		block_samples = 0;
+	}
+};
+
+
+// slim stereo meter drawn on the light layer, for strips without room for a ladder of lights
+struct gtgMeterDisplay : TransparentWidget {
+	gtgMeter *meter = NULL;
+
+	gtgMeterDisplay() {
+		box.size = mm2px(Vec(1.8f, 9.f));
+	}
+
+	void step() override {
+		if (meter) meter->update();
+		TransparentWidget::step();
+	}
+
+	void draw(const DrawArgs &args) override {
+		nvgBeginPath(args.vg);
+		nvgRoundedRect(args.vg, 0.f, 0.f, box.size.x, box.size.y, 0.5f);
+		nvgFillColor(args.vg, nvgRGB(26, 26, 26));
+		nvgFill(args.vg);
+	}
+
+	void drawLayer(const DrawArgs &args, int layer) override {
+		if (layer == 1 && meter) {
+			float pad = box.size.x * 0.1f;
+			float column = (box.size.x - (pad * 3.f)) / 2.f;
+			float pitch = (box.size.y - pad) / METER_LIGHTS;
+			for (int c = 0; c < 2; c++) {
+				for (int i = 0; i < METER_LIGHTS; i++) {
+					float brightness = meter->getLadderBrightness(c, i);
+					if (brightness <= 0.f) continue;
+					NVGcolor color = (i == 0) ? SCHEME_RED : ((i == 1) ? SCHEME_YELLOW : SCHEME_GREEN);
+					nvgBeginPath(args.vg);
+					nvgRect(args.vg, pad + (c * (column + pad)), pad + (i * pitch), column, pitch - pad);
+					nvgFillColor(args.vg, nvgTransRGBAf(color, brightness));
+					nvgFill(args.vg);
+				}
+			}
+		}
+		TransparentWidget::drawLayer(args, layer);
+	}
+};
@@ -0,0 +1,168 @@
+#include "gtgRecorder.hpp"
+#include <chrono>
+#include <cstring>
+
+// little endian fields for the file headers
+static void putBytes(uint8_t *&p, uint64_t value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		*p++ = (value >> (i * 8)) & 0xff;
+	}
+}
+
+static void putGuid(uint8_t *&p, const uint8_t *guid) {
+	std::memcpy(p, guid, 16);
+	p += 16;
+}
+
+static const uint8_t W64_RIFF[16] = {0x72, 0x69, 0x66, 0x66, 0x2e, 0x91, 0xcf, 0x11, 0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00};
+static const uint8_t W64_WAVE[16] = {0x77, 0x61, 0x76, 0x65, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a};
+static const uint8_t W64_FMT[16] = {0x66, 0x6d, 0x74, 0x20, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a};
+static const uint8_t W64_DATA[16] = {0x64, 0x61, 0x74, 0x61, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a};
+static const uint8_t IEEE_FLOAT_SUBTYPE[16] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+
+static const uint64_t WAV_HEADER_BYTES = 68;
+static const uint64_t WAV_MAX_DATA_BYTES = 0xffffffffull - WAV_HEADER_BYTES;
+
+// start recording to path, the 3 stereo file names get _blue, _orange and _red before the extension
+bool StemRecorder::start(const std::string &path, int format, int layout, float sample_rate) {
+	stop();
+	if (ring.empty()) ring.assign(RECORDER_RING_FRAMES * RECORDER_CHANNELS, 0.f);
+
+	std::vector<std::string> paths;
+	if (layout == RECORDER_STEREO_FILES) {
+		std::string extension = system::getExtension(path);
+		std::string base = path.substr(0, path.size() - extension.size());
+		std::string bus_names[3] = {"_blue", "_orange", "_red"};
+		for (int i = 0; i < 3; i++) {
+			paths.push_back(base + bus_names[i] + extension);
+		}
+	} else {
+		paths.push_back(path);
+	}
+
+	file_format = format;
+	file_sample_rate = sample_rate;
+	data_bytes = 0;
+	for (const std::string &file_path : paths) {
+		FILE *file = fopen(file_path.c_str(), "wb");
+		if (!file) {
+			for (FILE *opened : files) fclose(opened);
+			files.clear();
+			write_failed.store(true);
+			return false;
+		}
+		setvbuf(file, NULL, _IOFBF, 1 << 20);
+		writeHeader(file, RECORDER_CHANNELS / paths.size(), 0);
+		files.push_back(file);
+	}
+
+	recorded_frames.store(0);
+	dropped_frames.store(0);
+	overruns.store(0);
+	write_failed.store(false);
+	read_pos.store(write_pos.load());
+	stopping.store(false);
+	writer = std::thread(&StemRecorder::writeLoop, this);
+	recording.store(true, std::memory_order_release);
+	return true;
+}
+
+// stop taking frames, let the writer drain the ring and finish the files, and wait for it
+void StemRecorder::stop() {
+	requestStop();
+	if (writer.joinable()) writer.join();
+}
+
+void StemRecorder::writeLoop() {
+	while (true) {
+		bool last_pass = stopping.load();
+		uint64_t read = read_pos.load(std::memory_order_relaxed);
+		uint64_t available = write_pos.load(std::memory_order_acquire) - read;
+		if (available == 0) {
+			if (last_pass) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			continue;
+		}
+
+		// up to the end of the ring, the rest comes on the next pass
+		int ring_i = read & (RECORDER_RING_FRAMES - 1);
+		int frame_count = std::min((uint64_t)std::min(RECORDER_WRITE_FRAMES, RECORDER_RING_FRAMES - ring_i), available);
+		if (!writeFrames(&ring[ring_i * RECORDER_CHANNELS], frame_count)) {
+			dropped_frames.fetch_add(frame_count);
+		}
+		read_pos.store(read + frame_count, std::memory_order_release);
+	}
+
+	for (FILE *file : files) {
+		writeHeader(file, RECORDER_CHANNELS / files.size(), data_bytes);
+		fclose(file);
+	}
+	files.clear();
+}
+
+// one interleaved write per file, split into stereo pairs for stereo files
+bool StemRecorder::writeFrames(const float *frames, int frame_count) {
+	int file_channels = RECORDER_CHANNELS / files.size();
+	uint64_t bytes = (uint64_t)frame_count * file_channels * sizeof(float);
+	if (write_failed.load() || (file_format == RECORDER_WAV && data_bytes + bytes > WAV_MAX_DATA_BYTES)) return false;
+
+	static thread_local float pairs[RECORDER_WRITE_FRAMES * 2];
+	for (size_t f = 0; f < files.size(); f++) {
+		const float *out = frames;
+		if (files.size() > 1) {
+			for (int i = 0; i < frame_count; i++) {
+				pairs[i * 2] = frames[(i * RECORDER_CHANNELS) + (f * 2)];
+				pairs[(i * 2) + 1] = frames[(i * RECORDER_CHANNELS) + (f * 2) + 1];
+			}
+			out = pairs;
+		}
+		if (fwrite(out, sizeof(float), frame_count * file_channels, files[f]) != (size_t)(frame_count * file_channels)) {
+			write_failed.store(true);
+			return false;
+		}
+	}
+	data_bytes += bytes;
+	recorded_frames.fetch_add(frame_count);
+	return true;
+}
+
+// WAVE_FORMAT_EXTENSIBLE with 32 bit float, in a RIFF or a Sony Wave64 container
+void StemRecorder::writeHeader(FILE *file, int channels, uint64_t bytes) {
+	uint8_t header[128];
+	uint8_t *p = header;
+	if (file_format == RECORDER_W64) {
+		putGuid(p, W64_RIFF);
+		putBytes(p, 40 + 64 + 24 + bytes, 8);
+		putGuid(p, W64_WAVE);
+		putGuid(p, W64_FMT);
+		putBytes(p, 64, 8);
+	} else {
+		std::memcpy(p, "RIFF", 4);
+		p += 4;
+		putBytes(p, WAV_HEADER_BYTES - 8 + bytes, 4);
+		std::memcpy(p, "WAVEfmt ", 8);
+		p += 8;
+		putBytes(p, 40, 4);
+	}
+	putBytes(p, 0xfffe, 2);
+	putBytes(p, channels, 2);
+	putBytes(p, (uint32_t)file_sample_rate, 4);
+	putBytes(p, (uint32_t)file_sample_rate * channels * 4, 4);
+	putBytes(p, channels * 4, 2);
+	putBytes(p, 32, 2);
+	putBytes(p, 22, 2);
+	putBytes(p, 32, 2);
+	putBytes(p, 0, 4);   // no speaker positions, these are stems
+	putGuid(p, IEEE_FLOAT_SUBTYPE);
+	if (file_format == RECORDER_W64) {
+		putGuid(p, W64_DATA);
+		putBytes(p, 24 + bytes, 8);
+	} else {
+		std::memcpy(p, "data", 4);
+		p += 4;
+		putBytes(p, bytes, 4);
+	}
+	fseek(file, 0, SEEK_SET);
+	fwrite(header, 1, p - header, file);
+	fseek(file, 0, SEEK_END);
+}
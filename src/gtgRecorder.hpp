@@ -0,0 +1,96 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+// records the 3 stereo buses to disk as 32 bit float WAV or W64
+// the audio thread copies each frame into a single producer single consumer ring and never blocks or allocates
+// a writer thread drains the ring in large blocks through a buffered file, and writes the final sizes when stopped
+// the engine only asks the writer to stop, the writer is joined from the ui thread by stop(), start() or the destructor
+// a frame that finds the ring full is dropped and counted, so a slow disk never holds up the engine
+
+const int RECORDER_CHANNELS = 6;
+const int RECORDER_RING_FRAMES = 1 << 17;   // power of 2, about 2.7 seconds at 48 kHz
+const int RECORDER_WRITE_FRAMES = 8192;   // most frames the writer takes in one go
+
+enum RecorderFormats {
+	RECORDER_WAV,
+	RECORDER_W64,
+	NUM_RECORDER_FORMATS
+};
+
+enum RecorderLayouts {
+	RECORDER_ONE_FILE,   // one 6 channel file
+	RECORDER_STEREO_FILES,   // a stereo file for each bus
+	NUM_RECORDER_LAYOUTS
+};
+
+struct StemRecorder {
+
+	// read from the ui thread
+	std::atomic<uint64_t> recorded_frames {0};
+	std::atomic<uint64_t> dropped_frames {0};
+	std::atomic<uint32_t> overruns {0};   // times the ring filled up, each can drop many frames
+	std::atomic<bool> write_failed {false};
+
+	~StemRecorder() {
+		stop();
+	}
+
+	// audio thread, frame is RECORDER_CHANNELS voltages
+	void push(const float *frame) {
+		if (!recording.load(std::memory_order_acquire)) return;
+		uint64_t write = write_pos.load(std::memory_order_relaxed);
+		if (write - read_pos.load(std::memory_order_acquire) >= (uint64_t)RECORDER_RING_FRAMES) {
+			if (!dropping) overruns.fetch_add(1, std::memory_order_relaxed);
+			dropping = true;
+			dropped_frames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		dropping = false;
+		float *slot = &ring[(write & (RECORDER_RING_FRAMES - 1)) * RECORDER_CHANNELS];
+		for (int c = 0; c < RECORDER_CHANNELS; c++) {
+			slot[c] = frame[c] * 0.1f;   // 10 V is full scale
+		}
+		write_pos.store(write + 1, std::memory_order_release);
+	}
+
+	// any thread, the engine included, the writer drains the ring and finishes the files on its own
+	void requestStop() {
+		recording.store(false, std::memory_order_release);
+		stopping.store(true);
+	}
+
+	// ui thread, these join the writer
+	bool start(const std::string &path, int format, int layout, float sample_rate);
+	void stop();
+
+	bool isRecording() {
+		return recording.load();
+	}
+
+	float getSeconds() {
+		return recorded_frames.load() / file_sample_rate;
+	}
+
+private:
+
+	std::vector<float> ring;   // made by the first start(), never freed while the audio thread can see it
+	std::atomic<uint64_t> write_pos {0};
+	std::atomic<uint64_t> read_pos {0};
+	std::atomic<bool> recording {false};
+	std::atomic<bool> stopping {false};
+	bool dropping = false;
+
+	std::thread writer;
+	std::vector<FILE*> files;
+	int file_format = RECORDER_WAV;
+	float file_sample_rate = 44100.f;
+	uint64_t data_bytes = 0;   // per file
+
+	void writeLoop();
+	bool writeFrames(const float *frames, int frame_count);
+	void writeHeader(FILE *file, int channels, uint64_t bytes);
+};
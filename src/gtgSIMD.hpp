@@ -0,0 +1,162 @@
+#pragma once
+#include "plugin.hpp"
+#include "gtgDSP.hpp"
+
+using simd::float_4;
+
+
+// bank of 16 smoothed pans for polyphonic strips, stored as 4 float_4 blocks
+// set every position with setPans(), then mix() sums the channels into left and right
+// channel order for reverse poly is a lookup table built by setOrder(), not a branch in the mix
+
+struct PanBank {
+
+	float_4 positions[4] = {};   // pan positions from -1.f to 1.f
+	int law = PAN_LAW_3DB;
+
+	PanBank() {
+		reset();
+		setOrder(16, false);
+	}
+
+	void reset() {
+		for (int b = 0; b < 4; b++) {
+			positions[b] = 0.f;
+		}
+		setLevels();
+	}
+
+	void setLaw(int new_law) {
+		law = new_law;
+		setLevels();
+	}
+
+	void setSampleRate(float rate) {
+		sample_rate = rate;
+		setSmoothSpeed(last_speed);
+	}
+
+	void setSmoothSpeed(int speed) {   // milliseconds from pan left to pan right
+		last_speed = speed;
+		delta = 2.f / (sample_rate * 0.001f * (float)speed);
+	}
+
+	float getPosition(int channel) {
+		return positions[channel >> 2].s[channel & 3];
+	}
+
+	float getLevel(int channel, int side) {
+		return levels[side][channel >> 2].s[channel & 3];
+	}
+
+	// smooths every channel toward its target, first channel can jump straight to its target
+	void setPans(const float* targets, bool snap_first = false) {
+		const float snap = 8.f;   // wider than any pan move
+		float_4 step = delta;
+		for (int b = 0; b < 4; b++) {
+			float_4 first_step = (b == 0 && snap_first) ? float_4(snap, delta, delta, delta) : step;
+			float_4 move = float_4::load(&targets[b * 4]) - positions[b];
+			positions[b] += simd::clamp(move, -first_step, first_step);
+		}
+		setLevels();
+	}
+
+	// maps mixed channels to pan channels, reverse poly pans the last channel with the first pan
+	void setOrder(int new_channels, bool new_reverse) {
+		if (new_channels == channels && new_reverse == reverse) return;
+		channels = new_channels;
+		reverse = new_reverse;
+		for (int c = 0; c < 16; c++) {
+			if (c < channels) {
+				order[c] = reverse ? channels - 1 - c : c;
+			} else {
+				order[c] = 16;   // points at the silent block so unused channels add nothing
+			}
+		}
+		setApplied();
+	}
+
+	// sums the used channels of in into left and right with the current pan levels
+	void mix(Input &in, float &left, float &right) {
+		float_4 sums[2] = {0.f, 0.f};
+		for (int b = 0; b < used_blocks; b++) {
+			float_4 channel_in = in.getVoltageSimd<float_4>(b * 4);
+			sums[0] += channel_in * applied[0][b];
+			sums[1] += channel_in * applied[1][b];
+		}
+		left = sums[0].s[0] + sums[0].s[1] + sums[0].s[2] + sums[0].s[3];
+		right = sums[1].s[0] + sums[1].s[1] + sums[1].s[2] + sums[1].s[3];
+	}
+
+private:
+
+	float delta = 0.0005f;
+	float sample_rate = DSP_DEFAULT_SAMPLE_RATE;
+	int last_speed = 91;   // matches the default delta
+	float_4 levels[2][5] = {};   // left and right levels, block 4 stays silent for unused channels
+	float_4 applied[2][4] = {};   // levels in mix order
+	int order[16] = {};
+	int channels = 0;
+	int used_blocks = 4;
+	bool reverse = false;
+
+	void setLevels() {
+		for (int b = 0; b < 4; b++) {
+			panLevels(law, positions[b], levels[0][b], levels[1][b]);
+		}
+		setApplied();
+	}
+
+	void setApplied() {
+		used_blocks = (channels + 3) >> 2;
+		for (int side = 0; side < 2; side++) {
+			for (int c = 0; c < 16; c++) {
+				applied[side][c >> 2].s[c & 3] = levels[side][order[c] >> 2].s[order[c] & 3];
+			}
+		}
+	}
+};
+
+
+// values for groups of 4 lanes that are set once per block and ramped across the block
+// a sample then costs one add per group instead of a gather of each lane's block ramp
+template <int BLOCKS>
+struct BlockRamps {
+
+	float_4 values[BLOCKS] = {};
+	float_4 steps[BLOCKS] = {};
+	float_4 targets[BLOCKS] = {};
+
+	// ramps every lane from the last targets to new targets over DSP_BLOCK_SIZE samples
+	// starting from the last targets stops rounding in the ramp from drifting
+	void setTargets(const float* new_targets) {
+		for (int b = 0; b < BLOCKS; b++) {
+			values[b] = targets[b];
+			targets[b] = float_4::load(&new_targets[b * 4]);
+			steps[b] = (targets[b] - values[b]) * (1.f / DSP_BLOCK_SIZE);
+		}
+	}
+
+	// jumps straight to new targets
+	void reset(const float* new_targets) {
+		for (int b = 0; b < BLOCKS; b++) {
+			targets[b] = float_4::load(&new_targets[b * 4]);
+			values[b] = targets[b];
+			steps[b] = 0.f;
+		}
+	}
+
+	void process() {
+		for (int b = 0; b < BLOCKS; b++) {
+			values[b] += steps[b];
+		}
+	}
+
+	bool isSilent(int block) {
+		return simd::movemask((values[block] != 0.f) | (steps[block] != 0.f)) == 0;
+	}
+
+	float get(int lane) {
+		return values[lane >> 2].s[lane & 3];
+	}
+};
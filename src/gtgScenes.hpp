@@ -0,0 +1,218 @@
+#pragma once
+#include "plugin.hpp"
+#include "gtgDSP.hpp"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+
+// mixer scenes, captured and recalled in every gtg module at once
+// Bus Depot sends a command, and each module picks it up on its own engine thread at its next scene tick
+// each module keeps its scenes as one flat array of values, a row per scene, and morphs through them in a single pass
+
+const int SCENES = 8;
+const int SCENE_TICK = 32;   // samples between scene checks and morph steps
+
+enum SceneCommands {
+	SCENE_CAPTURE,
+	SCENE_RECALL
+};
+
+// the whole command is one 64 bit word, so a module never reads half of a command
+// epoch in the top 24 bits, then 4 bits of command, 4 bits of scene, and the morph time in milliseconds
+struct SceneCoordinator {
+	std::atomic<uint64_t> command_word {0};
+
+	void send(int command, int scene, float morph_seconds) {
+		uint64_t morph_ms = (uint64_t)clamp(morph_seconds * 1000.f, 0.f, 3600000.f);
+		uint64_t word = command_word.load();
+		uint64_t next_word;
+		do {
+			uint64_t epoch = (getEpoch(word) + 1) & 0xffffff;
+			next_word = (epoch << 40) | ((uint64_t)(command & 0xf) << 36) | ((uint64_t)(scene & 0xf) << 32) | morph_ms;
+		} while (!command_word.compare_exchange_weak(word, next_word));
+	}
+
+	void capture(int scene) {
+		send(SCENE_CAPTURE, scene, 0.f);
+	}
+
+	void recall(int scene, float morph_seconds) {
+		send(SCENE_RECALL, scene, morph_seconds);
+	}
+
+	static uint32_t getEpoch(uint64_t word) {
+		return word >> 40;
+	}
+};
+
+extern SceneCoordinator scenes;
+
+
+// the scene part of a module, with the params and on states it stores
+// set up in the module constructor with addParams() and addFader(), then call process() every sample
+// on states are recalled through the module's set_on, so the module can treat them like a click on its button
+struct SceneMemory {
+
+	bool captured[SCENES] = {};
+
+	SceneMemory() {
+		seen_epoch = SceneCoordinator::getEpoch(scenes.command_word.load());   // commands from before the module was made are not for it
+	}
+
+	void addParams(Module *module, int first_param, int count) {
+		scene_module = module;
+		for (int i = 0; i < count; i++) {
+			param_ids.push_back(first_param + i);
+			stepped.push_back(module->paramQuantities[first_param + i]->snapEnabled);   // switches and snap knobs move at the end of a morph
+		}
+		resize();
+	}
+
+	void addFader(AutoFader *fader, std::function<void(bool)> set_on) {
+		faders.push_back(fader);
+		fader_setters.push_back(set_on);
+		resize();
+	}
+
+	// states flipped by momentary buttons, stored instead of the buttons
+	void addToggle(const bool *toggle, std::function<void(bool)> set_toggle) {
+		toggles.push_back(toggle);
+		toggle_setters.push_back(set_toggle);
+		resize();
+	}
+
+	void process(float sample_time) {
+		if (--tick > 0) return;
+		tick = SCENE_TICK;
+
+		uint64_t word = scenes.command_word.load(std::memory_order_relaxed);
+		if (SceneCoordinator::getEpoch(word) != seen_epoch) {
+			seen_epoch = SceneCoordinator::getEpoch(word);
+			int scene = (word >> 32) & 0xf;
+			if (scene < SCENES) {
+				if (((word >> 36) & 0xf) == SCENE_CAPTURE) {
+					capture(scene);
+				} else if (captured[scene]) {
+					recall(scene, (word & 0xffffffff) * 0.001f, sample_time);
+				}
+			}
+		}
+
+		if (morph_scene >= 0) morph();
+	}
+
+	json_t *toJson() {
+		json_t *scenesJ = json_array();
+		for (int s = 0; s < SCENES; s++) {
+			if (captured[s]) {
+				json_t *rowJ = json_array();
+				for (int i = 0; i < row_size; i++) {
+					json_array_append_new(rowJ, json_real(values[(s * row_size) + i]));
+				}
+				json_array_append_new(scenesJ, rowJ);
+			} else {
+				json_array_append_new(scenesJ, json_null());
+			}
+		}
+		return scenesJ;
+	}
+
+	void fromJson(json_t *scenesJ) {
+		for (int s = 0; s < SCENES; s++) {
+			json_t *rowJ = json_array_get(scenesJ, s);
+			captured[s] = rowJ && (int)json_array_size(rowJ) == row_size;   // rows from another version are left out
+			if (!captured[s]) continue;
+			for (int i = 0; i < row_size; i++) {
+				values[(s * row_size) + i] = json_number_value(json_array_get(rowJ, i));
+			}
+		}
+	}
+
+	// stored values of params whose unit changed, stepped params stay whole
+	void scaleParams(int first_param, int count, float factor) {
+		for (size_t i = 0; i < param_ids.size(); i++) {
+			if (param_ids[i] < first_param || param_ids[i] >= first_param + count) continue;
+			for (int s = 0; s < SCENES; s++) {
+				float &value = values[(s * row_size) + i];
+				value = stepped[i] ? std::round(value * factor) : value * factor;
+			}
+			from[i] *= factor;   // a morph on its way keeps going
+		}
+	}
+
+	void clear() {
+		for (int s = 0; s < SCENES; s++) {
+			captured[s] = false;
+		}
+		morph_scene = -1;
+	}
+
+private:
+
+	Module *scene_module = NULL;
+	std::vector<int> param_ids;
+	std::vector<bool> stepped;
+	std::vector<AutoFader*> faders;
+	std::vector<std::function<void(bool)>> fader_setters;
+	std::vector<const bool*> toggles;
+	std::vector<std::function<void(bool)>> toggle_setters;
+	std::vector<float> values;   // SCENES rows of param values, then fader on states, then toggle states
+	std::vector<float> from;   // param values when the morph started
+	int row_size = 0;
+	int tick = 1;
+	uint32_t seen_epoch = 0;
+	int morph_scene = -1;
+	float morph_position = 0.f;
+	float morph_step = 0.f;
+
+	void resize() {
+		row_size = param_ids.size() + faders.size() + toggles.size();
+		values.assign(SCENES * row_size, 0.f);
+		from.assign(param_ids.size(), 0.f);
+	}
+
+	void capture(int scene) {
+		float *row = &values[scene * row_size];
+		for (size_t i = 0; i < param_ids.size(); i++) {
+			row[i] = scene_module->params[param_ids[i]].getValue();
+		}
+		for (size_t f = 0; f < faders.size(); f++) {
+			row[param_ids.size() + f] = faders[f]->on ? 1.f : 0.f;
+		}
+		for (size_t t = 0; t < toggles.size(); t++) {
+			row[param_ids.size() + faders.size() + t] = *toggles[t] ? 1.f : 0.f;
+		}
+		captured[scene] = true;
+	}
+
+	// on states go now and fade at their own speed, params jump or start a morph
+	void recall(int scene, float morph_seconds, float sample_time) {
+		const float *row = &values[scene * row_size];
+		for (size_t f = 0; f < faders.size(); f++) {
+			fader_setters[f](row[param_ids.size() + f] > 0.5f);
+		}
+		for (size_t i = 0; i < param_ids.size(); i++) {
+			from[i] = scene_module->params[param_ids[i]].getValue();
+		}
+		morph_scene = scene;
+		morph_position = 0.f;
+		morph_step = (morph_seconds > 0.f) ? (SCENE_TICK * sample_time) / morph_seconds : 1.f;
+		morph();
+	}
+
+	void morph() {
+		morph_position = std::min(morph_position + morph_step, 1.f);
+		const float *row = &values[morph_scene * row_size];
+		for (size_t i = 0; i < param_ids.size(); i++) {
+			if (stepped[i] && morph_position < 1.f) continue;
+			scene_module->params[param_ids[i]].setValue((morph_position < 1.f) ? from[i] + ((row[i] - from[i]) * morph_position) : row[i]);
+		}
+		if (morph_position >= 1.f) {
+			for (size_t t = 0; t < toggles.size(); t++) {   // with the switches, at the end of a morph
+				toggle_setters[t](row[param_ids.size() + faders.size() + t] > 0.5f);
+			}
+			morph_scene = -1;
+		}
+	}
+};
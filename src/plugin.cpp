@@ -1,15 +1,21 @@
 #include "plugin.hpp"
+#include "gtgComponents.hpp"
+#include "gtgAudition.hpp"
+#include "gtgScenes.hpp"
+#include "gtgAutomation.hpp"
 
 
 Plugin *pluginInstance;
 
 // variables used by all modules
-bool audition_mixer = false;
-bool audition_depot = false;
+AuditionCoordinator auditions;
+SceneCoordinator scenes;
+AutomationTransport automation_transport;
 int gtg_default_theme = 0;
 
 void init(Plugin *p) {
 	pluginInstance = p;
+	loadGtgPluginDefaults();   // read the settings file once for every module
 
 	// Add modules here
 	// p->addModel(modelMyModule);
@@ -22,6 +28,12 @@ void init(Plugin *p) {
 	p->addModel(modelRoad);
 	p->addModel(modelEnterBus);
 	p->addModel(modelExitBus);
+	p->addModel(modelBusTerminal);
 	// Any other plugin initialization may go here.
 	// As an alternative, consider lazy-loading assets and lookup tables when your module is created to reduce startup times of Rack.
 }
+
+// Rack calls this before unloading the plugin, while other threads can still be joined
+void destroy() {
+	stopGtgPluginDefaults();
+}
@@ -7,8 +7,6 @@ using namespace rack;
 extern Plugin *pluginInstance;
 
 // variables used by all plugins
-extern bool audition_mixer;
-extern bool audition_depot;
 extern int gtg_default_theme;
 
 // Declare each Model, defined in each module source file
@@ -22,3 +20,4 @@ extern Model *modelBusRoute;
 extern Model *modelRoad;
 extern Model *modelEnterBus;
 extern Model *modelExitBus;
+extern Model *modelBusTerminal;
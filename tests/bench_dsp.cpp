@@ -0,0 +1,245 @@
+#include "gtgDSP.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// headless timings of the dsp paths, run with make dsp-bench
+// every case runs long enough to take a few milliseconds and reports the best of several runs in ns per sample
+
+static volatile float bench_sink = 0.f;   // keeps the compiler from dropping the work
+
+template <typename F>
+static void bench(const char *name, int samples, F work) {
+	double best = 1e30;
+	for (int run = 0; run < 7; run++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		work(samples);
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best = std::min(best, ns / samples);
+	}
+	std::printf("%-44s %8.2f ns/sample\n", name, best);
+}
+
+// four lanes like Rack's simd::float_4, so the vector pan law can be timed without the Rack SDK
+// built on the gcc and clang vector extension, min and max select like _mm_min_ps and _mm_max_ps
+typedef float bench_lanes __attribute__((vector_size(16)));
+
+struct bench_float_4 {
+	bench_lanes v;
+	bench_float_4() {}
+	bench_float_4(bench_lanes lanes) : v(lanes) {}
+	bench_float_4(float x) : v(bench_lanes{x, x, x, x}) {}
+	static bench_float_4 load(const float *x) {
+		bench_lanes lanes;
+		std::memcpy(&lanes, x, sizeof(lanes));
+		return lanes;
+	}
+	float sum() const {
+		return v[0] + v[1] + v[2] + v[3];
+	}
+};
+
+inline bench_float_4 operator+(bench_float_4 a, bench_float_4 b) {return bench_float_4(a.v + b.v);}
+inline bench_float_4 operator-(bench_float_4 a, bench_float_4 b) {return bench_float_4(a.v - b.v);}
+inline bench_float_4 operator*(bench_float_4 a, bench_float_4 b) {return bench_float_4(a.v * b.v);}
+inline bench_float_4 fmin(bench_float_4 a, bench_float_4 b) {return bench_float_4(a.v < b.v ? a.v : b.v);}
+inline bench_float_4 fmax(bench_float_4 a, bench_float_4 b) {return bench_float_4(a.v > b.v ? a.v : b.v);}
+inline bench_float_4 sqrt(bench_float_4 a) {return bench_float_4(bench_lanes{std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3])});}
+
+static float positions[1024];   // a sweep from hard left to hard right
+
+static void benchPan() {
+	const int samples = 1 << 20;
+	for (int i = 0; i < 1024; i++) positions[i] = -1.f + (2.f * i / 1023.f);
+	std::printf("pan levels, one position per sample\n");
+	bench("sin() in double, the old law", samples, [](int n) {
+		float sum = 0.f;
+		for (int i = 0; i < n; i++) {
+			float pan_angle = (positions[i & 1023] + 1.f) * 0.5f;
+			sum += (float)(std::sin((1.f - pan_angle) * M_PI_2) * M_SQRT2);
+			sum += (float)(std::sin(pan_angle * M_PI_2) * M_SQRT2);
+		}
+		bench_sink = sum;
+	});
+	const char *law_names[NUM_PAN_LAWS] = {"panLevels -3 dB", "panLevels -4.5 dB", "panLevels -6 dB", "panLevels linear"};
+	for (int law = 0; law < NUM_PAN_LAWS; law++) {
+		bench(law_names[law], samples, [law](int n) {
+			float sum = 0.f;
+			for (int i = 0; i < n; i++) {
+				float left, right;
+				panLevels(law, positions[i & 1023], left, right);
+				sum += left + right;
+			}
+			bench_sink = sum;
+		});
+	}
+	const char *vector_names[NUM_PAN_LAWS] = {"panLevels -3 dB, float_4", "panLevels -4.5 dB, float_4", "panLevels -6 dB, float_4", "panLevels linear, float_4"};
+	for (int law = 0; law < NUM_PAN_LAWS; law++) {
+		bench(vector_names[law], samples, [law](int n) {
+			bench_float_4 sum = 0.f;
+			for (int i = 0; i < n; i += 4) {
+				bench_float_4 left, right;
+				panLevels(law, bench_float_4::load(&positions[i & 1023]), left, right);
+				sum = sum + left + right;
+			}
+			bench_sink = sum.sum();
+		});
+	}
+}
+
+static void benchFadeTables() {
+	const int samples = 1 << 20;
+	std::printf("\nfade curve tables, one fade per sample\n");
+	const char *curve_names[NUM_FADE_CURVES] = {"getCurveFade exponential", "getCurveFade logarithmic", "getCurveFade s-curve", "getCurveFade equal power", "getCurveFade linear"};
+	for (int curve = 0; curve < NUM_FADE_CURVES; curve++) {
+		bench(curve_names[curve], samples, [curve](int n) {
+			static AutoFader fader;
+			fader.setCurve(curve);
+			float sum = 0.f;
+			for (int i = 0; i < n; i++) {
+				fader.fade = (positions[i & 1023] + 1.f) * 0.5f;
+				sum += fader.getCurveFade();
+			}
+			bench_sink = sum;
+		});
+	}
+}
+
+// the block paths as the modules run them, DSP_BLOCK_SIZE samples at a time
+// idle has nothing moving, fading keeps the fader moving, panning moves the pan every block
+
+static void benchBlocks() {
+	const int samples = 1 << 22;
+	static float gains[DSP_BLOCK_SIZE];
+	static float left[DSP_BLOCK_SIZE];
+	static float right[DSP_BLOCK_SIZE];
+
+	std::printf("\nblock paths\n");
+	bench("processBlock idle", samples, [](int n) {
+		static AutoFader fader;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			fader.processBlock(gains, DSP_BLOCK_SIZE);
+			sum += gains[0];
+		}
+		bench_sink = sum;
+	});
+	bench("processBlock fading", samples, [](int n) {
+		static AutoFader fader;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			if (fader.getFade() == (fader.on ? fader.getGain() : 0.f)) fader.on = !fader.on;   // turn around at each end
+			fader.processBlock(gains, DSP_BLOCK_SIZE);
+			sum += gains[DSP_BLOCK_SIZE - 1];
+		}
+		bench_sink = sum;
+	});
+	bench("slewBlock idle", samples, [](int n) {
+		static SimpleSlewer slewer;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			slewer.slewBlock(0.f, gains, DSP_BLOCK_SIZE);
+			sum += gains[0];
+		}
+		bench_sink = sum;
+	});
+	bench("slewBlock slewing", samples, [](int n) {
+		static SimpleSlewer slewer;
+		float sum = 0.f;
+		float target = 1.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			if (slewer.value == target) target = 1.f - target;
+			slewer.slewBlock(target, gains, DSP_BLOCK_SIZE);
+			sum += gains[DSP_BLOCK_SIZE - 1];
+		}
+		bench_sink = sum;
+	});
+	bench("levelsBlock idle", samples, [](int n) {
+		static ConstantPan pan;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			pan.levelsBlock(0.f, left, right, DSP_BLOCK_SIZE);
+			sum += left[0] + right[0];
+		}
+		bench_sink = sum;
+	});
+	bench("levelsBlock panning", samples, [](int n) {
+		static ConstantPan pan;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			pan.levelsBlock(positions[(i / DSP_BLOCK_SIZE) & 1023], left, right, DSP_BLOCK_SIZE);
+			sum += left[DSP_BLOCK_SIZE - 1] + right[DSP_BLOCK_SIZE - 1];
+		}
+		bench_sink = sum;
+	});
+	bench("levelsBlock panning, smoothed", samples, [](int n) {
+		static ConstantPan pan;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			pan.levelsBlock(((i / 4096) & 1) ? 1.f : -1.f, left, right, DSP_BLOCK_SIZE, true);
+			sum += left[DSP_BLOCK_SIZE - 1] + right[DSP_BLOCK_SIZE - 1];
+		}
+		bench_sink = sum;
+	});
+}
+
+// a stereo strip as GigBus runs it, fader, post fade slew and pan applied to a block of audio
+struct BenchStrip {
+	AutoFader fader;
+	SimpleSlewer post_fade;
+	ConstantPan pan;
+	float fade_gains[DSP_BLOCK_SIZE];
+	float post_gains[DSP_BLOCK_SIZE];
+	float pan_levels[2][DSP_BLOCK_SIZE];
+	float audio[2][DSP_BLOCK_SIZE];
+
+	float processBlock(float pan_position) {
+		bool fade_constant = fader.processBlock(fade_gains, DSP_BLOCK_SIZE);
+		bool post_constant = post_fade.slewBlock(1.f, post_gains, DSP_BLOCK_SIZE);
+		bool pan_constant = pan.levelsBlock(pan_position, pan_levels[0], pan_levels[1], DSP_BLOCK_SIZE);
+		for (int i = 0; i < DSP_BLOCK_SIZE; i++) {
+			float gain = fade_gains[fade_constant ? 0 : i] * post_gains[post_constant ? 0 : i];
+			audio[0][i] = 0.5f * gain * pan_levels[0][pan_constant ? 0 : i];
+			audio[1][i] = 0.5f * gain * pan_levels[1][pan_constant ? 0 : i];
+		}
+		return audio[0][DSP_BLOCK_SIZE - 1] + audio[1][DSP_BLOCK_SIZE - 1];
+	}
+};
+
+static void benchStrip() {
+	const int samples = 1 << 22;
+	std::printf("\nstereo strip, fader, slew and pan on a block of audio\n");
+	bench("strip idle", samples, [](int n) {
+		static BenchStrip strip;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			sum += strip.processBlock(0.f);
+		}
+		bench_sink = sum;
+	});
+	bench("strip fading", samples, [](int n) {
+		static BenchStrip strip;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			if (strip.fader.getFade() == (strip.fader.on ? strip.fader.getGain() : 0.f)) strip.fader.on = !strip.fader.on;
+			sum += strip.processBlock(0.f);
+		}
+		bench_sink = sum;
+	});
+	bench("strip panning", samples, [](int n) {
+		static BenchStrip strip;
+		float sum = 0.f;
+		for (int i = 0; i < n; i += DSP_BLOCK_SIZE) {
+			sum += strip.processBlock(positions[(i / DSP_BLOCK_SIZE) & 1023]);
+		}
+		bench_sink = sum;
+	});
+}
+
+int main() {
+	benchPan();
+	benchFadeTables();
+	benchBlocks();
+	benchStrip();
+	return 0;
+}
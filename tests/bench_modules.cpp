@@ -0,0 +1,396 @@
+#include "module_test.hpp"
+#include <chrono>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// headless timings of whole modules through process(), run with make dsp-bench
+// each case is a module in one input layout and one state, patched to a test source on the engine in tests/rack
+// the same patch with the module bypassed is timed too and taken off, so the numbers are the module alone
+// per channel divides by the audio channels the module takes in, or the bus channels on every chain it mixes
+// cache misses are counted by the kernel where it allows, per 1000 samples and also less the bypassed patch
+
+static const int BENCH_FRAMES = 1 << 15;
+static const int BENCH_RUNS = 5;
+
+// last level cache misses of this thread in user space, n/a without perf events
+struct CacheMissCounter {
+	int fd = -1;
+
+	CacheMissCounter() {
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+
+	~CacheMissCounter() {
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	bool isAvailable() {
+		return fd >= 0;
+	}
+
+	void start() {
+#ifdef __linux__
+		if (fd < 0) return;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+
+	long long stop() {
+		long long count = 0;
+#ifdef __linux__
+		if (fd < 0) return 0;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+		return count;
+	}
+};
+
+static CacheMissCounter cache_misses;
+
+enum BenchLayouts {
+	MONO_LAYOUT,
+	STEREO_LAYOUT,
+	POLY_LAYOUT,   // 16 channels on the left or only input
+	BUS_LAYOUT,   // 3 stereo buses on 6 channels
+	LATENCY_LAYOUT,   // the same into a Road lining up chains, so chains carry latency
+	WIDE_LAYOUT,   // the wide bus on 16 channels
+	NUM_LAYOUTS
+};
+
+enum BenchStates {
+	IDLE_STATE,   // turned off and faded out, or silent input where there is no on button
+	ON_STATE,
+	FADING_STATE,   // on and off again before each fade ends
+	PANNING_STATE,   // pan knobs swept, with pan cv where there is an input
+	CV_STATE,   // level cv or level knobs swept
+	SOLOED_STATE,   // the first strip or bus auditioned with a long press
+	NUM_STATES
+};
+
+static const char *layout_names[NUM_LAYOUTS] = {"mono", "stereo", "poly 16", "bus", "latency bus", "wide bus"};
+static const char *state_names[NUM_STATES] = {"idle", "on", "fading", "panning", "cv", "soloed"};
+
+// ports and params of the mixers, by the names they were configured with
+// Bus Terminal names carry the strip number
+struct BenchMixer {
+	const char *slug;
+	int strips;
+	const char *left;
+	const char *right;
+	const char *on;
+	const char *on_cv;
+	const char *pan;
+	const char *pan_cv;
+	std::vector<std::string> level_cvs;
+	bool fade_params;   // Bus Depot sets its fades on knobs, the strips in their menus
+};
+
+static const std::vector<BenchMixer> bench_mixers = {
+	{"GigBus", 1, "Left, mono, or poly", "Right", "Input on", "On CV", "Pan", NULL, {}, false},
+	{"MiniBus", 1, "Mono or poly", NULL, "Input on", "On CV", NULL, NULL, {}, false},
+	{"SchoolBus", 1, "Left, mono, or poly", "Right", "Input on", "On CV", "Pan", "Pan CV (-5.0 to 5.0)", {"Blue level CV", "Orange level CV", "Red level CV"}, false},
+	{"MetroCityBus", 1, "Poly", NULL, "Input on", "On CV", "Pan", "Pan poly follow CV (-5.0 to 5.0)", {"Blue level CV", "Orange level CV", "Red level CV"}, false},
+	{"BusTerminal", 8, "Strip %d left, mono, or poly", "Strip %d right", "Strip %d on", "Strip %d on CV", "Strip %d pan", NULL, {}, false},
+	{"BusDepot", 1, "Left, mono, or poly", "Right", "Output on", "On CV", NULL, NULL, {"Level CV"}, true}
+};
+
+static std::string stripName(const char *name, int strip) {
+	return string::f(name, strip + 1);
+}
+
+static TestSignal audioSignal(int channels) {
+	TestSignal signal;
+	signal.shape = TestSignal::AUDIO;
+	signal.channels = channels;
+	return signal;
+}
+
+// rising edges every period, wide enough for a button to see a short press
+static TestSignal gateSignal(float period, float width, float amplitude) {
+	TestSignal signal;
+	signal.shape = TestSignal::GATE;
+	signal.period = (int)(period * TEST_SAMPLE_RATE);
+	signal.width = (int)(width * TEST_SAMPLE_RATE);
+	signal.amplitude = amplitude;
+	return signal;
+}
+
+static TestSignal sweepSignal(float offset, float amplitude, float period) {
+	TestSignal signal;
+	signal.shape = TestSignal::TRIANGLE;
+	signal.offset = offset;
+	signal.amplitude = amplitude;
+	signal.period = (int)(period * TEST_SAMPLE_RATE);
+	return signal;
+}
+
+// blue and orange sends half up on every strip, so the send paths run
+static void openSends(Module *module) {
+	for (ParamQuantity *quantity : module->paramQuantities) {
+		if (quantity->name.find("to blue") != std::string::npos || quantity->name.find("to orange") != std::string::npos) {
+			quantity->setValue(0.5f);
+		}
+	}
+}
+
+// patches a mixer for a case, returns NULL when the case does not apply to it
+static Module *patchMixer(TestPatch &patch, const BenchMixer &mixer, int layout, int state, int &channels) {
+	if (layout > POLY_LAYOUT) return NULL;
+	if (layout == STEREO_LAYOUT && !mixer.right) return NULL;
+	if (state == PANNING_STATE && !mixer.pan) return NULL;
+	if (state == CV_STATE && mixer.level_cvs.empty()) return NULL;
+
+	Module *module = patch.add(mixer.slug);
+	openSends(module);
+
+	// one source output feeds every strip, a cable can go to many inputs
+	int audio = patch.source->addSignal(audioSignal(layout == POLY_LAYOUT ? 16 : 1));
+	for (int s = 0; s < mixer.strips; s++) {
+		patch.connect(patch.source, audio, module, findInput(module, stripName(mixer.left, s)));
+		if (layout == STEREO_LAYOUT) patch.connect(patch.source, audio, module, findInput(module, stripName(mixer.right, s)));
+	}
+	channels = mixer.strips * ((layout == POLY_LAYOUT) ? 16 : (layout == STEREO_LAYOUT) ? 2 : 1);
+
+	switch (state) {
+	case IDLE_STATE:
+		for (int s = 0; s < mixer.strips; s++) {
+			patch.press(module, findParam(module, stripName(mixer.on, s)));
+		}
+		break;
+	case FADING_STATE: {
+		if (mixer.fade_params) {
+			module->params[findParam(module, "Fade out automation in milliseconds")].setValue(200.f);
+			module->params[findParam(module, "Fade in automation in milliseconds")].setValue(200.f);
+		} else {
+			setModuleData(module, "fade_in", json_real(200.f));
+			setModuleData(module, "fade_out", json_real(200.f));
+		}
+		int gates = patch.source->addSignal(gateSignal(0.25f, 0.01f, 10.f));
+		for (int s = 0; s < mixer.strips; s++) {
+			patch.connect(patch.source, gates, module, findInput(module, stripName(mixer.on_cv, s)));
+		}
+		break;
+	}
+	case PANNING_STATE:
+		for (int s = 0; s < mixer.strips; s++) {
+			patch.source->addParamLane(module, findParam(module, stripName(mixer.pan, s)), sweepSignal(0.f, 1.f, 2.f));
+		}
+		if (mixer.pan_cv) patch.feed(sweepSignal(0.f, 5.f, 1.3f), module, findInput(module, mixer.pan_cv));
+		break;
+	case CV_STATE:
+		for (const std::string &level_cv : mixer.level_cvs) {
+			patch.feed(sweepSignal(5.f, 5.f, 0.7f), module, findInput(module, level_cv));
+		}
+		break;
+	case SOLOED_STATE:
+		patch.press(module, findParam(module, stripName(mixer.on, 0)), 0.8f);
+		break;
+	}
+	return module;
+}
+
+static const char *bus_slugs[] = {"EnterBus", "ExitBus", "BusRoute", "Road"};
+
+// an Enter Bus making a bus chain out of test audio on all three buses
+static Module *addBusMaker(TestPatch &patch, int audio) {
+	Module *enter = patch.add("EnterBus");
+	const char *inputs[6] = {"Blue left", "Blue right", "Orange left", "Orange right", "Red left", "Red right"};
+	for (const char *input : inputs) {
+		patch.connect(patch.source, audio, enter, findInput(enter, input));
+	}
+	return enter;
+}
+
+static void setWideBus(TestPatch &patch) {
+	for (Module *module : patch.modules) {
+		if (module != patch.source) setModuleData(module, "wide_bus", json_integer(1));
+	}
+}
+
+// patches a bus module for a case, chains come from Enter Bus modules and the latency layout ends at a Road
+static Module *patchBusModule(TestPatch &patch, const std::string &slug, int layout, int state, int &channels) {
+	if (layout < BUS_LAYOUT) return NULL;
+	bool has_buttons = (slug == "BusRoute" || slug == "Road");   // Enter and Exit Bus are idle on silent input
+	if (!has_buttons && (state == FADING_STATE || state == SOLOED_STATE)) return NULL;
+	if (state == PANNING_STATE) return NULL;
+	if (state == CV_STATE && slug != "EnterBus" && slug != "BusRoute") return NULL;
+
+	int audio = patch.source->addSignal(state == IDLE_STATE && !has_buttons ? TestSignal() : audioSignal(1));
+	int bus_channels = (layout == WIDE_LAYOUT) ? WIDE_BUS_CHANNELS : BUS_CHANNELS;
+	Module *module;
+	Module *chain_end;
+	if (slug == "EnterBus") {
+		module = addBusMaker(patch, audio);
+		chain_end = module;
+		channels = bus_channels;
+	} else if (slug == "Road") {
+		module = patch.add("Road");
+		for (int b = 0; b < 6; b++) {
+			Module *chain = addBusMaker(patch, audio);
+			if (b == 0 && layout == LATENCY_LAYOUT) {   // a delay on one chain, so the Road delays the others to match
+				Module *route = patch.add("BusRoute");
+				patch.connect(chain, findOutput(chain, "Bus chain"), route, findInput(route, "Bus chain"));
+				route->params[findParam(route, "Delay on red bus")].setValue(441.f);
+				chain = route;
+			}
+			patch.connect(chain, findOutput(chain, "Bus chain"), module, findInput(module, string::f("Bus chain %d", b + 1)));
+		}
+		if (layout == BUS_LAYOUT) setModuleData(module, "latency_compensation", json_integer(0));
+		chain_end = NULL;
+		channels = 6 * bus_channels;
+	} else {
+		Module *enter = addBusMaker(patch, audio);
+		module = patch.add(slug);
+		patch.connect(enter, findOutput(enter, "Bus chain"), module, findInput(module, "Bus chain"));
+		chain_end = module;
+		channels = bus_channels;
+	}
+	if (slug == "BusRoute") {
+		// sends straight back to the returns, with a delay on every bus
+		for (const char *bus : {"Blue", "Orange", "Red"}) {
+			for (const char *side : {"left", "right"}) {
+				patch.connect(module, findOutput(module, string::f("%s send %s", bus, side)), module, findInput(module, string::f("%s return %s", bus, side)));
+			}
+		}
+		for (const char *delay : {"Delay on blue bus", "Delay on orange bus", "Delay on red bus"}) {
+			module->params[findParam(module, delay)].setValue(441.f);
+		}
+	}
+	if (chain_end && layout == LATENCY_LAYOUT) {   // a Road only asks for latency while it lines up 2 chains or more
+		Module *road = patch.add("Road");
+		patch.connect(chain_end, findOutput(chain_end, "Bus chain"), road, findInput(road, "Bus chain 1"));
+		patch.connect(chain_end, findOutput(chain_end, "Bus chain"), road, findInput(road, "Bus chain 2"));
+	}
+	if (layout == WIDE_LAYOUT) setWideBus(patch);
+
+	std::vector<int> buttons;
+	if (slug == "BusRoute") {
+		for (const char *button : {"Blue bus on (hold to audition)", "Orange bus on (hold to audition)", "Red bus on (hold to audition)"}) {
+			buttons.push_back(findParam(module, button));
+		}
+	} else if (slug == "Road") {
+		for (int b = 0; b < 6; b++) {
+			buttons.push_back(findParam(module, string::f("BUS IN %d on", b + 1)));
+		}
+	}
+
+	switch (state) {
+	case IDLE_STATE:
+		for (int button : buttons) patch.press(module, button);
+		break;
+	case FADING_STATE:
+		// their fades are 26 ms, so a press every 60 ms keeps them fading
+		for (int button : buttons) patch.source->addParamLane(module, button, gateSignal(0.06f, 0.01f, 1.f));
+		break;
+	case CV_STATE:
+		if (slug == "EnterBus") {
+			for (const char *level : {"Blue stereo input level", "Orange stereo input level", "Red stereo input level"}) {
+				patch.source->addParamLane(module, findParam(module, level), sweepSignal(0.5f, 0.5f, 0.7f));
+			}
+		} else {
+			for (const char *delay : {"Delay on blue bus", "Delay on orange bus", "Delay on red bus"}) {
+				patch.source->addParamLane(module, findParam(module, delay), sweepSignal(441.f, 400.f, 0.7f));
+			}
+		}
+		break;
+	case SOLOED_STATE:
+		patch.press(module, buttons[0], 0.8f);
+		break;
+	}
+	return module;
+}
+
+struct BenchRun {
+	double ns = 1e30;
+	long long misses = 0;
+};
+
+// steps the engine in ui frames, with the widgets stepped between them outside the timing
+static BenchRun timeRun(TestPatch &patch) {
+	BenchRun run;
+	run.ns = 0.0;
+	for (int frames = BENCH_FRAMES; frames > 0; frames -= patch.ui_frames) {
+		int block = std::min(frames, patch.ui_frames);
+		cache_misses.start();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		patch.engine->stepBlock(block);
+		run.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		run.misses += cache_misses.stop();
+		patch.stepWidgets();
+	}
+	return run;
+}
+
+static void benchCase(TestPatch &patch, Module *module, const std::string &name, int channels) {
+	patch.runSeconds(0.6f);   // fades settle and Roads find their chains on their 30th ui frame
+
+	// best of several runs, the module and the bypassed patch in turn
+	BenchRun best;
+	BenchRun baseline;
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		BenchRun timed = timeRun(patch);
+		if (timed.ns < best.ns) best = timed;
+		patch.engine->bypassModule(module, true);
+		timed = timeRun(patch);
+		if (timed.ns < baseline.ns) baseline = timed;
+		patch.engine->bypassModule(module, false);
+	}
+
+	double ns = std::max(best.ns - baseline.ns, 0.0) / BENCH_FRAMES;
+	std::string misses = "n/a";
+	if (cache_misses.isAvailable()) {
+		misses = string::f("%.2f", (best.misses - baseline.misses) * 1000.0 / BENCH_FRAMES);
+	}
+	std::printf("%-34s %8.2f ns/sample %8.3f ns/channel %10s misses/1k\n", name.c_str(), ns, ns / channels, misses.c_str());
+}
+
+int main() {
+	initTestPlugin();
+	std::printf("modules at %g Hz, %d samples per run, less the same patch with the module bypassed\n", TEST_SAMPLE_RATE, BENCH_FRAMES);
+	if (!cache_misses.isAvailable()) std::printf("cache misses n/a, perf events are not allowed here\n");
+
+	for (const BenchMixer &mixer : bench_mixers) {
+		for (int layout = 0; layout < NUM_LAYOUTS; layout++) {
+			for (int state = 0; state < NUM_STATES; state++) {
+				TestPatch patch;
+				int channels = 1;
+				Module *module = patchMixer(patch, mixer, layout, state, channels);
+				if (!module) continue;
+				benchCase(patch, module, string::f("%s %s %s", mixer.slug, layout_names[layout], state_names[state]), channels);
+			}
+		}
+	}
+	for (const char *slug : bus_slugs) {
+		for (int layout = 0; layout < NUM_LAYOUTS; layout++) {
+			for (int state = 0; state < NUM_STATES; state++) {
+				TestPatch patch;
+				int channels = 1;
+				Module *module = patchBusModule(patch, slug, layout, state, channels);
+				if (!module) continue;
+				benchCase(patch, module, string::f("%s %s %s", slug, layout_names[layout], state_names[state]), channels);
+			}
+		}
+	}
+
+	destroy();
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include "gtgDSP.hpp"
+#include "dsp_test.hpp"
+
+// builds every class in gtgDSP.hpp without the Rack SDK and runs each member once
+// the results only need to be sane here, the other tests check that they are right
+
+template float panSin<float>(float x);
+template void panLevels<float>(int law, float position, float &left, float &right);
+
+int main() {
+	const float sample_rate = 48000.f;
+
+	for (int curve = 0; curve < NUM_FADE_CURVES; curve++) {
+		const float *table = getFadeCurveTables().getTable(curve);
+		DSP_CHECK(table[0] == 0.f && table[FADE_TABLE_SIZE] == 1.f, "fade curve %d does not run from 0 to 1", curve);
+	}
+
+	AutoFader fader;
+	fader.setSampleRate(sample_rate);
+	fader.setGain(2.f);
+	fader.setCurve(FADE_CURVE_S);
+	fader.setSpeed(10);
+	fader.modulateSpeed(10.2f);
+	fader.on = false;
+	fader.process();
+	fader.on = true;
+	float gains[DSP_BLOCK_SIZE];
+	for (int b = 0; b < 100 && !fader.processBlock(gains, DSP_BLOCK_SIZE); b++) {}
+	DSP_CHECK(fader.getFade() == fader.getGain() && fader.getCurve() == FADE_CURVE_S && dspFinite(fader.getCurveFade()), "fader did not reach its gain");
+
+	ConstantPan pan;
+	pan.setSampleRate(sample_rate);
+	pan.setSmoothSpeed(20);
+	pan.setLaw(PAN_LAW_4_5DB);
+	pan.setPan(-0.5f);
+	pan.setSmoothPan(0.5f);
+	float left[DSP_BLOCK_SIZE], right[DSP_BLOCK_SIZE];
+	pan.levelsBlock(1.f, left, right, DSP_BLOCK_SIZE, true);
+	DSP_CHECK(dspFinite(pan.getLevel(0)) && dspFinite(pan.getLevel(1)) && dspFinite(left[DSP_BLOCK_SIZE - 1]), "pan levels are not finite");
+
+	SimpleSlewer slewer;
+	slewer.setSampleRate(sample_rate);
+	slewer.setSlewSpeed(5);
+	float slewed[DSP_BLOCK_SIZE];
+	slewer.slewBlock(1.f, slewed, DSP_BLOCK_SIZE);
+	DSP_CHECK(slewer.slew(1.f) > 0.f && slewed[0] > 0.f, "slewer did not move");
+
+	ControlHistory history;
+	history.setRate(sample_rate / 32.f, 100.f);
+	history.reset();
+	for (int i = 0; i < 1000; i++) history.push(i * 0.001f);
+	DSP_CHECK(history.read(0.5f) < history.read(0.f), "history reads back in the wrong order");
+
+	BusDelayLine bus_delay;
+	bus_delay.setMaxDelay(4800);   // 100 ms at 48 kHz
+	float bus[6] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+	bus_delay.process(bus, bus, 0);
+	DSP_CHECK(bus[5] == 6.f, "bus delay of 0 changed the bus");
+	for (int i = 0; i < 4800; i++) {
+		float silence[6] = {};
+		bus_delay.process(silence, bus, 4800);
+	}
+	DSP_CHECK(bus_delay.getMaxDelay() >= 4800 && bus[5] == 6.f, "bus delay did not hold 4800 samples");
+
+	StereoDelayLine stereo_delay;
+	stereo_delay.setMaxDelay(100);
+	float frame[2] = {1.f, -1.f};
+	stereo_delay.process(frame, frame, 2.5f);
+	DSP_CHECK(stereo_delay.getMaxDelay() >= 100 && dspFinite(frame[0]), "stereo delay is too short");
+
+	static LookAheadLimiter limiter;
+	limiter.setSampleRate(sample_rate);
+	limiter.setCeiling(5.f);
+	float channels[2] = {8.f, -8.f};
+	for (int i = 0; i <= limiter.getLatency(); i++) limiter.process(channels, 2, 8.f);
+	DSP_CHECK(std::fabs(channels[0]) <= 5.f && limiter.getGain() < 1.f, "limiter passed the ceiling");
+
+	// a restart sounds the same as a cleared limiter
+	static LookAheadLimiter cleared;
+	cleared.setSampleRate(sample_rate);
+	cleared.setCeiling(5.f);
+	limiter.restart();
+	bool same = true;
+	for (int i = 0; i < 500; i++) {
+		float level = (i % 50) * 0.2f;
+		float restarted_frame[2] = {level, -level};
+		float cleared_frame[2] = {level, -level};
+		limiter.process(restarted_frame, 2, level);
+		cleared.process(cleared_frame, 2, level);
+		same = same && restarted_frame[0] == cleared_frame[0] && restarted_frame[1] == cleared_frame[1];
+	}
+	DSP_CHECK(same, "restarted limiter differs from a cleared one");
+	limiter.reset();
+
+	static LatencyProbe probe;
+	probe.start();
+	int samples = 0;
+	float sent = 0.f;
+	while (probe.isRunning() && samples++ < 100000) sent = probe.process(sent, sent);   // a return of 1 sample
+	DSP_CHECK(probe.takeResult() == LatencyProbe::PROBE_FOUND && probe.getLatency() == 1 && probe.getState() == LatencyProbe::PROBE_IDLE, "probe measured %d samples", probe.getLatency());
+
+	// 100 ms at 48 kHz, past the 1023 sample sequence
+	probe.setMaxLatency(4800);
+	std::vector<float> path(3000, 0.f);
+	probe.start();
+	samples = 0;
+	while (probe.isRunning() && samples < 1000000) {
+		float returned = path[samples % path.size()];   // sent 3000 samples ago
+		path[samples++ % path.size()] = probe.process(returned, returned);
+	}
+	DSP_CHECK(probe.getMaxLatency() == 4800 && probe.takeResult() == LatencyProbe::PROBE_FOUND && probe.getLatency() == 3000, "probe measured %d samples of 3000", probe.getLatency());
+
+	return dspResult("dsp_check");
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+// checks shared by the headless dsp tests, each test is its own program and fails with a non-zero exit
+
+static int dsp_failures = 0;
+
+#define DSP_CHECK(condition, ...) do { \
+	if (!(condition)) { \
+		dsp_failures++; \
+		std::printf("%s:%d: ", __FILE__, __LINE__); \
+		std::printf(__VA_ARGS__); \
+		std::printf("\n"); \
+	} \
+} while (0)
+
+inline bool dspFinite(float value) {
+	return std::isfinite(value);
+}
+
+inline int dspResult(const char *name) {
+	std::printf("%s: %s\n", name, dsp_failures ? "FAILED" : "ok");
+	return dsp_failures ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "dsp_test.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// renders compared with the reference output in tests/golden, shared by the dsp and module golden tests
+// after an intended change to the sound, rewrite the references with make dsp-golden and commit them with the change
+
+static const char *golden_dir = "tests/golden/";
+static const float golden_tolerance = 1e-5f;   // relative to the reference, or absolute under 1
+static const int golden_step = 4;   // every 4th sample is kept, enough to catch a change without large files
+static bool golden_updating = false;
+
+inline void compareGolden(const char *name, const std::vector<float> &render) {
+	std::string filename = std::string(golden_dir) + name + ".txt";
+	if (golden_updating) {
+		FILE *file = std::fopen(filename.c_str(), "w");
+		DSP_CHECK(file, "%s: could not write %s", name, filename.c_str());
+		if (!file) return;
+		std::fprintf(file, "# %s, %d values, written by make dsp-golden\n", name, (int)render.size());
+		for (float value : render) std::fprintf(file, "%.9g\n", value);
+		std::fclose(file);
+		return;
+	}
+
+	FILE *file = std::fopen(filename.c_str(), "r");
+	DSP_CHECK(file, "%s: no reference at %s, run make dsp-golden", name, filename.c_str());
+	if (!file) return;
+	std::vector<float> reference;
+	char line[256];   // room for the header line of a long name
+	while (std::fgets(line, sizeof(line), file)) {
+		if (line[0] != '#') reference.push_back(std::strtof(line, NULL));
+	}
+	std::fclose(file);
+
+	DSP_CHECK(reference.size() == render.size(), "%s: %d values, the reference has %d", name, (int)render.size(), (int)reference.size());
+	size_t count = std::min(reference.size(), render.size());
+	int errors = 0;
+	float max_error = 0.f;
+	for (size_t i = 0; i < count; i++) {
+		float error = std::fabs(render[i] - reference[i]) / std::fmax(std::fabs(reference[i]), 1.f);
+		if (!(error <= golden_tolerance)) {   // also catches a nan
+			if (errors < 5) DSP_CHECK(false, "%s: value %d is %.9g, the reference is %.9g", name, (int)i, render[i], reference[i]);
+			errors++;
+		}
+		if (error > max_error) max_error = error;
+	}
+	std::printf("%s, %d values, max error %.3g\n", name, (int)count, max_error);
+}
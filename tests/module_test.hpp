@@ -0,0 +1,258 @@
+#pragma once
+#include <rack.hpp>
+#include "plugin.hpp"
+#include "gtgAudition.hpp"
+#include "gtgBus.hpp"
+#include "test_noise.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// patches of the plugin's modules on the headless engine in tests/rack, for make dsp-bench and the module golden tests
+// modules are found by slug and their params and ports by the names they were configured with, as a user sees them
+// each module gets its widget too, stepped at the ui frame rate, so meters are drained and Road walks its chains as in Rack
+
+static const float TEST_SAMPLE_RATE = 44100.f;
+static const int TEST_SOURCE_OUTPUTS = 16;
+static const int TEST_AUDIO_FRAMES = 1024;   // audio loops this often, short enough to stay in cache while timing
+
+inline Plugin &testPlugin() {
+	static Plugin plugin;
+	return plugin;
+}
+
+inline void initTestPlugin() {
+	init(&testPlugin());
+}
+
+// a typo in a test is a failed run, not a quiet patch to port 0
+inline void testFail(const std::string &message) {
+	std::printf("%s\n", message.c_str());
+	std::exit(1);
+}
+
+inline Model *findTestModel(const std::string &slug) {
+	Model *model = testPlugin().getModel(slug);
+	if (!model) testFail("no model " + slug);
+	return model;
+}
+
+// nth counts from 0 among params with the same name, like the two post fader buttons
+inline int findParam(Module *module, const std::string &name, int nth = 0) {
+	for (int i = 0; i < (int)module->paramQuantities.size(); i++) {
+		if (module->paramQuantities[i] && module->paramQuantities[i]->name == name && nth-- == 0) return i;
+	}
+	testFail(module->model->slug + " has no param " + name);
+	return -1;
+}
+
+inline int findInput(Module *module, const std::string &name) {
+	for (int i = 0; i < (int)module->inputInfos.size(); i++) {
+		if (module->inputInfos[i] && module->inputInfos[i]->name == name) return i;
+	}
+	testFail(module->model->slug + " has no input " + name);
+	return -1;
+}
+
+inline int findOutput(Module *module, const std::string &name) {
+	for (int i = 0; i < (int)module->outputInfos.size(); i++) {
+		if (module->outputInfos[i] && module->outputInfos[i]->name == name) return i;
+	}
+	testFail(module->model->slug + " has no output " + name);
+	return -1;
+}
+
+// one saved setting loaded into a module, as a patch would load it
+inline void setModuleData(Module *module, const char *key, json_t *valueJ) {
+	json_t *rootJ = json_object();
+	json_object_set_new(rootJ, key, valueJ);
+	module->dataFromJson(rootJ);
+	json_decref(rootJ);
+}
+
+// test signals on the source outputs and on params of other modules
+// audio loops a table, a different tone with noise on every channel, the other shapes are worked out per sample
+struct TestSignal {
+	enum Shapes {
+		SILENT,
+		AUDIO,
+		GATE,   // amplitude for width samples of every period
+		TRIANGLE,   // offset plus or minus amplitude, over period samples
+		CONSTANT
+	};
+
+	int shape = SILENT;
+	int channels = 1;
+	float amplitude = 5.f;
+	float offset = 0.f;
+	int period = 44100;
+	int width = 1;
+	int phase = 0;   // samples into the period at frame 0
+
+	float value(float (*audio)[16], int64_t frame, int c) const {
+		int64_t t = frame + phase;
+		switch (shape) {
+		default:
+		case SILENT:
+			return 0.f;
+		case AUDIO:
+			return audio[t & (TEST_AUDIO_FRAMES - 1)][c] * amplitude;
+		case GATE:
+			return ((t % period) < width) ? amplitude : 0.f;
+		case TRIANGLE: {
+			float position = (float)(t % period) / period;
+			return offset + (amplitude * ((position < 0.5f) ? (4.f * position) - 1.f : 3.f - (4.f * position)));
+		}
+		case CONSTANT:
+			return offset;
+		}
+	}
+};
+
+struct TestSource : Module {
+	struct ParamLane {
+		Module *module;
+		int param_id;
+		TestSignal signal;
+	};
+
+	TestSignal signals[TEST_SOURCE_OUTPUTS];
+	std::vector<ParamLane> param_lanes;
+	float audio[TEST_AUDIO_FRAMES][16];
+	int next_output = 0;
+
+	TestSource() {
+		config(0, 0, TEST_SOURCE_OUTPUTS, 0);
+		for (int i = 0; i < TEST_SOURCE_OUTPUTS; i++) {
+			configOutput(i, "Test signal " + std::to_string(i + 1));
+		}
+		TestNoise noise;
+		for (int t = 0; t < TEST_AUDIO_FRAMES; t++) {
+			for (int c = 0; c < 16; c++) {
+				float tone = std::sin(2.f * (float)M_PI * (c + 3) * t / TEST_AUDIO_FRAMES);   // whole cycles, so the loop is seamless
+				audio[t][c] = (0.8f * tone) + (0.2f * noise.next());
+			}
+		}
+	}
+
+	// the next free output playing the signal
+	int addSignal(const TestSignal &signal) {
+		if (next_output >= TEST_SOURCE_OUTPUTS) testFail("test source outputs used up");
+		signals[next_output] = signal;
+		return next_output++;
+	}
+
+	// a hand on a param of another module, moved before that module processes each sample
+	void addParamLane(Module *module, int param_id, const TestSignal &signal) {
+		param_lanes.push_back(ParamLane{module, param_id, signal});
+	}
+
+	void process(const ProcessArgs &args) override {
+		for (int i = 0; i < next_output; i++) {
+			const TestSignal &signal = signals[i];
+			for (int c = 0; c < signal.channels; c++) {
+				outputs[i].setVoltage(signal.value(audio, args.frame, c), c);
+			}
+			outputs[i].setChannels(signal.channels);
+		}
+		for (ParamLane &lane : param_lanes) {
+			lane.module->params[lane.param_id].setValue(lane.signal.value(audio, args.frame, 0));
+		}
+	}
+};
+
+// a patch on the headless engine, with a test source added first so it runs before the modules it feeds
+// the patch owns its modules, widgets and cables, and leaves the engine empty with auditions stopped
+struct TestPatch {
+	engine::Engine *engine;
+	TestSource *source;
+	std::vector<Module*> modules;
+	std::vector<ModuleWidget*> widgets;
+	std::vector<engine::Cable*> cables;
+	int ui_frames;
+	int ui_position = 0;
+
+	TestPatch(float sample_rate = TEST_SAMPLE_RATE) {
+		engine = APP->engine;
+		engine->setSampleRate(sample_rate);
+		ui_frames = (int)(sample_rate / 60.f);
+		source = new TestSource;
+		modules.push_back(source);
+		engine->addModule(source);
+	}
+
+	~TestPatch() {
+		engine->clear();
+		for (engine::Cable *cable : cables) delete cable;
+		for (ModuleWidget *widget : widgets) delete widget;
+		for (Module *module : modules) delete module;
+		for (int kind = 0; kind < NUM_AUDITION_KINDS; kind++) {
+			for (int group = 0; group < AUDITION_GROUPS; group++) {
+				auditions.stop(kind, group);
+			}
+		}
+	}
+
+	Module *add(const std::string &slug) {
+		Model *model = findTestModel(slug);
+		Module *module = model->createModule();
+		modules.push_back(module);
+		engine->addModule(module);
+		widgets.push_back(model->createModuleWidget(module));
+		return module;
+	}
+
+	// side by side in the rack, the engine links their expanders on the next block
+	void touch(Module *left, Module *right) {
+		left->rightExpander.moduleId = right->id;
+		right->leftExpander.moduleId = left->id;
+	}
+
+	void connect(Module *output_module, int output_id, Module *input_module, int input_id) {
+		engine::Cable *cable = new engine::Cable;
+		cable->outputModule = output_module;
+		cable->outputId = output_id;
+		cable->inputModule = input_module;
+		cable->inputId = input_id;
+		cables.push_back(cable);
+		engine->addCable(cable);
+	}
+
+	// a test signal to an input of a module, returns the source output
+	int feed(const TestSignal &signal, Module *module, int input_id) {
+		int output = source->addSignal(signal);
+		connect(source, output, module, input_id);
+		return output;
+	}
+
+	void stepWidgets() {
+		for (ModuleWidget *widget : widgets) widget->step();
+	}
+
+	// runs the engine with a ui frame between blocks, so blocks end on ui frames
+	void run(int frames) {
+		while (frames > 0) {
+			int block = std::min(frames, ui_frames - ui_position);
+			engine->stepBlock(block);
+			frames -= block;
+			ui_position += block;
+			if (ui_position >= ui_frames) {
+				ui_position = 0;
+				stepWidgets();
+			}
+		}
+	}
+
+	void runSeconds(float seconds) {
+		run((int)(seconds * engine->getSampleRate()));
+	}
+
+	// holds a button down and lets go, a long press past 0.7 seconds auditions
+	void press(Module *module, int param_id, float seconds = 0.05f) {
+		module->params[param_id].setValue(1.f);
+		runSeconds(seconds);
+		module->params[param_id].setValue(0.f);
+		runSeconds(0.01f);
+	}
+};
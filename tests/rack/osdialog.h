@@ -0,0 +1,17 @@
+#pragma once
+
+// headless stand-in for osdialog, the harnesses never open a dialog, see rack.cpp
+
+typedef enum {
+	OSDIALOG_OPEN,
+	OSDIALOG_OPEN_DIR,
+	OSDIALOG_SAVE
+} osdialog_file_action;
+
+typedef struct osdialog_filters osdialog_filters;
+
+extern "C" {
+osdialog_filters *osdialog_filters_parse(const char *str);
+void osdialog_filters_free(osdialog_filters *filters);
+char *osdialog_file(osdialog_file_action action, const char *dir, const char *filename, const osdialog_filters *filters);
+}
@@ -0,0 +1,490 @@
+#include <rack.hpp>
+#include <osdialog.h>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <map>
+
+// definitions for the headless stand-in in rack.hpp
+
+
+// json values, reference counted like jansson, objects keep their keys sorted
+enum JsonType {
+	JSON_OBJECT,
+	JSON_ARRAY,
+	JSON_STRING,
+	JSON_INTEGER,
+	JSON_REAL,
+	JSON_TRUE,
+	JSON_FALSE,
+	JSON_NULL
+};
+
+struct json_t {
+	JsonType type;
+	int refcount = 1;
+	long long integer = 0;
+	double real = 0.0;
+	std::string text;
+	std::map<std::string, json_t*> object;
+	std::vector<json_t*> array;
+
+	json_t(JsonType type) : type(type) {}
+};
+
+json_t *json_object() {return new json_t(JSON_OBJECT);}
+json_t *json_array() {return new json_t(JSON_ARRAY);}
+json_t *json_null() {return new json_t(JSON_NULL);}
+json_t *json_true() {return new json_t(JSON_TRUE);}
+json_t *json_false() {return new json_t(JSON_FALSE);}
+json_t *json_boolean(bool value) {return value ? json_true() : json_false();}
+
+json_t *json_integer(long long value) {
+	json_t *json = new json_t(JSON_INTEGER);
+	json->integer = value;
+	return json;
+}
+
+json_t *json_real(double value) {
+	json_t *json = new json_t(JSON_REAL);
+	json->real = value;
+	return json;
+}
+
+json_t *json_string(const char *value) {
+	if (!value) return NULL;
+	json_t *json = new json_t(JSON_STRING);
+	json->text = value;
+	return json;
+}
+
+json_t *json_incref(json_t *json) {
+	if (json) json->refcount++;
+	return json;
+}
+
+void json_decref(json_t *json) {
+	if (!json || --json->refcount > 0) return;
+	for (auto &member : json->object) json_decref(member.second);
+	for (json_t *item : json->array) json_decref(item);
+	delete json;
+}
+
+json_t *json_deep_copy(const json_t *json) {
+	if (!json) return NULL;
+	json_t *copy = new json_t(json->type);
+	copy->integer = json->integer;
+	copy->real = json->real;
+	copy->text = json->text;
+	for (auto &member : json->object) copy->object[member.first] = json_deep_copy(member.second);
+	for (json_t *item : json->array) copy->array.push_back(json_deep_copy(item));
+	return copy;
+}
+
+int json_object_set_new(json_t *object, const char *key, json_t *value) {
+	if (!object || object->type != JSON_OBJECT || !value) {
+		json_decref(value);
+		return -1;
+	}
+	json_t *&member = object->object[key];
+	json_decref(member);
+	member = value;
+	return 0;
+}
+
+json_t *json_object_get(const json_t *object, const char *key) {
+	if (!object || object->type != JSON_OBJECT) return NULL;
+	auto member = object->object.find(key);
+	return (member == object->object.end()) ? NULL : member->second;
+}
+
+int json_array_append_new(json_t *array, json_t *value) {
+	if (!array || array->type != JSON_ARRAY || !value) {
+		json_decref(value);
+		return -1;
+	}
+	array->array.push_back(value);
+	return 0;
+}
+
+json_t *json_array_get(const json_t *array, size_t index) {
+	if (!array || array->type != JSON_ARRAY || index >= array->array.size()) return NULL;
+	return array->array[index];
+}
+
+size_t json_array_size(const json_t *array) {
+	return (array && array->type == JSON_ARRAY) ? array->array.size() : 0;
+}
+
+// as in jansson, an integer reads 0 as a real and a real reads 0 as an integer
+long long json_integer_value(const json_t *json) {
+	return (json && json->type == JSON_INTEGER) ? json->integer : 0;
+}
+
+double json_real_value(const json_t *json) {
+	return (json && json->type == JSON_REAL) ? json->real : 0.0;
+}
+
+double json_number_value(const json_t *json) {
+	if (!json) return 0.0;
+	if (json->type == JSON_INTEGER) return (double)json->integer;
+	if (json->type == JSON_REAL) return json->real;
+	return 0.0;
+}
+
+const char *json_string_value(const json_t *json) {
+	return (json && json->type == JSON_STRING) ? json->text.c_str() : NULL;
+}
+
+bool json_is_true(const json_t *json) {
+	return json && json->type == JSON_TRUE;
+}
+
+static void dumpJson(const json_t *json, std::string &out) {
+	switch (json->type) {
+	case JSON_OBJECT: {
+		out += "{";
+		bool first = true;
+		for (auto &member : json->object) {
+			if (!first) out += ", ";
+			first = false;
+			out += "\"" + member.first + "\": ";
+			dumpJson(member.second, out);
+		}
+		out += "}";
+	} break;
+	case JSON_ARRAY: {
+		out += "[";
+		for (size_t i = 0; i < json->array.size(); i++) {
+			if (i > 0) out += ", ";
+			dumpJson(json->array[i], out);
+		}
+		out += "]";
+	} break;
+	case JSON_STRING: out += "\"" + json->text + "\""; break;
+	case JSON_INTEGER: out += string::f("%lld", json->integer); break;
+	case JSON_REAL: out += string::f("%.9g", json->real); break;
+	case JSON_TRUE: out += "true"; break;
+	case JSON_FALSE: out += "false"; break;
+	case JSON_NULL: out += "null"; break;
+	}
+}
+
+char *json_dumps(const json_t *json, size_t) {
+	if (!json) return NULL;
+	std::string out;
+	dumpJson(json, out);
+	char *text = (char*)std::malloc(out.size() + 1);
+	std::memcpy(text, out.c_str(), out.size() + 1);
+	return text;
+}
+
+int json_dumpf(const json_t *json, FILE *file, size_t flags) {
+	char *text = json_dumps(json, flags);
+	if (!text) return -1;
+	int result = (std::fputs(text, file) >= 0) ? 0 : -1;
+	std::free(text);
+	return result;
+}
+
+// the harnesses have no user folder, so there is never a file to read
+json_t *json_loadf(FILE *, size_t, json_error_t *error) {
+	if (error) {
+		error->line = 0;
+		std::snprintf(error->text, sizeof(error->text), "json files are not read headless");
+	}
+	return NULL;
+}
+
+
+namespace rack {
+
+std::string string::f(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list args_copy;
+	va_copy(args_copy, args);
+	int size = std::vsnprintf(NULL, 0, format, args_copy);
+	va_end(args_copy);
+	std::string text(size > 0 ? size : 0, '\0');
+	if (size > 0) std::vsnprintf(&text[0], size + 1, format, args);
+	va_end(args);
+	return text;
+}
+
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string string::toBase64(const uint8_t *data, size_t length) {
+	std::string text;
+	for (size_t i = 0; i < length; i += 3) {
+		uint32_t block = data[i] << 16;
+		if (i + 1 < length) block |= data[i + 1] << 8;
+		if (i + 2 < length) block |= data[i + 2];
+		text += base64_chars[(block >> 18) & 63];
+		text += base64_chars[(block >> 12) & 63];
+		text += (i + 1 < length) ? base64_chars[(block >> 6) & 63] : '=';
+		text += (i + 2 < length) ? base64_chars[block & 63] : '=';
+	}
+	return text;
+}
+
+std::vector<uint8_t> string::fromBase64(const std::string &text) {
+	std::vector<uint8_t> data;
+	uint32_t block = 0;
+	int bits = 0;
+	for (char c : text) {
+		const char *found = std::strchr(base64_chars, c);
+		if (c == '\0' || !found) continue;   // padding and anything else
+		block = (block << 6) | (uint32_t)(found - base64_chars);
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			data.push_back((block >> bits) & 0xff);
+		}
+	}
+	return data;
+}
+
+std::string system::getDirectory(const std::string &path) {
+	size_t slash = path.find_last_of('/');
+	return (slash == std::string::npos) ? "" : path.substr(0, slash);
+}
+
+std::string system::getFilename(const std::string &path) {
+	size_t slash = path.find_last_of('/');
+	return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+std::string system::getExtension(const std::string &path) {
+	std::string filename = getFilename(path);
+	size_t dot = filename.find_last_of('.');
+	return (dot == std::string::npos) ? "" : filename.substr(dot);
+}
+
+double system::getTime() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool settings::preferDarkPanels = false;
+
+// an empty user path, so plugin defaults are neither read nor written
+std::string asset::plugin(Plugin *, const std::string &filename) {return filename;}
+std::string asset::user(const std::string &) {return "";}
+std::string asset::system(const std::string &filename) {return filename;}
+
+static engine::Engine headless_engine;
+static Window headless_window;
+static App headless_app;
+
+App *appGet() {
+	headless_app.engine = &headless_engine;
+	headless_app.window = &headless_window;
+	return &headless_app;
+}
+
+
+namespace engine {
+
+Module *Engine::getModule(int64_t module_id) {
+	for (Module *module : modules) {
+		if (module->id == module_id) return module;
+	}
+	return NULL;
+}
+
+std::vector<int64_t> Engine::getModuleIds() {
+	std::vector<int64_t> ids;
+	for (Module *module : modules) ids.push_back(module->id);
+	return ids;
+}
+
+Cable *Engine::getCable(int64_t cable_id) {
+	for (Cable *cable : cables) {
+		if (cable->id == cable_id) return cable;
+	}
+	return NULL;
+}
+
+std::vector<int64_t> Engine::getCableIds() {
+	std::vector<int64_t> ids;
+	for (Cable *cable : cables) ids.push_back(cable->id);
+	return ids;
+}
+
+void Engine::addModule(Module *module) {
+	if (module->id < 0) module->id = next_id++;
+	modules.push_back(module);
+	Module::AddEvent add_event;
+	module->onAdd(add_event);
+	Module::SampleRateChangeEvent rate_event;
+	rate_event.sampleRate = sample_rate;
+	rate_event.sampleTime = 1.f / sample_rate;
+	module->onSampleRateChange(rate_event);
+}
+
+// takes the module's cables with it
+void Engine::removeModule(Module *module) {
+	std::vector<Cable*> attached;
+	for (Cable *cable : cables) {
+		if (cable->inputModule == module || cable->outputModule == module) attached.push_back(cable);
+	}
+	for (Cable *cable : attached) removeCable(cable);
+	Module::RemoveEvent remove_event;
+	module->onRemove(remove_event);
+	modules.erase(std::remove(modules.begin(), modules.end(), module), modules.end());
+	for (Module *other : modules) {
+		if (other->leftExpander.module == module) updateExpander(other, other->leftExpander, 0);
+		if (other->rightExpander.module == module) updateExpander(other, other->rightExpander, 1);
+	}
+}
+
+void Engine::resetModule(Module *module) {
+	Module::ResetEvent reset_event;
+	module->onReset(reset_event);
+}
+
+void Engine::bypassModule(Module *module, bool bypass) {
+	module->bypassed = bypass;
+}
+
+static bool isInputConnected(const std::vector<Cable*> &cables, Module *module, int input_id) {
+	for (Cable *cable : cables) {
+		if (cable->inputModule == module && cable->inputId == input_id) return true;
+	}
+	return false;
+}
+
+static bool isOutputConnected(const std::vector<Cable*> &cables, Module *module, int output_id) {
+	for (Cable *cable : cables) {
+		if (cable->outputModule == module && cable->outputId == output_id) return true;
+	}
+	return false;
+}
+
+// a newly connected port has 1 channel until the output sets its count, as in Rack
+void Engine::addCable(Cable *cable) {
+	bool output_was_connected = isOutputConnected(cables, cable->outputModule, cable->outputId);
+	if (cable->id < 0) cable->id = next_id++;
+	cables.push_back(cable);
+	Output &output = cable->outputModule->outputs[cable->outputId];
+	Input &input = cable->inputModule->inputs[cable->inputId];
+	if (!output_was_connected) {
+		output.channels = 1;
+		Module::PortChangeEvent port_event;
+		port_event.connecting = true;
+		port_event.type = Port::OUTPUT;
+		port_event.portId = cable->outputId;
+		cable->outputModule->onPortChange(port_event);
+	}
+	input.channels = 1;
+	Module::PortChangeEvent port_event;
+	port_event.connecting = true;
+	port_event.type = Port::INPUT;
+	port_event.portId = cable->inputId;
+	cable->inputModule->onPortChange(port_event);
+}
+
+void Engine::removeCable(Cable *cable) {
+	cables.erase(std::remove(cables.begin(), cables.end(), cable), cables.end());
+	Input &input = cable->inputModule->inputs[cable->inputId];
+	if (!isInputConnected(cables, cable->inputModule, cable->inputId)) {
+		for (int c = 0; c < 16; c++) input.voltages[c] = 0.f;
+		input.channels = 0;
+		Module::PortChangeEvent port_event;
+		port_event.connecting = false;
+		port_event.type = Port::INPUT;
+		port_event.portId = cable->inputId;
+		cable->inputModule->onPortChange(port_event);
+	}
+	Output &output = cable->outputModule->outputs[cable->outputId];
+	if (!isOutputConnected(cables, cable->outputModule, cable->outputId)) {
+		output.channels = 0;
+		Module::PortChangeEvent port_event;
+		port_event.connecting = false;
+		port_event.type = Port::OUTPUT;
+		port_event.portId = cable->outputId;
+		cable->outputModule->onPortChange(port_event);
+	}
+}
+
+void Engine::setSampleRate(float new_sample_rate) {
+	sample_rate = new_sample_rate;
+	Module::SampleRateChangeEvent rate_event;
+	rate_event.sampleRate = sample_rate;
+	rate_event.sampleTime = 1.f / sample_rate;
+	for (Module *module : modules) module->onSampleRateChange(rate_event);
+}
+
+// removes every module and cable, without deleting them
+void Engine::clear() {
+	while (!cables.empty()) removeCable(cables.back());
+	while (!modules.empty()) removeModule(modules.back());
+}
+
+void Engine::updateExpander(Module *module, Module::Expander &expander, uint8_t side) {
+	Module *touching = (expander.moduleId >= 0) ? getModule(expander.moduleId) : NULL;
+	if (touching == expander.module) return;
+	expander.module = touching;
+	Module::ExpanderChangeEvent expander_event;
+	expander_event.side = side;
+	module->onExpanderChange(expander_event);
+}
+
+void Engine::stepBlock(int frames) {
+	// flush denormals to zero on the engine thread, as Rack does before every block
+	_mm_setcsr(_mm_getcsr() | 0x8040);
+
+	for (Module *module : modules) {
+		updateExpander(module, module->leftExpander, 0);
+		updateExpander(module, module->rightExpander, 1);
+	}
+
+	Module::ProcessArgs args;
+	args.sampleRate = sample_rate;
+	args.sampleTime = 1.f / sample_rate;
+	for (int i = 0; i < frames; i++) {
+		for (Module *module : modules) {
+			if (module->leftExpander.messageFlipRequested) {
+				std::swap(module->leftExpander.producerMessage, module->leftExpander.consumerMessage);
+				module->leftExpander.messageFlipRequested = false;
+			}
+			if (module->rightExpander.messageFlipRequested) {
+				std::swap(module->rightExpander.producerMessage, module->rightExpander.consumerMessage);
+				module->rightExpander.messageFlipRequested = false;
+			}
+		}
+
+		// the input takes the output's channel count, and a non-finite voltage arrives as 0 V
+		for (Cable *cable : cables) {
+			Output &output = cable->outputModule->outputs[cable->outputId];
+			Input &input = cable->inputModule->inputs[cable->inputId];
+			int channels = output.channels;
+			for (int c = 0; c < channels; c++) {
+				float voltage = output.voltages[c];
+				input.voltages[c] = std::isfinite(voltage) ? voltage : 0.f;
+			}
+			for (int c = channels; c < input.channels; c++) {
+				input.voltages[c] = 0.f;
+			}
+			input.channels = channels;
+		}
+
+		args.frame = frame;
+		for (Module *module : modules) {
+			if (!module->bypassed) module->process(args);
+		}
+		frame++;
+	}
+}
+
+}   // namespace engine
+
+}   // namespace rack
+
+
+// no dialogs headless
+extern "C" {
+osdialog_filters *osdialog_filters_parse(const char *) {return NULL;}
+void osdialog_filters_free(osdialog_filters *) {}
+char *osdialog_file(osdialog_file_action, const char *, const char *, const osdialog_filters *) {return NULL;}
+}
@@ -0,0 +1,1005 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pmmintrin.h>
+
+// headless stand-in for the parts of the Rack 2 SDK the plugin uses, so the modules build and run without Rack
+// the engine, ports, params, expanders and json work like Rack's, widgets are built but never drawn
+// only for the harnesses in tests/, built with -Itests/rack in place of the SDK headers
+
+
+// json, the jansson calls the modules make, see rack.cpp
+typedef struct json_t json_t;
+typedef struct {
+	int line;
+	char text[160];
+} json_error_t;
+
+json_t *json_object();
+json_t *json_array();
+json_t *json_integer(long long value);
+json_t *json_real(double value);
+json_t *json_string(const char *value);
+json_t *json_null();
+json_t *json_true();
+json_t *json_false();
+json_t *json_boolean(bool value);
+json_t *json_incref(json_t *json);
+void json_decref(json_t *json);
+json_t *json_deep_copy(const json_t *json);
+int json_object_set_new(json_t *object, const char *key, json_t *value);
+json_t *json_object_get(const json_t *object, const char *key);
+int json_array_append_new(json_t *array, json_t *value);
+json_t *json_array_get(const json_t *array, size_t index);
+size_t json_array_size(const json_t *array);
+long long json_integer_value(const json_t *json);
+double json_real_value(const json_t *json);
+double json_number_value(const json_t *json);
+const char *json_string_value(const json_t *json);
+bool json_is_true(const json_t *json);
+char *json_dumps(const json_t *json, size_t flags);
+int json_dumpf(const json_t *json, FILE *file, size_t flags);
+json_t *json_loadf(FILE *file, size_t flags, json_error_t *error);
+
+#define JSON_INDENT(n) (n)
+#define JSON_REAL_PRECISION(n) 0
+#define json_array_foreach(array, index, value) for (index = 0; index < json_array_size(array) && (value = json_array_get(array, index)); index++)
+
+
+// nanovg, drawing is never called headless
+typedef struct NVGcontext NVGcontext;
+struct NVGcolor {
+	float r, g, b, a;
+};
+enum NVGalign {
+	NVG_ALIGN_LEFT = 1,
+	NVG_ALIGN_CENTER = 2,
+	NVG_ALIGN_RIGHT = 4
+};
+
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {return NVGcolor{r / 255.f, g / 255.f, b / 255.f, a / 255.f};}
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) {return nvgRGBA(r, g, b, 255);}
+inline NVGcolor nvgTransRGBAf(NVGcolor color, float a) {color.a *= a; return color;}
+inline void nvgBeginPath(NVGcontext *) {}
+inline void nvgRect(NVGcontext *, float, float, float, float) {}
+inline void nvgRoundedRect(NVGcontext *, float, float, float, float, float) {}
+inline void nvgFillColor(NVGcontext *, NVGcolor) {}
+inline void nvgFill(NVGcontext *) {}
+inline void nvgFontSize(NVGcontext *, float) {}
+inline void nvgFontFaceId(NVGcontext *, int) {}
+inline void nvgTextLetterSpacing(NVGcontext *, float) {}
+inline void nvgTextAlign(NVGcontext *, int) {}
+inline float nvgText(NVGcontext *, float x, float, const char *, const char *) {return x;}
+
+
+#define RACK_MOD_MASK 0xf
+#define RACK_MOD_CTRL 2
+#define RACK_GRID_WIDTH 15
+#define RACK_GRID_HEIGHT 380
+#define ENUMS(name, count) name, name##_LAST = name + (count) - 1
+#define CHECKMARK_STRING "✔"
+#define CHECKMARK(_cond) ((_cond) ? CHECKMARK_STRING : "")
+#define RIGHT_ARROW "▸"
+
+namespace rack {
+
+static const NVGcolor SCHEME_RED = {0xed / 255.f, 0x2c / 255.f, 0x24 / 255.f, 1.f};
+static const NVGcolor SCHEME_YELLOW = {1.f, 0xd7 / 255.f, 0x14 / 255.f, 1.f};
+static const NVGcolor SCHEME_GREEN = {0x90 / 255.f, 0xc7 / 255.f, 0x3e / 255.f, 1.f};
+
+namespace math {
+
+template <typename T>
+T clamp(T x, T a, T b) {
+	return std::max(std::min(x, b), a);
+}
+
+inline float rescale(float x, float x_min, float x_max, float y_min, float y_max) {
+	return y_min + (x - x_min) / (x_max - x_min) * (y_max - y_min);
+}
+
+inline float crossfade(float a, float b, float p) {
+	return a + (b - a) * p;
+}
+
+struct Vec {
+	float x = 0.f;
+	float y = 0.f;
+	Vec() {}
+	Vec(float x, float y) : x(x), y(y) {}
+	Vec plus(Vec b) const {return Vec(x + b.x, y + b.y);}
+	Vec minus(Vec b) const {return Vec(x - b.x, y - b.y);}
+	Vec mult(float s) const {return Vec(x * s, y * s);}
+	Vec div(float s) const {return Vec(x / s, y / s);}
+};
+
+struct Rect {
+	Vec pos;
+	Vec size;
+};
+
+}   // namespace math
+using namespace math;
+
+
+namespace string {
+std::string f(const char *format, ...);
+std::string toBase64(const uint8_t *data, size_t length);
+std::vector<uint8_t> fromBase64(const std::string &text);
+}
+
+namespace system {
+std::string getDirectory(const std::string &path);
+std::string getFilename(const std::string &path);
+std::string getExtension(const std::string &path);
+double getTime();
+}
+
+namespace settings {
+extern bool preferDarkPanels;
+}
+
+
+namespace simd {
+
+// float_4 as Rack defines it, on sse
+template <typename T, int N>
+struct Vector;
+
+template <>
+struct Vector<float, 4> {
+	using type = float;
+	constexpr static int size = 4;
+	union {
+		__m128 v;
+		float s[4];
+	};
+
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) {v = _mm_set1_ps(x);}
+	Vector(float x1, float x2, float x3, float x4) {v = _mm_setr_ps(x1, x2, x3, x4);}
+	static Vector zero() {return Vector(_mm_setzero_ps());}
+	static Vector mask() {return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1)));}
+	static Vector load(const float *x) {return Vector(_mm_loadu_ps(x));}
+	void store(float *x) {_mm_storeu_ps(x, v);}
+	float &operator[](int i) {return s[i];}
+	const float &operator[](int i) const {return s[i];}
+};
+
+typedef Vector<float, 4> float_4;
+
+inline float_4 operator+(float_4 a, float_4 b) {return _mm_add_ps(a.v, b.v);}
+inline float_4 operator-(float_4 a, float_4 b) {return _mm_sub_ps(a.v, b.v);}
+inline float_4 operator*(float_4 a, float_4 b) {return _mm_mul_ps(a.v, b.v);}
+inline float_4 operator/(float_4 a, float_4 b) {return _mm_div_ps(a.v, b.v);}
+inline float_4 operator-(float_4 a) {return _mm_sub_ps(_mm_setzero_ps(), a.v);}
+inline float_4 &operator+=(float_4 &a, float_4 b) {return a = a + b;}
+inline float_4 &operator-=(float_4 &a, float_4 b) {return a = a - b;}
+inline float_4 &operator*=(float_4 &a, float_4 b) {return a = a * b;}
+inline float_4 &operator/=(float_4 &a, float_4 b) {return a = a / b;}
+inline float_4 operator>(float_4 a, float_4 b) {return _mm_cmpgt_ps(a.v, b.v);}
+inline float_4 operator<(float_4 a, float_4 b) {return _mm_cmplt_ps(a.v, b.v);}
+inline float_4 operator>=(float_4 a, float_4 b) {return _mm_cmpge_ps(a.v, b.v);}
+inline float_4 operator<=(float_4 a, float_4 b) {return _mm_cmple_ps(a.v, b.v);}
+inline float_4 operator==(float_4 a, float_4 b) {return _mm_cmpeq_ps(a.v, b.v);}
+inline float_4 operator!=(float_4 a, float_4 b) {return _mm_cmpneq_ps(a.v, b.v);}
+inline float_4 operator&(float_4 a, float_4 b) {return _mm_and_ps(a.v, b.v);}
+inline float_4 operator|(float_4 a, float_4 b) {return _mm_or_ps(a.v, b.v);}
+inline float_4 operator^(float_4 a, float_4 b) {return _mm_xor_ps(a.v, b.v);}
+inline float_4 fmin(float_4 a, float_4 b) {return _mm_min_ps(a.v, b.v);}
+inline float_4 fmax(float_4 a, float_4 b) {return _mm_max_ps(a.v, b.v);}
+inline float_4 sqrt(float_4 a) {return _mm_sqrt_ps(a.v);}
+inline float_4 fabs(float_4 a) {return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v);}
+inline float_4 clamp(float_4 x, float_4 a, float_4 b) {return fmin(fmax(x, a), b);}
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) {return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));}
+inline int movemask(float_4 a) {return _mm_movemask_ps(a.v);}
+
+}   // namespace simd
+
+
+namespace dsp {
+
+struct ClockDivider {
+	uint32_t clock = 0;
+	uint32_t division = 1;
+	void reset() {clock = 0;}
+	void setDivision(uint32_t d) {division = d;}
+	uint32_t getDivision() {return division;}
+	uint32_t getClock() {return clock;}
+	bool process() {
+		clock++;
+		if (clock >= division) {
+			clock = 0;
+			return true;
+		}
+		return false;
+	}
+};
+
+struct SchmittTrigger {
+	bool state = true;
+	void reset() {state = true;}
+	bool process(float in, float low_threshold = 0.f, float high_threshold = 1.f) {
+		if (state) {
+			if (in <= low_threshold) state = false;
+		} else if (in >= high_threshold) {
+			state = true;
+			return true;
+		}
+		return false;
+	}
+	bool isHigh() {return state;}
+};
+
+struct BooleanTrigger {
+	bool state = true;
+	void reset() {state = true;}
+	bool process(bool new_state) {
+		bool triggered = new_state && !state;
+		state = new_state;
+		return triggered;
+	}
+};
+
+inline float amplitudeToDb(float amplitude) {return 20.f * std::log10(amplitude);}
+inline float dbToAmplitude(float db) {return std::pow(10.f, db / 20.f);}
+
+}   // namespace dsp
+
+
+// ports, params and lights, as the engine leaves them for process()
+struct Port {
+	union {
+		float voltages[16] = {};
+		float value;
+	};
+	uint8_t channels = 0;
+
+	enum Type {
+		INPUT,
+		OUTPUT
+	};
+
+	void setVoltage(float voltage, int channel = 0) {voltages[channel] = voltage;}
+	float getVoltage(int channel = 0) {return voltages[channel];}
+	float getPolyVoltage(int channel) {return isMonophonic() ? getVoltage(0) : getVoltage(channel);}
+	float getNormalVoltage(float normal, int channel = 0) {return isConnected() ? getVoltage(channel) : normal;}
+	float getNormalPolyVoltage(float normal, int channel) {return isConnected() ? getPolyVoltage(channel) : normal;}
+	float *getVoltages(int first_channel = 0) {return &voltages[first_channel];}
+	void readVoltages(float *v) {for (int c = 0; c < channels; c++) v[c] = voltages[c];}
+	void writeVoltages(const float *v) {for (int c = 0; c < channels; c++) voltages[c] = v[c];}
+	void clearVoltages() {for (int c = 0; c < channels; c++) voltages[c] = 0.f;}
+
+	float getVoltageSum() {
+		float sum = 0.f;
+		for (int c = 0; c < channels; c++) sum += voltages[c];
+		return sum;
+	}
+
+	template <typename T>
+	T getVoltageSimd(int first_channel) {return T::load(&voltages[first_channel]);}
+	template <typename T>
+	T getPolyVoltageSimd(int first_channel) {return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(first_channel);}
+	template <typename T>
+	void setVoltageSimd(T voltage, int first_channel) {voltage.store(&voltages[first_channel]);}
+
+	// a disconnected port stays at 0 channels, as in Rack
+	void setChannels(int new_channels) {
+		if (channels == 0) return;
+		new_channels = std::max(std::min(new_channels, 16), 1);
+		for (int c = new_channels; c < std::min((int)channels, 16); c++) voltages[c] = 0.f;
+		channels = new_channels;
+	}
+
+	int getChannels() {return channels;}
+	bool isConnected() {return channels > 0;}
+	bool isMonophonic() {return channels == 1;}
+	bool isPolyphonic() {return channels > 1;}
+};
+
+struct Input : Port {};
+struct Output : Port {};
+
+struct Param {
+	float value = 0.f;
+	float getValue() {return value;}
+	void setValue(float new_value) {value = new_value;}
+};
+
+struct Light {
+	float value = 0.f;
+	void setBrightness(float brightness) {value = brightness;}
+	float getBrightness() {return value;}
+	void setBrightnessSmooth(float brightness, float delta_time, float lambda = 30.f) {value += (brightness - value) * lambda * delta_time;}
+	void setSmoothBrightness(float brightness, float delta_time) {setBrightnessSmooth(brightness, delta_time);}
+};
+
+struct Quantity {
+	virtual ~Quantity() {}
+	virtual void setValue(float) {}
+	virtual float getValue() {return 0.f;}
+	virtual float getMinValue() {return 0.f;}
+	virtual float getMaxValue() {return 1.f;}
+	virtual float getDefaultValue() {return 0.f;}
+	virtual float getDisplayValue() {return getValue();}
+	virtual void setDisplayValue(float display_value) {setValue(display_value);}
+	virtual std::string getDisplayValueString() {return string::f("%g", getDisplayValue());}
+	virtual std::string getLabel() {return "";}
+	virtual std::string getUnit() {return "";}
+};
+
+struct Module;
+
+struct ParamQuantity : Quantity {
+	Module *module = NULL;
+	int paramId = 0;
+	float minValue = 0.f;
+	float maxValue = 1.f;
+	float defaultValue = 0.f;
+	std::string name;
+	std::string unit;
+	std::string description;
+	float displayBase = 0.f;
+	float displayMultiplier = 1.f;
+	float displayOffset = 0.f;
+	int displayPrecision = 5;
+	bool resetEnabled = true;
+	bool randomizeEnabled = true;
+	bool snapEnabled = false;
+
+	void setValue(float value) override;
+	float getValue() override;
+	float getMinValue() override {return minValue;}
+	float getMaxValue() override {return maxValue;}
+	float getDefaultValue() override {return defaultValue;}
+	float getDisplayValue() override {return getValue() * displayMultiplier + displayOffset;}
+	std::string getLabel() override {return name;}
+	std::string getUnit() override {return unit;}
+	void reset() {setValue(defaultValue);}
+};
+
+struct PortInfo {
+	std::string name;
+	std::string description;
+};
+
+struct Model;
+
+namespace engine {
+struct Engine;
+}
+
+
+struct Module {
+	int64_t id = -1;
+	Model *model = NULL;
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+	std::vector<PortInfo*> inputInfos;
+	std::vector<PortInfo*> outputInfos;
+
+	// the modules touching on each side, placed by the harness and resolved by the engine each block
+	struct Expander {
+		int64_t moduleId = -1;
+		Module *module = NULL;
+		void *producerMessage = NULL;
+		void *consumerMessage = NULL;
+		bool messageFlipRequested = false;
+		void requestMessageFlip() {messageFlipRequested = true;}
+	};
+	Expander leftExpander;
+	Expander rightExpander;
+
+	struct ProcessArgs {
+		float sampleRate;
+		float sampleTime;
+		int64_t frame;
+	};
+	struct SampleRateChangeEvent {
+		float sampleRate;
+		float sampleTime;
+	};
+	struct PortChangeEvent {
+		bool connecting;
+		Port::Type type;
+		int portId;
+	};
+	struct ExpanderChangeEvent {
+		uint8_t side;
+	};
+	struct ResetEvent {};
+	struct AddEvent {};
+	struct RemoveEvent {};
+
+	virtual ~Module() {
+		for (ParamQuantity *quantity : paramQuantities) delete quantity;
+		for (PortInfo *info : inputInfos) delete info;
+		for (PortInfo *info : outputInfos) delete info;
+	}
+
+	void config(int num_params, int num_inputs, int num_outputs, int num_lights = 0) {
+		params.resize(num_params);
+		inputs.resize(num_inputs);
+		outputs.resize(num_outputs);
+		lights.resize(num_lights);
+		paramQuantities.resize(num_params, NULL);
+		inputInfos.resize(num_inputs, NULL);
+		outputInfos.resize(num_outputs, NULL);
+	}
+
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity *configParam(int param_id, float min_value, float max_value, float default_value, std::string name = "", std::string unit = "", float display_base = 0.f, float display_multiplier = 1.f, float display_offset = 0.f) {
+		delete paramQuantities[param_id];
+		TParamQuantity *quantity = new TParamQuantity;
+		quantity->ParamQuantity::module = this;
+		quantity->ParamQuantity::paramId = param_id;
+		quantity->ParamQuantity::minValue = min_value;
+		quantity->ParamQuantity::maxValue = max_value;
+		quantity->ParamQuantity::defaultValue = default_value;
+		quantity->ParamQuantity::name = name;
+		quantity->ParamQuantity::unit = unit;
+		quantity->ParamQuantity::displayBase = display_base;
+		quantity->ParamQuantity::displayMultiplier = display_multiplier;
+		quantity->ParamQuantity::displayOffset = display_offset;
+		paramQuantities[param_id] = quantity;
+		params[param_id].value = default_value;
+		return quantity;
+	}
+
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity *configButton(int param_id, std::string name = "") {
+		TParamQuantity *quantity = configParam<TParamQuantity>(param_id, 0.f, 1.f, 0.f, name);
+		quantity->randomizeEnabled = false;
+		return quantity;
+	}
+
+	template <class TSwitchQuantity = ParamQuantity>
+	TSwitchQuantity *configSwitch(int param_id, float min_value, float max_value, float default_value, std::string name = "", std::vector<std::string> = {}) {
+		TSwitchQuantity *quantity = configParam<TSwitchQuantity>(param_id, min_value, max_value, default_value, name);
+		quantity->snapEnabled = true;
+		return quantity;
+	}
+
+	PortInfo *configInput(int input_id, std::string name = "") {
+		delete inputInfos[input_id];
+		inputInfos[input_id] = new PortInfo;
+		inputInfos[input_id]->name = name;
+		return inputInfos[input_id];
+	}
+
+	PortInfo *configOutput(int output_id, std::string name = "") {
+		delete outputInfos[output_id];
+		outputInfos[output_id] = new PortInfo;
+		outputInfos[output_id]->name = name;
+		return outputInfos[output_id];
+	}
+
+	void configBypass(int, int) {}
+
+	bool bypassed = false;   // set through Engine::bypassModule()
+
+	int64_t getId() {return id;}
+	Model *getModel() {return model;}
+	bool isBypassed() {return bypassed;}
+	Expander &getLeftExpander() {return leftExpander;}
+	Expander &getRightExpander() {return rightExpander;}
+
+	virtual void process(const ProcessArgs &) {}
+	virtual json_t *dataToJson() {return NULL;}
+	virtual void dataFromJson(json_t *) {}
+
+	virtual void onSampleRateChange() {}
+	virtual void onSampleRateChange(const SampleRateChangeEvent &) {onSampleRateChange();}
+	virtual void onReset() {}
+	virtual void onReset(const ResetEvent &) {
+		for (ParamQuantity *quantity : paramQuantities) {
+			if (quantity && quantity->resetEnabled) quantity->reset();
+		}
+		onReset();
+	}
+	virtual void onAdd() {}
+	virtual void onAdd(const AddEvent &) {onAdd();}
+	virtual void onRemove() {}
+	virtual void onRemove(const RemoveEvent &) {onRemove();}
+	virtual void onPortChange(const PortChangeEvent &) {}
+	virtual void onExpanderChange(const ExpanderChangeEvent &) {}
+};
+
+inline void ParamQuantity::setValue(float value) {
+	if (!module) return;
+	value = clamp(value, minValue, maxValue);
+	if (snapEnabled) value = std::round(value);
+	module->params[paramId].setValue(value);
+}
+
+inline float ParamQuantity::getValue() {
+	return module ? module->params[paramId].getValue() : 0.f;
+}
+
+
+namespace engine {
+
+using rack::Module;
+
+struct Cable {
+	int64_t id = -1;
+	Module *inputModule = NULL;
+	int inputId = -1;
+	Module *outputModule = NULL;
+	int outputId = -1;
+};
+
+// the engine on the calling thread, modules are processed in the order they were added
+// each frame flips the expander messages, steps the cables, then processes the modules, as Rack 2 does
+// a bypassed module is not processed and its outputs keep their last voltages, there are no bypass routes
+struct Engine {
+	float sample_rate = 44100.f;
+	int64_t frame = 0;
+	int64_t next_id = 1;
+	std::vector<Module*> modules;
+	std::vector<Cable*> cables;
+
+	float getSampleRate() {return sample_rate;}
+	float getSampleTime() {return 1.f / sample_rate;}
+	int64_t getFrame() {return frame;}
+	Module *getModule(int64_t module_id);
+	std::vector<int64_t> getModuleIds();
+	Cable *getCable(int64_t cable_id);
+	std::vector<int64_t> getCableIds();
+
+	// the engine does not own modules or cables, remove them before deleting them
+	void addModule(Module *module);
+	void removeModule(Module *module);
+	void resetModule(Module *module);
+	void bypassModule(Module *module, bool bypass);
+	void addCable(Cable *cable);
+	void removeCable(Cable *cable);
+	void setSampleRate(float new_sample_rate);
+	void stepBlock(int frames);
+	void clear();
+
+private:
+	void updateExpander(Module *module, Module::Expander &expander, uint8_t side);
+};
+
+}   // namespace engine
+
+
+// widgets, built by the harness so the ui side of a module runs, never drawn
+struct Svg {};
+struct Font {
+	int handle = -1;
+};
+
+namespace event {
+struct Base {
+	void *context = NULL;
+};
+struct Action : Base {};
+struct Change : Base {};
+struct DoubleClick : Base {};
+}
+
+namespace widget {
+
+struct Widget {
+	Rect box;
+	Widget *parent = NULL;
+	std::list<Widget*> children;
+	bool visible = true;
+
+	struct DrawArgs {
+		NVGcontext *vg = NULL;
+		Rect clipBox;
+		void *fb = NULL;
+	};
+
+	virtual ~Widget() {
+		for (Widget *child : children) delete child;
+	}
+
+	void addChild(Widget *child) {
+		child->parent = this;
+		children.push_back(child);
+	}
+	void addChildBottom(Widget *child) {
+		child->parent = this;
+		children.push_front(child);
+	}
+	void removeChild(Widget *child) {
+		children.remove(child);
+		child->parent = NULL;
+	}
+	template <class T>
+	T *getAncestorOfType() {
+		for (Widget *w = parent; w; w = w->parent) {
+			T *ancestor = dynamic_cast<T*>(w);
+			if (ancestor) return ancestor;
+		}
+		return NULL;
+	}
+	void show() {visible = true;}
+	void hide() {visible = false;}
+	bool isVisible() {return visible;}
+
+	virtual void step() {
+		for (Widget *child : children) child->step();
+	}
+	virtual void draw(const DrawArgs &) {}
+	virtual void drawLayer(const DrawArgs &, int) {}
+	virtual void onChange(const event::Change &) {}
+	virtual void onAction(const event::Action &) {}
+	virtual void onDoubleClick(const event::DoubleClick &) {}
+};
+
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+
+struct FramebufferWidget : Widget {
+	bool dirty = true;
+	void setDirty(bool new_dirty = true) {dirty = new_dirty;}
+};
+
+struct SvgWidget : Widget {
+	std::shared_ptr<Svg> svg;
+	void setSvg(std::shared_ptr<Svg> new_svg) {svg = new_svg;}
+};
+
+}   // namespace widget
+using namespace widget;
+
+struct Window {
+	std::shared_ptr<Svg> loadSvg(const std::string &) {return std::make_shared<Svg>();}
+	std::shared_ptr<Font> loadFont(const std::string &) {return std::make_shared<Font>();}
+	int getMods() {return 0;}
+};
+
+struct App {
+	engine::Engine *engine = NULL;
+	Window *window = NULL;
+};
+
+App *appGet();
+#define APP rack::appGet()
+
+
+namespace ui {
+
+struct Menu;
+
+struct MenuEntry : OpaqueWidget {};
+
+struct MenuItem : MenuEntry {
+	std::string text;
+	std::string rightText;
+	bool disabled = false;
+	virtual Menu *createChildMenu() {return NULL;}
+};
+
+struct MenuLabel : MenuEntry {
+	std::string text;
+};
+
+struct MenuSeparator : MenuEntry {};
+
+struct Menu : OpaqueWidget {};
+
+struct Slider : OpaqueWidget {
+	Quantity *quantity = NULL;
+};
+
+struct Label : Widget {
+	std::string text;
+};
+
+}   // namespace ui
+using namespace ui;
+
+
+namespace app {
+
+struct SvgPanel : Widget {
+	FramebufferWidget *fb;
+	SvgWidget *sw;
+	SvgPanel() {
+		fb = new FramebufferWidget;
+		addChild(fb);
+		sw = new SvgWidget;
+		fb->addChild(sw);
+	}
+	void setBackground(std::shared_ptr<Svg> svg) {sw->setSvg(svg);}
+};
+
+struct ParamWidget : OpaqueWidget {
+	Module *module = NULL;
+	int paramId = 0;
+	ParamQuantity *getParamQuantity() {return module ? module->paramQuantities[paramId] : NULL;}
+};
+
+struct SvgSwitch : ParamWidget {
+	FramebufferWidget *fb;
+	SvgWidget *sw;
+	std::vector<std::shared_ptr<Svg>> frames;
+	bool momentary = false;
+	SvgSwitch() {
+		fb = new FramebufferWidget;
+		addChild(fb);
+		sw = new SvgWidget;
+		fb->addChild(sw);
+	}
+	void addFrame(std::shared_ptr<Svg> svg) {
+		frames.push_back(svg);
+		if (!sw->svg) sw->setSvg(svg);
+	}
+};
+
+struct SvgKnob : ParamWidget {
+	FramebufferWidget *fb;
+	SvgWidget *sw;
+	float minAngle = 0.f;
+	float maxAngle = 0.f;
+	float speed = 1.f;
+	bool snap = false;
+	SvgKnob() {
+		fb = new FramebufferWidget;
+		addChild(fb);
+		sw = new SvgWidget;
+		fb->addChild(sw);
+	}
+	void setSvg(std::shared_ptr<Svg> svg) {sw->setSvg(svg);}
+};
+
+struct PortWidget : OpaqueWidget {
+	Module *module = NULL;
+	int portId = 0;
+	Port::Type type = Port::INPUT;
+};
+
+struct SvgPort : PortWidget {
+	FramebufferWidget *fb;
+	SvgWidget *sw;
+	Widget *shadow;
+	SvgPort() {
+		fb = new FramebufferWidget;
+		addChild(fb);
+		shadow = new Widget;
+		fb->addChild(shadow);
+		sw = new SvgWidget;
+		fb->addChild(sw);
+	}
+	void setSvg(std::shared_ptr<Svg> svg) {sw->setSvg(svg);}
+};
+
+struct SvgScrew : Widget {
+	FramebufferWidget *fb;
+	SvgWidget *sw;
+	SvgScrew() {
+		fb = new FramebufferWidget;
+		addChild(fb);
+		sw = new SvgWidget;
+		fb->addChild(sw);
+	}
+	void setSvg(std::shared_ptr<Svg> svg) {sw->setSvg(svg);}
+};
+
+struct LightWidget : TransparentWidget {};
+
+struct ModuleLightWidget : LightWidget {
+	Module *module = NULL;
+	int firstLightId = 0;
+};
+
+template <typename TBase = ModuleLightWidget> struct TGrayModuleLightWidget : TBase {};
+template <typename TBase = ModuleLightWidget> struct TRedLight : TGrayModuleLightWidget<TBase> {};
+template <typename TBase = ModuleLightWidget> struct TGreenLight : TGrayModuleLightWidget<TBase> {};
+template <typename TBase = ModuleLightWidget> struct TYellowLight : TGrayModuleLightWidget<TBase> {};
+template <typename TBase = ModuleLightWidget> struct TWhiteLight : TGrayModuleLightWidget<TBase> {};
+template <typename TBase = ModuleLightWidget> struct TBlueLight : TGrayModuleLightWidget<TBase> {};
+template <typename TBase = ModuleLightWidget> struct TGreenRedLight : TGrayModuleLightWidget<TBase> {};
+typedef TRedLight<> RedLight;
+typedef TGreenLight<> GreenLight;
+typedef TYellowLight<> YellowLight;
+typedef TWhiteLight<> WhiteLight;
+typedef TBlueLight<> BlueLight;
+typedef TGreenRedLight<> GreenRedLight;
+template <typename TBase> struct TinyLight : TBase {};
+template <typename TBase> struct SmallLight : TBase {};
+template <typename TBase> struct MediumLight : TBase {};
+
+struct ModuleWidget : OpaqueWidget {
+	Model *model = NULL;
+	Module *module = NULL;
+	Widget *panel = NULL;
+
+	// the harness owns the module, unlike Rack where the widget deletes it
+	void setModule(Module *new_module) {module = new_module;}
+	Module *getModule() {return module;}
+	template <class TModule>
+	TModule *getModule() {return dynamic_cast<TModule*>(module);}
+
+	void setPanel(Widget *new_panel) {
+		if (panel) {
+			removeChild(panel);
+			delete panel;
+		}
+		panel = new_panel;
+		addChildBottom(panel);
+	}
+	void setPanel(std::shared_ptr<Svg> svg) {
+		SvgPanel *svg_panel = new SvgPanel;
+		svg_panel->setBackground(svg);
+		setPanel(svg_panel);
+	}
+	Widget *getPanel() {return panel;}
+
+	void addParam(ParamWidget *param) {addChild(param);}
+	void addInput(PortWidget *input) {addChild(input);}
+	void addOutput(PortWidget *output) {addChild(output);}
+
+	virtual void appendContextMenu(Menu *) {}
+};
+
+}   // namespace app
+using namespace app;
+
+
+struct Plugin;
+
+struct Model {
+	Plugin *plugin = NULL;
+	std::string slug;
+	virtual ~Model() {}
+	virtual Module *createModule() {return NULL;}
+	virtual ModuleWidget *createModuleWidget(Module *) {return NULL;}
+};
+
+struct Plugin {
+	std::vector<Model*> models;
+	~Plugin() {
+		for (Model *model : models) delete model;
+	}
+	void addModel(Model *model) {
+		model->plugin = this;
+		models.push_back(model);
+	}
+	Model *getModel(const std::string &slug) {
+		for (Model *model : models) {
+			if (model->slug == slug) return model;
+		}
+		return NULL;
+	}
+};
+
+template <class TModule, class TModuleWidget>
+Model *createModel(std::string slug) {
+	struct TModel : Model {
+		Module *createModule() override {
+			Module *module = new TModule;
+			module->model = this;
+			return module;
+		}
+		ModuleWidget *createModuleWidget(Module *module) override {
+			TModule *typed_module = module ? dynamic_cast<TModule*>(module) : NULL;
+			ModuleWidget *module_widget = new TModuleWidget(typed_module);
+			module_widget->model = this;
+			return module_widget;
+		}
+	};
+	TModel *model = new TModel;
+	model->slug = slug;
+	return model;
+}
+
+template <class TWidget>
+TWidget *createWidget(Vec pos) {
+	TWidget *o = new TWidget;
+	o->box.pos = pos;
+	return o;
+}
+
+template <class TWidget>
+TWidget *createWidgetCentered(Vec pos) {
+	return createWidget<TWidget>(pos);
+}
+
+template <class TParamWidget>
+TParamWidget *createParamCentered(Vec pos, Module *module, int param_id) {
+	TParamWidget *o = createWidget<TParamWidget>(pos);
+	o->module = module;
+	o->paramId = param_id;
+	return o;
+}
+
+template <class TPortWidget>
+TPortWidget *createInputCentered(Vec pos, Module *module, int input_id) {
+	TPortWidget *o = createWidget<TPortWidget>(pos);
+	o->module = module;
+	o->type = Port::INPUT;
+	o->portId = input_id;
+	return o;
+}
+
+template <class TPortWidget>
+TPortWidget *createOutputCentered(Vec pos, Module *module, int output_id) {
+	TPortWidget *o = createWidget<TPortWidget>(pos);
+	o->module = module;
+	o->type = Port::OUTPUT;
+	o->portId = output_id;
+	return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget *createLightCentered(Vec pos, Module *module, int first_light_id) {
+	TModuleLightWidget *o = createWidget<TModuleLightWidget>(pos);
+	o->module = module;
+	o->firstLightId = first_light_id;
+	return o;
+}
+
+template <class TMenuItem = MenuItem>
+TMenuItem *createMenuItem(std::string text, std::string right_text = "") {
+	TMenuItem *o = new TMenuItem;
+	o->text = text;
+	o->rightText = right_text;
+	return o;
+}
+
+inline MenuItem *createMenuItem(std::string text, std::string right_text, std::function<void()>, bool disabled = false) {
+	MenuItem *o = createMenuItem(text, right_text);
+	o->disabled = disabled;
+	return o;
+}
+
+inline MenuLabel *createMenuLabel(std::string text) {
+	MenuLabel *o = new MenuLabel;
+	o->text = text;
+	return o;
+}
+
+inline MenuItem *createBoolMenuItem(std::string text, std::string right_text, std::function<bool()>, std::function<void(bool)>, bool disabled = false) {
+	return createMenuItem(text, right_text, NULL, disabled);
+}
+
+inline MenuItem *createBoolPtrMenuItem(std::string text, std::string right_text, bool *) {
+	return createMenuItem(text, right_text);
+}
+
+inline MenuItem *createSubmenuItem(std::string text, std::string right_text, std::function<void(Menu*)>, bool disabled = false) {
+	return createMenuItem(text, right_text, NULL, disabled);
+}
+
+inline MenuItem *createIndexSubmenuItem(std::string text, std::vector<std::string>, std::function<size_t()>, std::function<void(size_t)>) {
+	return createMenuItem(text, RIGHT_ARROW);
+}
+
+inline Vec mm2px(Vec mm) {
+	return mm.mult(75.f / 25.4f);
+}
+
+namespace asset {
+std::string plugin(Plugin *plugin, const std::string &filename);
+std::string user(const std::string &filename);
+std::string system(const std::string &filename);
+}
+
+}   // namespace rack
+
+using namespace rack;
+
+extern "C" {
+void init(rack::Plugin *plugin);
+void destroy();
+}
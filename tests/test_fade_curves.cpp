@@ -0,0 +1,59 @@
+#include "gtgDSP.hpp"
+#include "dsp_test.hpp"
+
+// the fade curve tables against the exact curves, read through AutoFader::getCurveFade() as the mixers read them
+// the exponential curve is the std::pow(fade / gain, 2.5) fade it replaced, and it stays the default
+
+static double exactCurve(int curve, double x) {
+	switch (curve) {
+	default:
+	case FADE_CURVE_EXP: return std::pow(x, 2.5);
+	case FADE_CURVE_LOG: return 1.0 - std::pow(1.0 - x, 2.5);
+	case FADE_CURVE_S: return 0.5 - (0.5 * std::cos(x * M_PI));
+	case FADE_CURVE_EQUAL_POWER: return std::sin(x * M_PI_2);
+	case FADE_CURVE_LINEAR: return x;
+	}
+}
+
+int main() {
+	const int steps = 200000;
+	const double tolerance = 1e-5;   // as promised in gtgDSP.hpp
+	const float gains[3] = {1.f, 0.5f, 2.f};   // preamp gains scale the whole curve
+	const char *curve_names[NUM_FADE_CURVES] = {"exponential", "logarithmic", "s", "equal power", "linear"};
+
+	AutoFader fader;
+	DSP_CHECK(fader.getCurve() == FADE_CURVE_EXP, "the default fade curve is %d, not x^2.5", fader.getCurve());
+
+	for (int curve = 0; curve < NUM_FADE_CURVES; curve++) {
+		fader.setCurve(curve);
+		for (float gain : gains) {
+			fader.setGain(gain);
+			double max_error = 0.0;
+			double worst_x = 0.0;
+			for (int i = 0; i <= steps; i++) {
+				double x = (double)i / steps;
+				fader.fade = x * gain;
+				double error = std::fabs(fader.getCurveFade() - (exactCurve(curve, x) * gain)) / gain;
+				if (error > max_error) {
+					max_error = error;
+					worst_x = x;
+				}
+			}
+			std::printf("%s curve at gain %.1f, max error %.3g at %.5f\n", curve_names[curve], gain, max_error, worst_x);
+			DSP_CHECK(max_error < tolerance, "%s curve at gain %.1f is %.3g from exact at %.5f", curve_names[curve], gain, max_error, worst_x);
+		}
+
+		// ends are exact, so a finished fade is fully on or fully off
+		fader.setGain(1.f);
+		fader.fade = 0.f;
+		DSP_CHECK(fader.getCurveFade() == 0.f, "%s curve does not start at 0", curve_names[curve]);
+		fader.fade = 1.f;
+		DSP_CHECK(fader.getCurveFade() == 1.f, "%s curve does not end at 1", curve_names[curve]);
+	}
+
+	// curves out of range fall back to the nearest table
+	DSP_CHECK(getFadeCurveTables().getTable(-1) == getFadeCurveTables().getTable(FADE_CURVE_EXP), "curve -1 does not read the exponential table");
+	DSP_CHECK(getFadeCurveTables().getTable(NUM_FADE_CURVES) == getFadeCurveTables().getTable(FADE_CURVE_LINEAR), "curve past the last does not read the linear table");
+
+	return dspResult("test_fade_curves");
+}
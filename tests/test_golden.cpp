@@ -0,0 +1,121 @@
+#include "gtgDSP.hpp"
+#include "golden_test.hpp"
+#include "test_noise.hpp"
+#include <cstring>
+
+// renders the dsp into buffers and compares them with the reference output in tests/golden
+
+// every curve fading in and back out through processBlock, the fader turns around when the fade ends
+static std::vector<float> renderFader() {
+	std::vector<float> render;
+	for (int curve = 0; curve < NUM_FADE_CURVES; curve++) {
+		AutoFader fader;
+		fader.setSampleRate(44100.f);
+		fader.setGain(0.8f);
+		fader.setSpeed(26);
+		fader.setCurve(curve);
+		fader.on = false;
+		fader.fade = 0.f;
+		float gains[DSP_BLOCK_SIZE];
+		for (int b = 0; b < 160; b++) {
+			if (b == 2) fader.on = true;
+			if (b == 90) fader.on = false;
+			bool constant = fader.processBlock(gains, DSP_BLOCK_SIZE);
+			for (int i = 0; i < DSP_BLOCK_SIZE; i += golden_step) {
+				render.push_back(gains[constant ? 0 : i]);
+			}
+		}
+	}
+	return render;
+}
+
+// every pan law across a sweep, straight from panLevels and ramped through ConstantPan::levelsBlock
+static std::vector<float> renderPan() {
+	std::vector<float> render;
+	for (int law = 0; law < NUM_PAN_LAWS; law++) {
+		for (int i = 0; i <= 64; i++) {
+			float left, right;
+			panLevels(law, -1.25f + (2.5f * i / 64.f), left, right);
+			render.push_back(left);
+			render.push_back(right);
+		}
+		for (int smooth = 0; smooth < 2; smooth++) {
+			ConstantPan pan;
+			pan.setSampleRate(44100.f);
+			pan.setLaw(law);
+			float left[DSP_BLOCK_SIZE], right[DSP_BLOCK_SIZE];
+			for (int b = 0; b < 48; b++) {
+				float position = (b < 24) ? -1.f + (b / 12.f) : 0.7f;
+				bool constant = pan.levelsBlock(position, left, right, DSP_BLOCK_SIZE, smooth);
+				for (int i = 0; i < DSP_BLOCK_SIZE; i += golden_step) {
+					render.push_back(left[constant ? 0 : i]);
+					render.push_back(right[constant ? 0 : i]);
+				}
+			}
+		}
+	}
+	return render;
+}
+
+// the fade curve tables, read through the interpolation the faders use
+static std::vector<float> renderFadeTables() {
+	std::vector<float> render;
+	for (int curve = 0; curve < NUM_FADE_CURVES; curve++) {
+		AutoFader fader;
+		fader.setCurve(curve);
+		for (int i = 0; i <= 200; i++) {
+			fader.fade = i / 200.f;
+			render.push_back(fader.getCurveFade());
+		}
+	}
+	return render;
+}
+
+// noise through a delay that sweeps across whole and fractional delays, under one sample included
+static std::vector<float> renderDelay() {
+	std::vector<float> render;
+	static StereoDelayLine delay;
+	delay.setMaxDelay(64);
+	TestNoise noise;
+	for (int t = 0; t < 4096; t++) {
+		float frame[2] = {noise.next(), std::sin(t * 0.05f)};
+		float delay_samples = (t < 512) ? 3.f : 20.f + (20.f * std::sin(t * 0.003f));
+		delay.process(frame, frame, delay_samples);
+		if (t % golden_step == 0) {
+			render.push_back(frame[0]);
+			render.push_back(frame[1]);
+		}
+	}
+	return render;
+}
+
+// a quiet tone with louder bursts and a lone spike, limited to 5 V, the gain is kept with the channels
+static std::vector<float> renderLimiter() {
+	std::vector<float> render;
+	static LookAheadLimiter limiter;
+	limiter.setSampleRate(44100.f);
+	limiter.setCeiling(5.f);
+	TestNoise noise;
+	for (int t = 0; t < 8192; t++) {
+		float amplitude = ((t / 1024) & 1) ? 9.f : 3.f;
+		float channels[2] = {amplitude * std::sin(t * 0.02f), amplitude * 0.5f * noise.next()};
+		if (t == 6000) channels[1] = 12.f;
+		limiter.process(channels, 2, std::fmax(std::fabs(channels[0]), std::fabs(channels[1])));
+		if (t % golden_step == 0) {
+			render.push_back(channels[0]);
+			render.push_back(channels[1]);
+			render.push_back(limiter.getGain());
+		}
+	}
+	return render;
+}
+
+int main(int argc, char **argv) {
+	golden_updating = (argc > 1 && std::strcmp(argv[1], "--update") == 0);
+	compareGolden("fader", renderFader());
+	compareGolden("pan", renderPan());
+	compareGolden("fade_tables", renderFadeTables());
+	compareGolden("stereo_delay", renderDelay());
+	compareGolden("limiter", renderLimiter());
+	return dspResult(golden_updating ? "test_golden, references written" : "test_golden");
+}
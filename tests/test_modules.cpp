@@ -0,0 +1,376 @@
+#include "module_test.hpp"
+#include "golden_test.hpp"
+#include <cstring>
+
+// renders whole modules through process() on the headless engine and compares them with the reference output in tests/golden
+// every render is a fixed patch at 44100 Hz: test audio in, buttons pressed and knobs moved at fixed times
+// outputs are kept every module_golden_step samples, all of a bus cable's channels so its layout is compared too
+
+static const int module_golden_step = 8 * golden_step;   // module renders are long, so fewer samples than the dsp renders
+
+struct GoldenProbe {
+	Module *module;
+	int output;
+	int channels;
+};
+
+// a patch being rendered, only the time spent in record() and the presses is kept
+struct GoldenRender {
+	TestPatch &patch;
+	std::vector<GoldenProbe> probes;
+	std::vector<float> values;
+
+	GoldenRender(TestPatch &test_patch) : patch(test_patch) {}
+
+	void probe(Module *module, int output, int channels) {
+		probes.push_back(GoldenProbe{module, output, channels});
+	}
+
+	void record(float seconds) {
+		int frames = (int)(seconds * TEST_SAMPLE_RATE);
+		for (int i = 0; i < frames; i += module_golden_step) {
+			patch.run(module_golden_step);
+			for (const GoldenProbe &probe : probes) {
+				for (int c = 0; c < probe.channels; c++) {
+					values.push_back(probe.module->outputs[probe.output].getVoltage(c));
+				}
+			}
+		}
+	}
+
+	// a button held for seconds and let go, recorded throughout
+	void press(Module *module, int param_id, float seconds = 0.05f) {
+		module->params[param_id].setValue(1.f);
+		record(seconds);
+		module->params[param_id].setValue(0.f);
+	}
+
+	// a long press to audition, the hold before the 0.7 second mark is not recorded
+	void longPress(Module *module, int param_id) {
+		module->params[param_id].setValue(1.f);
+		patch.runSeconds(0.68f);
+		record(0.04f);
+		module->params[param_id].setValue(0.f);
+	}
+};
+
+static TestSignal audioSignal(int channels, float amplitude = 5.f) {
+	TestSignal signal;
+	signal.shape = TestSignal::AUDIO;
+	signal.channels = channels;
+	signal.amplitude = amplitude;
+	return signal;
+}
+
+static TestSignal gateSignal(float period, float width) {
+	TestSignal signal;
+	signal.shape = TestSignal::GATE;
+	signal.period = (int)(period * TEST_SAMPLE_RATE);
+	signal.width = (int)(width * TEST_SAMPLE_RATE);
+	signal.amplitude = 10.f;
+	return signal;
+}
+
+static TestSignal sweepSignal(float offset, float amplitude, float period) {
+	TestSignal signal;
+	signal.shape = TestSignal::TRIANGLE;
+	signal.offset = offset;
+	signal.amplitude = amplitude;
+	signal.period = (int)(period * TEST_SAMPLE_RATE);
+	return signal;
+}
+
+static void setParam(Module *module, const std::string &name, float value, int nth = 0) {
+	module->params[findParam(module, name, nth)].setValue(value);
+}
+
+// an Enter Bus making a bus chain, each bus from its own channels of the test audio
+static Module *addBusMaker(TestPatch &patch) {
+	Module *enter = patch.add("EnterBus");
+	const char *inputs[6] = {"Blue left", "Blue right", "Orange left", "Orange right", "Red left", "Red right"};
+	for (int i = 0; i < 6; i++) {
+		TestSignal signal = audioSignal(1);
+		signal.phase = 100 * i;
+		patch.feed(signal, enter, findInput(enter, inputs[i]));
+	}
+	return enter;
+}
+
+// stereo in, fades with the button, a pan move, and post fader sends turned off
+static std::vector<float> renderGigBus() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *gig = patch.add("GigBus");
+	patch.feed(audioSignal(1), gig, findInput(gig, "Left, mono, or poly"));
+	TestSignal right = audioSignal(1);
+	right.phase = 300;
+	patch.feed(right, gig, findInput(gig, "Right"));
+	setParam(gig, "Post red level send to blue stereo bus", 0.5f);
+	setParam(gig, "Post red level send to orange stereo bus", 0.25f);
+	setParam(gig, "Master level to red stereo bus", 0.8f);
+	render.probe(gig, findOutput(gig, "Bus chain"), BUS_CHANNELS);
+
+	int on = findParam(gig, "Input on");
+	render.record(0.04f);
+	render.press(gig, on);   // fades out
+	render.record(0.04f);
+	setParam(gig, "Pan", -0.8f);
+	render.press(gig, on);   // fades in, panned left
+	render.record(0.04f);
+	setParam(gig, "Master level to red stereo bus", 0.3f);   // sends follow the red level
+	render.record(0.04f);
+	setModuleData(gig, "post_fades", json_integer(0));   // and no longer do
+	render.record(0.04f);
+	return render.values;
+}
+
+// poly in, toggled by on cv gates through slow fades
+static std::vector<float> renderMiniBus() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *mini = patch.add("MiniBus");
+	setModuleData(mini, "fade_in", json_real(60.f));
+	setModuleData(mini, "fade_out", json_real(90.f));
+	patch.feed(audioSignal(4), mini, findInput(mini, "Mono or poly"));
+	patch.feed(gateSignal(0.1f, 0.005f), mini, findInput(mini, "On CV"));
+	setParam(mini, "Level to blue bus", 0.7f);
+	render.probe(mini, findOutput(mini, "Bus chain"), BUS_CHANNELS);
+	render.record(0.3f);
+	return render.values;
+}
+
+// pan cv through the attenuator, level cv, and the blue send post fader from its button
+static std::vector<float> renderSchoolBus() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *school = patch.add("SchoolBus");
+	patch.feed(audioSignal(1), school, findInput(school, "Left, mono, or poly"));
+	TestSignal right = audioSignal(1);
+	right.phase = 300;
+	patch.feed(right, school, findInput(school, "Right"));
+	patch.feed(sweepSignal(0.f, 5.f, 0.15f), school, findInput(school, "Pan CV (-5.0 to 5.0)"));
+	patch.feed(sweepSignal(5.f, 5.f, 0.1f), school, findInput(school, "Orange level CV"));
+	setParam(school, "Pan attenuator", 0.8f);
+	setParam(school, "Level to blue stereo bus", 0.6f);
+	setParam(school, "Level to orange stereo bus", 0.9f);
+	render.probe(school, findOutput(school, "Bus chain"), BUS_CHANNELS);
+
+	render.record(0.05f);
+	render.press(school, findParam(school, "Post red fader send", 0));   // blue send post fader
+	setParam(school, "Level to red stereo bus", 0.2f);
+	render.record(0.08f);
+	render.press(school, findParam(school, "Input on"));
+	render.record(0.05f);
+	return render.values;
+}
+
+// poly channels following the first channel's pan cv history, then the spread without cv, and the orange send post fader
+static std::vector<float> renderMetroFollowPan() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *metro = patch.add("MetroCityBus");
+	patch.feed(audioSignal(4), metro, findInput(metro, "Poly"));
+	patch.feed(sweepSignal(0.f, 5.f, 0.2f), metro, findInput(metro, "Pan poly follow CV (-5.0 to 5.0)"));
+	engine::Cable *pan_cable = patch.cables.back();
+	setParam(metro, "Pan attenuator", 1.f);
+	setParam(metro, "Polyphonic stereo spread", 0.1f);   // each channel a tenth of a second behind the one before
+	setParam(metro, "Level to orange stereo bus", 0.7f);
+	render.probe(metro, findOutput(metro, "Bus chain"), BUS_CHANNELS);
+
+	render.record(0.4f);
+	render.press(metro, findParam(metro, "Post red fader send", 1));   // orange send post fader
+	setParam(metro, "Level to red stereo bus", 0.5f);
+	render.record(0.05f);
+
+	// pulling the cv out spreads the channels from the knob instead
+	patch.engine->removeCable(pan_cable);
+	setParam(metro, "Polyphonic stereo spread", -0.6f);
+	render.record(0.1f);
+	return render.values;
+}
+
+// strips mono, stereo and poly, one turned off, then one auditioned and released
+static std::vector<float> renderBusTerminal() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *terminal = patch.add("BusTerminal");
+	patch.feed(audioSignal(1), terminal, findInput(terminal, "Strip 1 left, mono, or poly"));
+	patch.feed(audioSignal(1, 3.f), terminal, findInput(terminal, "Strip 2 left, mono, or poly"));
+	TestSignal right = audioSignal(1, 3.f);
+	right.phase = 300;
+	patch.feed(right, terminal, findInput(terminal, "Strip 2 right"));
+	patch.feed(audioSignal(3, 2.f), terminal, findInput(terminal, "Strip 3 left, mono, or poly"));
+	setParam(terminal, "Strip 1 pan", 0.5f);
+	setParam(terminal, "Strip 2 pan", -0.3f);
+	setParam(terminal, "Strip 1 post red level send to blue stereo bus", 0.5f);
+	setParam(terminal, "Strip 3 post red level send to orange stereo bus", 0.8f);
+	render.probe(terminal, findOutput(terminal, "Bus chain"), BUS_CHANNELS);
+
+	render.record(0.04f);
+	render.press(terminal, findParam(terminal, "Strip 1 on"));
+	render.record(0.04f);
+	render.longPress(terminal, findParam(terminal, "Strip 3 on"));   // strip 3 alone
+	render.record(0.04f);
+	render.press(terminal, findParam(terminal, "Strip 3 on"));   // a short press ends the audition
+	render.record(0.04f);
+	return render.values;
+}
+
+// two Gig Bus modules on one chain in the same audition group, the downstream one auditioned mutes the upstream one
+static std::vector<float> renderAuditions() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *first = patch.add("GigBus");
+	Module *second = patch.add("GigBus");
+	patch.feed(audioSignal(1), first, findInput(first, "Left, mono, or poly"));
+	patch.feed(audioSignal(2, 2.f), second, findInput(second, "Left, mono, or poly"));
+	patch.connect(first, findOutput(first, "Bus chain"), second, findInput(second, "Bus chain"));
+	render.probe(second, findOutput(second, "Bus chain"), BUS_CHANNELS);
+
+	int second_on = findParam(second, "Input on");
+	render.record(0.03f);
+	render.press(second, second_on);   // off before the audition, on while auditioned, off again after
+	render.longPress(second, second_on);
+	render.record(0.04f);
+	render.longPress(first, findParam(first, "Input on"));   // joins the audition
+	render.record(0.04f);
+	render.press(first, findParam(first, "Input on"));   // ends it for both
+	render.record(0.04f);
+	return render.values;
+}
+
+// bus chain in, aux in, bus chain on to the stereo outputs through fades, level cv and the limiter
+static std::vector<float> renderBusDepot() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *enter = addBusMaker(patch);
+	Module *depot = patch.add("BusDepot");
+	patch.connect(enter, findOutput(enter, "Bus chain"), depot, findInput(depot, "Bus chain"));
+	patch.feed(audioSignal(2, 2.f), depot, findInput(depot, "Left, mono, or poly"));
+	patch.feed(sweepSignal(7.f, 3.f, 0.1f), depot, findInput(depot, "Level CV"));
+	setParam(depot, "Fade out automation in milliseconds", 80.f);
+	setParam(depot, "Fade in automation in milliseconds", 40.f);
+	setModuleData(depot, "output_limiter", json_integer(1));
+	render.probe(depot, findOutput(depot, "Mixed left"), 1);
+	render.probe(depot, findOutput(depot, "Mixed right"), 1);
+	render.probe(depot, findOutput(depot, "Bus chain"), BUS_CHANNELS);
+
+	int on = findParam(depot, "Output on");
+	render.record(0.05f);
+	render.press(depot, on);
+	render.record(0.08f);
+	render.press(depot, on);
+	render.record(0.06f);
+	return render.values;
+}
+
+// sends straight back to the returns, delayed by whole and fractional samples, with a bus turned off and one auditioned
+// a Road lining it up with another chain asks for the chain latency, so its bus chain carries the latency and tag channels
+static std::vector<float> renderBusRoute() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *enter = addBusMaker(patch);
+	Module *route = patch.add("BusRoute");
+	Module *road = patch.add("Road");
+	patch.connect(enter, findOutput(enter, "Bus chain"), route, findInput(route, "Bus chain"));
+	patch.connect(route, findOutput(route, "Bus chain"), road, findInput(road, "Bus chain 1"));
+	patch.connect(enter, findOutput(enter, "Bus chain"), road, findInput(road, "Bus chain 2"));   // a Road lines up 2 chains or more
+	for (const char *bus : {"Blue", "Orange", "Red"}) {
+		for (const char *side : {"left", "right"}) {
+			patch.connect(route, findOutput(route, string::f("%s send %s", bus, side)), route, findInput(route, string::f("%s return %s", bus, side)));
+		}
+	}
+	setParam(route, "Delay on blue bus", 100.f);
+	setParam(route, "Delay on orange bus", 37.5f);
+	patch.runSeconds(0.6f);   // the Road finds the chains on its 30th ui frame
+	DSP_CHECK(route->outputs[findOutput(route, "Bus chain")].getChannels() == BUS_LATENCY_CHANNELS, "Bus Route carries %d channels to a Road, not %d",
+		route->outputs[findOutput(route, "Bus chain")].getChannels(), BUS_LATENCY_CHANNELS);
+	render.probe(route, findOutput(route, "Blue send left"), 1);
+	render.probe(route, findOutput(route, "Mixed left"), 1);
+	render.probe(route, findOutput(route, "Mixed right"), 1);
+	render.probe(route, findOutput(route, "Bus chain"), BUS_LATENCY_CHANNELS);
+
+	render.record(0.03f);
+	render.press(route, findParam(route, "Orange bus on (hold to audition)"));
+	render.record(0.03f);
+	setParam(route, "Delay on red bus", 220.f);   // the chain latency grows with the longest delay
+	render.record(0.03f);
+	render.longPress(route, findParam(route, "Blue bus on (hold to audition)"));
+	render.record(0.03f);
+	return render.values;
+}
+
+// two chains into a Road, one delayed by a Bus Route, lined up by delaying the other, then a chain turned off and one auditioned
+static std::vector<float> renderRoad() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *road = patch.add("Road");
+	Module *first = addBusMaker(patch);
+	Module *route = patch.add("BusRoute");
+	Module *second = patch.add("GigBus");
+	patch.connect(first, findOutput(first, "Bus chain"), route, findInput(route, "Bus chain"));
+	setParam(route, "Delay on red bus", 150.f);
+	patch.connect(route, findOutput(route, "Bus chain"), road, findInput(road, "Bus chain 1"));
+	patch.feed(audioSignal(1), second, findInput(second, "Left, mono, or poly"));
+	patch.connect(second, findOutput(second, "Bus chain"), road, findInput(road, "Bus chain 2"));
+	patch.runSeconds(0.6f);
+	DSP_CHECK(second->outputs[findOutput(second, "Bus chain")].getChannels() == BUS_LATENCY_CHANNELS, "a chain into a lining up Road carries %d channels, not %d",
+		second->outputs[findOutput(second, "Bus chain")].getChannels(), BUS_LATENCY_CHANNELS);
+	render.probe(road, findOutput(road, "Mixed bus chain"), BUS_LATENCY_CHANNELS);
+
+	render.record(0.04f);
+	render.press(road, findParam(road, "BUS IN 1 on"));
+	render.record(0.04f);
+	render.longPress(road, findParam(road, "BUS IN 1 on"));   // the chain just turned off, alone
+	render.record(0.04f);
+
+	// without compensation the chains are no longer lined up, and the chains drop to 6 channels
+	setModuleData(road, "latency_compensation", json_integer(0));
+	patch.runSeconds(0.6f);
+	DSP_CHECK(second->outputs[findOutput(second, "Bus chain")].getChannels() == BUS_CHANNELS, "a chain into a Road without compensation carries %d channels, not %d",
+		second->outputs[findOutput(second, "Bus chain")].getChannels(), BUS_CHANNELS);
+	render.record(0.04f);
+	return render.values;
+}
+
+// the wide bus from Enter Bus through a Gig Bus on buses 3 to 5 and out of Exit Bus, with the Enter Bus levels moving
+static std::vector<float> renderWideBus() {
+	TestPatch patch;
+	GoldenRender render(patch);
+	Module *enter = addBusMaker(patch);
+	Module *gig = patch.add("GigBus");
+	Module *exit = patch.add("ExitBus");
+	patch.connect(enter, findOutput(enter, "Bus chain"), gig, findInput(gig, "Bus chain"));
+	patch.connect(gig, findOutput(gig, "Bus chain"), exit, findInput(exit, "Bus chain"));
+	patch.feed(audioSignal(1, 2.f), gig, findInput(gig, "Left, mono, or poly"));
+	setParam(gig, "Post red level send to blue stereo bus", 0.5f);
+	patch.source->addParamLane(enter, findParam(enter, "Blue stereo input level"), sweepSignal(0.5f, 0.5f, 0.05f));
+	for (Module *module : {enter, gig, exit}) setModuleData(module, "wide_bus", json_integer(1));
+	setModuleData(gig, "wide_bus", json_integer(3));
+	patch.run(4);   // a sample per cable down the chain
+	DSP_CHECK(gig->outputs[findOutput(gig, "Bus chain")].getChannels() == WIDE_BUS_CHANNELS, "the wide bus has %d channels, not %d",
+		gig->outputs[findOutput(gig, "Bus chain")].getChannels(), WIDE_BUS_CHANNELS);
+	render.probe(exit, findOutput(exit, "Bus chain"), WIDE_BUS_CHANNELS);
+	render.probe(exit, findOutput(exit, "Blue left"), 1);
+	render.probe(exit, findOutput(exit, "Red right"), 1);
+
+	render.record(0.1f);
+	return render.values;
+}
+
+int main(int argc, char **argv) {
+	golden_updating = (argc > 1 && std::strcmp(argv[1], "--update") == 0);
+	initTestPlugin();
+	compareGolden("module_gig_bus", renderGigBus());
+	compareGolden("module_mini_bus", renderMiniBus());
+	compareGolden("module_school_bus", renderSchoolBus());
+	compareGolden("module_metro_follow_pan", renderMetroFollowPan());
+	compareGolden("module_bus_terminal", renderBusTerminal());
+	compareGolden("module_auditions", renderAuditions());
+	compareGolden("module_bus_depot", renderBusDepot());
+	compareGolden("module_bus_route", renderBusRoute());
+	compareGolden("module_road", renderRoad());
+	compareGolden("module_wide_bus", renderWideBus());
+	destroy();
+	return dspResult(golden_updating ? "test_modules, references written" : "test_modules");
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// repeatable noise from -1 to 1 without the standard library generators, which differ between platforms
+struct TestNoise {
+	uint32_t state = 22222;
+	float next() {
+		state = (state * 1664525u) + 1013904223u;
+		return ((float)(state >> 8) / 8388608.f) - 1.f;
+	}
+};
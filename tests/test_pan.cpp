@@ -0,0 +1,72 @@
+#include "gtgDSP.hpp"
+#include "dsp_test.hpp"
+
+// panLevels() against the sin() pan law it replaced, and the other laws against their exact shapes
+// positions run over the -2 to 2 reach of pan cv, so the roll back past hard left and right is covered too
+
+static void exactLevels(int law, double position, double &left, double &right) {
+	double pan_angle = (position + 1.0) * 0.5;
+	double clamped = std::fmin(std::fmax(pan_angle, 0.0), 1.0);
+	switch (law) {
+	default:
+	case PAN_LAW_3DB:   // the original law, sin() in double precision
+		left = std::sin((1.0 - pan_angle) * M_PI_2) * M_SQRT2;
+		right = std::sin(pan_angle * M_PI_2) * M_SQRT2;
+		break;
+	case PAN_LAW_4_5DB:
+		left = std::sqrt((1.0 - clamped) * std::sin((1.0 - clamped) * M_PI_2)) * std::pow(2.0, 0.75);
+		right = std::sqrt(clamped * std::sin(clamped * M_PI_2)) * std::pow(2.0, 0.75);
+		break;
+	case PAN_LAW_6DB:
+		left = (1.0 - clamped) * 2.0;
+		right = clamped * 2.0;
+		break;
+	case PAN_LAW_LINEAR:
+		left = std::fmin((1.0 - clamped) * 2.0, 1.0);
+		right = std::fmin(clamped * 2.0, 1.0);
+		break;
+	}
+}
+
+int main() {
+	const int steps = 400000;
+	const double tolerances[NUM_PAN_LAWS] = {2e-6, 2e-6, 1e-6, 1e-6};
+	const char *law_names[NUM_PAN_LAWS] = {"-3 dB", "-4.5 dB", "-6 dB", "linear"};
+
+	for (int law = 0; law < NUM_PAN_LAWS; law++) {
+		double max_error = 0.0;
+		double worst_position = 0.0;
+		for (int i = 0; i <= steps; i++) {
+			float position = -2.f + (4.f * i / steps);
+			float left, right;
+			double exact_left, exact_right;
+			panLevels(law, position, left, right);
+			exactLevels(law, position, exact_left, exact_right);
+			double error = std::max(std::fabs(left - exact_left), std::fabs(right - exact_right));
+			if (error > max_error) {
+				max_error = error;
+				worst_position = position;
+			}
+		}
+		std::printf("%s pan law, max error %.3g at %.4f\n", law_names[law], max_error, worst_position);
+		DSP_CHECK(max_error < tolerances[law], "%s pan law is %.3g from exact at %.4f", law_names[law], max_error, worst_position);
+
+		// every law keeps center at unity and mirrors left and right
+		float left, right, mirror_left, mirror_right;
+		panLevels(law, 0.f, left, right);
+		DSP_CHECK(std::fabs(left - 1.f) < 1e-6f && std::fabs(right - 1.f) < 1e-6f, "%s pan law center is %g, %g", law_names[law], left, right);
+		panLevels(law, 0.37f, left, right);
+		panLevels(law, -0.37f, mirror_left, mirror_right);
+		DSP_CHECK(std::fabs(left - mirror_right) < 1e-6f && std::fabs(right - mirror_left) < 1e-6f, "%s pan law is not symmetric", law_names[law]);
+	}
+
+	// ConstantPan gives the same levels as panLevels()
+	ConstantPan pan;
+	pan.setLaw(PAN_LAW_4_5DB);
+	pan.setPan(-0.6f);
+	float left, right;
+	panLevels(PAN_LAW_4_5DB, -0.6f, left, right);
+	DSP_CHECK(pan.getLevel(0) == left && pan.getLevel(1) == right, "ConstantPan does not use panLevels()");
+
+	return dspResult("test_pan");
+}